@@ -14,8 +14,18 @@ SOURCES += \
     $$PWD/node.cpp \
     $$PWD/data.cpp \
     $$PWD/nodetree.cpp \
+    $$PWD/treesnapshot.cpp \
+    $$PWD/parallellayout.cpp \
+    $$PWD/layoutgeneration.cpp \
+    $$PWD/layoutworker.cpp \
+    $$PWD/tilecache.cpp \
     $$PWD/cmp_tree_dialog.cpp \
     $$PWD/receiverthread.cpp \
+    $$PWD/wirecapture.cpp \
+    $$PWD/traceloader.cpp \
+    $$PWD/tracefile.cpp \
+    $$PWD/nodebatch.cpp \
+    $$PWD/nodeinfo.cpp \
     $$PWD/treebuilder.cpp \
     $$PWD/readingQueue.cpp \
     $$PWD/treecomparison.cpp \
@@ -49,7 +59,14 @@ SOURCES += \
     $$PWD/nogoodtable.cpp \
     $$PWD/cpprofiler/utils/string_utils.cpp \
     $$PWD/executiontree.cpp \
-    $$PWD/cpprofiler/utils/path_utils.cpp
+    $$PWD/cpprofiler/utils/path_utils.cpp \
+    $$PWD/cpprofiler/utils/spsc_queue.cpp \
+    $$PWD/cpprofiler/utils/uid_map.cpp \
+    $$PWD/cpprofiler/utils/receive_buffer.cpp \
+    $$PWD/cpprofiler/utils/symbol_index.cpp \
+    $$PWD/cpprofiler/utils/label_dictionary.cpp \
+    $$PWD/cpprofiler/utils/spill_file.cpp \
+    $$PWD/cpprofiler/utils/process_memory.cpp
 
 HEADERS  += \
     $$PWD/globalhelper.hh \
@@ -77,10 +94,21 @@ HEADERS  += \
     $$PWD/nodevisitor.hpp \
     $$PWD/zoomToFitIcon.hpp \
     $$PWD/data.hh \
+    $$PWD/nodestore.hh \
     $$PWD/nodetree.hh \
+    $$PWD/treesnapshot.hh \
+    $$PWD/parallellayout.hh \
+    $$PWD/layoutgeneration.hh \
+    $$PWD/layoutworker.hh \
+    $$PWD/tilecache.hh \
     $$PWD/highlight_nodes_dialog.hpp \
     $$PWD/cmp_tree_dialog.hh \
     $$PWD/receiverthread.hh \
+    $$PWD/wirecapture.hh \
+    $$PWD/traceloader.hh \
+    $$PWD/tracefile.hh \
+    $$PWD/nodebatch.hh \
+    $$PWD/nodeinfo.hh \
     $$PWD/treebuilder.hh \
     $$PWD/readingQueue.hh \
     $$PWD/treecomparison.hh \
@@ -120,6 +148,16 @@ HEADERS  += \
     $$PWD/nogood_representation.hh \
     $$PWD/executiontree.hh \
     $$PWD/cpprofiler/universal.hh \
-    $$PWD/cpprofiler/utils/path_utils.hh
+    $$PWD/cpprofiler/utils/path_utils.hh \
+    $$PWD/cpprofiler/utils/spsc_queue.hh \
+    $$PWD/cpprofiler/utils/bits.hh \
+    $$PWD/cpprofiler/utils/segmented_vector.hh \
+    $$PWD/cpprofiler/utils/string_pool.hh \
+    $$PWD/cpprofiler/utils/uid_map.hh \
+    $$PWD/cpprofiler/utils/receive_buffer.hh \
+    $$PWD/cpprofiler/utils/symbol_index.hh \
+    $$PWD/cpprofiler/utils/label_dictionary.hh \
+    $$PWD/cpprofiler/utils/spill_file.hh \
+    $$PWD/cpprofiler/utils/process_memory.hh
 
 FORMS    +=
@@ -19,78 +19,52 @@
  */
 
 #include "backjumps.hh"
-#include "nodevisitor.hh"
+#include "nodetree.hh"
+#include "treesnapshot.hh"
 #include "visualnode.hh"
 
-#include <iostream>
+#include <algorithm>
 
 /// TODO(maxim): fix backjump histogram going out of vertical boundary when
 /// zooming in
 
 using namespace cpprofiler::analysis;
-using std::cout;
 
 Backjumps::Backjumps() {}
 
-const BackjumpData Backjumps::findBackjumps(VisualNode* root,
-                                            const NodeAllocator& na) {
-  BackjumpData bj_data;
-  std::vector<BackjumpItem2> backjumps; // unused
-
-  BackjumpsCursor bj_cursor(root, na, bj_data, backjumps, false);
-  PreorderNodeVisitor<BackjumpsCursor> visitor(bj_cursor);
-
-  visitor.run();
-
-  return bj_data;
-}
-
-std::vector<BackjumpItem2> Backjumps::findBackjumps2(VisualNode* root, const NodeAllocator& na) {
-
-  BackjumpData bj_data; /// unused
-  std::vector<BackjumpItem2> backjumps;
-
-  BackjumpsCursor bj_cursor(root, na, bj_data, backjumps, true);
-  PreorderNodeVisitor<BackjumpsCursor> visitor(bj_cursor);
-
-  visitor.run();
-
-  return backjumps;
-}
-
-BackjumpsCursor::BackjumpsCursor(VisualNode* root, const NodeAllocator& na,
-                                 BackjumpData& bj_data, std::vector<BackjumpItem2>& bjs,
-                                 bool hack)
-    : NodeCursor(root, na), bj_data(bj_data), backjumps{bjs}, hack_mode{hack} {}
-
-void BackjumpsCursor::moveDownwards() {
-  ++cur_level;
-  NodeCursor::moveDownwards();
-}
-
-void BackjumpsCursor::moveUpwards() {
-  --cur_level;
-  NodeCursor::moveUpwards();
-}
-
-void BackjumpsCursor::processCurrentNode() {
-  auto n = node();
-  auto status = n->getStatus();
-
-  if (status == NodeStatus::SKIPPED) {
-    ++skipped_count;
-
-    if (!is_backjumping) {
-      /// Backjump starts (form the last failure node)
-      is_backjumping = true;
-      bj_item.level_from = last_failure_level;
-      bj_data.max_from = std::max(bj_data.max_from, bj_item.level_from);
-      // cout << "Backjump from level: " << last_failure_level;
-      node_from = n;
-    }
-
-  } else {
-    if (is_backjumping) {
+/// A backjump starts at the first skipped node after a failure (or a
+/// solution) and ends at the next node that is not skipped; `bj_data`
+/// is keyed by the gid of the failure node
+static void scanBackjumps(NodeTree& nt, BackjumpData& bj_data,
+                          std::vector<BackjumpItem2>& backjumps) {
+
+  const auto& na = nt.getNA();
+  const auto snapshot = nt.snapshot();
+  const auto& s = *snapshot;
+
+  int last_failure_level = 0;  /// can be a solution as well (for the purpose of bj)
+  bool is_backjumping = false;
+  int skipped_count = 0;
+  int bj_gid = 0;  /// gid of a node the current backjump started from
+  BackjumpItem bj_item;
+  VisualNode* node_from = nullptr;
+
+  for (int i = 0; i < s.size(); ++i) {
+    const int cur_level = s.depth(i) - 1;
+    const auto status = s.status(i);
+
+    if (status == NodeStatus::SKIPPED) {
+      ++skipped_count;
+
+      if (!is_backjumping) {
+        /// Backjump starts (form the last failure node)
+        is_backjumping = true;
+        bj_item.level_from = last_failure_level;
+        bj_data.max_from = std::max(bj_data.max_from, bj_item.level_from);
+        node_from = na[s.gid(i)];
+      }
+
+    } else if (is_backjumping) {
       is_backjumping = false;
       /// One level above a non-skipped node (branch node)
       bj_item.level_to = cur_level - 1;
@@ -103,13 +77,31 @@ void BackjumpsCursor::processCurrentNode() {
       bj_data.bj_map[bj_gid] = bj_item;
       skipped_count = 0;
 
-      backjumps.push_back({node_from, n->getParent(na)});
+      backjumps.push_back({node_from, na[s.gid(s.parent(i))]});
+    }
 
+    if (status == NodeStatus::FAILED || status == NodeStatus::SOLVED) {
+      last_failure_level = cur_level;
+      bj_gid = s.gid(i);  /// this node can potentially initiate a backjump
     }
   }
+}
 
-  if (status == NodeStatus::FAILED || status == NodeStatus::SOLVED) {
-    last_failure_level = cur_level;
-    bj_gid = n->getIndex(na);  /// this node can potentially initiate a backjump
-  }
-}
\ No newline at end of file
+const BackjumpData Backjumps::findBackjumps(NodeTree& nt) {
+  BackjumpData bj_data;
+  std::vector<BackjumpItem2> backjumps; // unused
+
+  scanBackjumps(nt, bj_data, backjumps);
+
+  return bj_data;
+}
+
+std::vector<BackjumpItem2> Backjumps::findBackjumps2(NodeTree& nt) {
+
+  BackjumpData bj_data; /// unused
+  std::vector<BackjumpItem2> backjumps;
+
+  scanBackjumps(nt, bj_data, backjumps);
+
+  return backjumps;
+}
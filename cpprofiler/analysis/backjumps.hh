@@ -21,8 +21,10 @@
 #ifndef CPPROFILER_ANALYSIS_BACKJUMPS_HH
 #define CPPROFILER_ANALYSIS_BACKJUMPS_HH
 
-#include "nodecursor.hh"
+#include <unordered_map>
+#include <vector>
 
+class NodeTree;
 class VisualNode;
 
 namespace cpprofiler {
@@ -40,54 +42,22 @@ struct BackjumpItem2 {
 };
 
 struct BackjumpData {
-  std::unordered_map<uint, BackjumpItem> bj_map;
+  std::unordered_map<unsigned, BackjumpItem> bj_map;
   int max_from = 0;
   int max_to = 0;
   int max_skipped = 0;
 };
 
+/// Backjumps are found in a single preorder scan of the tree's snapshot
+/// (see `NodeTree::snapshot`)
 class Backjumps {
  public:
   Backjumps();
 
-  const BackjumpData findBackjumps(VisualNode* root, const NodeAllocator& na);
-  static std::vector<BackjumpItem2> findBackjumps2(VisualNode* root, const NodeAllocator& na);
-};
-
-/// A cursor that prints backjumps
-class BackjumpsCursor : public NodeCursor {
- private:
-  int cur_level = 0;  /// depth
-  int last_failure_level =
-      0;  /// can be a solution as well (for the purpose of bj)
-  bool is_backjumping =
-      false;  /// whether the cursor on a backjumped part of the tree
-  int skipped_count = 0;  /// counts how many skipped nodes for every bj
-  int bj_gid = 0;         /// gid of a node the current backjump started from
-  /// temp bj_item to be copied into the map after having been constructed
-  BackjumpItem bj_item;
-
-  /// contains a map from gid to backjump item
-  BackjumpData& bj_data;
-
-
-  VisualNode* node_from;
-  std::vector<BackjumpItem2>& backjumps;
-
-
-
-  bool hack_mode;
-
- public:
-  BackjumpsCursor(VisualNode* theNode, const NodeAllocator& na,
-                  BackjumpData& bj_data, std::vector<BackjumpItem2>& bjs,
-                  bool hack = false);
-
-  void processCurrentNode();
-  void moveDownwards();
-  void moveUpwards();
+  const BackjumpData findBackjumps(NodeTree& nt);
+  static std::vector<BackjumpItem2> findBackjumps2(NodeTree& nt);
 };
 }
 }
 
-#endif
\ No newline at end of file
+#endif
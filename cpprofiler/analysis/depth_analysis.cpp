@@ -1,5 +1,6 @@
 #include "depth_analysis.hh"
 #include "nodetree.hh"
+#include "treesnapshot.hh"
 
 #include <QDebug>
 
@@ -8,29 +9,26 @@ using namespace cpprofiler::analysis;
 DepthAnalysis::DepthAnalysis(NodeTree& nt) : _nt(nt), _na(nt.getNA()) {}
 
 std::vector<Direction> DepthAnalysis::collectDepthData() {
-  SpaceNode* root = _na[0];
+  const auto snapshot = _nt.snapshot();
   std::vector<Direction> depth_data;
+  depth_data.reserve(2 * snapshot->size());
 
-  traverse(depth_data, root);
+  auto enter = [&depth_data](int i) {
+    if (i > 0) depth_data.push_back(Direction::DOWN);
+  };
 
-  return depth_data;
-}
+  auto leave = [&depth_data, &snapshot](int i) {
+    if (snapshot->status(i) == NodeStatus::SOLVED) {
+      depth_data.push_back(Direction::SOLUTION);
+    }
 
-void DepthAnalysis::traverse(std::vector<Direction>& depth_data,
-                             const SpaceNode* const n) {
-  for (unsigned i = 0; i < n->getNumberOfChildren(); i++) {
-    depth_data.push_back(Direction::DOWN);
-    traverse(depth_data, n->getChild(_na, i));
-  }
+    /// slightly different behaviour from the root node
+    if (i > 0) depth_data.push_back(Direction::UP);
+  };
 
-  if (n->getStatus() == NodeStatus::SOLVED) {
-    depth_data.push_back(Direction::SOLUTION);
-  }
+  snapshot->traverse(0, enter, leave);
 
-  /// slightly different behaviour from the root node
-  if (n->getParent() >= 0) {
-    depth_data.push_back(Direction::UP);
-  }
+  return depth_data;
 }
 
 // #ifdef MAXIM_DEBUG
@@ -31,8 +31,6 @@ class DepthAnalysis : public QObject {
   /// returns a vector of 'UPs' and 'DOWNs'
   std::vector<Direction> collectDepthData();
 
-  void traverse(std::vector<Direction>& depth_data, const SpaceNode* const n);
-
  public:
   explicit DepthAnalysis(NodeTree& nt);
 
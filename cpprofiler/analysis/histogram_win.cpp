@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <map>
+#include <unordered_map>
 
 using std::vector;
 using std::string;
@@ -85,19 +86,20 @@ void HistogramWindow::highlightSubtrees(VisualNode* node) {
 }
 
 
-static std::vector<std::string> pathLabels(const VisualNode* const node,
-                                    const Execution& ex) {
+/// Label ids along the path from `node` to the root
+static std::vector<int32_t> pathLabels(const VisualNode* const node,
+                                       const Execution& ex) {
 
   auto& na = ex.nodeTree().getNA();
   auto* cur_node = node;
 
-  std::vector<std::string> labels;
+  std::vector<int32_t> labels;
 
   do {
     /// NOTE(maxim): for root nodes labels will be empty;
     /// they will be ignored (a bit of a hack)
-    auto&& label = ex.getLabel(*cur_node);
-    if (label != "") {
+    auto label = ex.getLabelId(*cur_node);
+    if (label != 0) {
       labels.push_back(label);
     }
   } while ((cur_node = cur_node->getParent(na)));
@@ -105,6 +107,17 @@ static std::vector<std::string> pathLabels(const VisualNode* const node,
   return labels;
 }
 
+/// Text of the labels, in alphabetical order
+static vector<string> labelTexts(const Execution& ex, const vector<int32_t>& ids) {
+  vector<string> res;
+  res.reserve(ids.size());
+  for (auto id : ids) {
+    res.push_back(ex.getLabelText(id));
+  }
+  std::sort(begin(res), end(res));
+  return res;
+}
+
 template<typename T>
 static vector<T> set_intersect(vector<T> v1, vector<T> v2) {
 
@@ -147,16 +160,16 @@ VecPair<string> getLabelDiff(const Execution& ex, const VisualNode* n1,
   auto diff = set_symmetric_diff(path_1, path_2);
 
   /// unique labels in 1
-  vector<string> unique_1 = set_intersect(path_1, diff);
+  vector<string> unique_1 = labelTexts(ex, set_intersect(path_1, diff));
   /// unique labels in 2
-  vector<string> unique_2 = set_intersect(path_2, diff);
+  vector<string> unique_2 = labelTexts(ex, set_intersect(path_2, diff));
 
   return std::make_pair(std::move(unique_1), std::move(unique_2));
 }
 
 vector<string> getLabelDiff(const Execution& ex,
                                  const std::vector<VisualNode*>& vec) {
-  map<string, int> label_counts;
+  std::unordered_map<int32_t, int> label_counts;
 
   /// count all labels
   for (auto node : vec) {
@@ -169,7 +182,7 @@ vector<string> getLabelDiff(const Execution& ex,
   }
 
   /// keep if the count is less than the paths count
-  vector<string> result;
+  vector<int32_t> result;
 
   for (auto& pair : label_counts) {
     if (pair.second != (int)vec.size()) {
@@ -177,7 +190,7 @@ vector<string> getLabelDiff(const Execution& ex,
     }
   }
 
-  return result;
+  return labelTexts(ex, result);
 }
 
 void HistogramWindow::workoutLabelDiff(const SubtreeInfo* const si) {
@@ -12,6 +12,7 @@
 #include "nodetree.hh"
 #include "cpprofiler/utils/tree_utils.hh"
 #include "execution.hh"
+#include "cpprofiler/utils/label_dictionary.hh"
 #include "libs/perf_helper.hh"
 #include "similar_shape_algorithm.hh"
 
@@ -246,19 +247,9 @@ struct PosInGroups {
   int inner_idx; /// ?
 };
 
-std::string extractVar(const std::string& label) {
-
-      auto found = label.find_first_of("!=><?");
-
-      if (found != std::string::npos) {
-        return label.substr(0, found);
-      }
-      return label;
-}
-
 static GroupsOfNodes_t groupByLabels(Execution& ex, bool vars_only = false) {
 
-  using std::string;
+  const auto& labels = utils::LabelDictionary::global();
 
   auto& nt = ex.nodeTree();
 
@@ -272,13 +263,14 @@ static GroupsOfNodes_t groupByLabels(Execution& ex, bool vars_only = false) {
 
     /// Split vec based on labels
 
-    std::unordered_map<string, vector<VisualNode*>> label_map;
+    std::unordered_map<int32_t, vector<VisualNode*>> label_map;
 
     for (auto* n : vec) {
-      string l = ex.getLabel(*n);
+      int32_t l = ex.getLabelId(*n);
 
-      /// truncate l to a contain var name only if `vars_only`
-      if (vars_only) { l = extractVar(l); }
+      /// group by the variable only if `vars_only`
+      /// (label ids and variable ids are never mixed)
+      if (vars_only) { l = labels.decision(l).var; }
 
       label_map[l].push_back(n);
     }
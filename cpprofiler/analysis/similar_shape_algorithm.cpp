@@ -5,6 +5,7 @@
 
 #include "visualnode.hh"
 #include "nodetree.hh"
+#include "treesnapshot.hh"
 #include "cpprofiler/utils/tree_utils.hh"
 
 namespace cpprofiler {
@@ -18,33 +19,14 @@ struct ShapeI {
   int shape_size;
   int shape_height;
   VisualNode* node;
+  /// interned (see ShapeStore), so no copy is needed: it is
+  /// kept alive by the nodes that have it
   Shape* s;
   ShapeI(int sol0, VisualNode* node0)
-      : sol(sol0), node(node0), s(Shape::copy(node->getShape())) {
+      : sol(sol0), node(node0), s(node->getShape()) {
     shape_size = shapeSize(*s);
     shape_height = s->depth();
   }
-
-  ~ShapeI() { Shape::deallocate(s); }
-
-  ShapeI(const ShapeI& sh)
-      : sol(sh.sol),
-        shape_size(sh.shape_size),
-        shape_height(sh.shape_height),
-        node(sh.node),
-        s(Shape::copy(sh.s)) {}
-
-  ShapeI& operator=(const ShapeI& sh) {
-    if (this != &sh) {
-      Shape::deallocate(s);
-      s = Shape::copy(sh.s);
-      sol = sh.sol;
-      shape_size = sh.shape_size;
-      shape_height = sh.shape_height;
-      node = sh.node;
-    }
-    return *this;
-  }
 };
 
 /// less operator needed for the map
@@ -54,6 +36,9 @@ struct CompareShapes {
     // if (n1.sol > n2.sol) return false;
     // if (n1.sol < n2.sol) return true;
 
+    /// the same interned shape
+    if (n1.s == n2.s) return false;
+
     const Shape& s1 = *n1.s;
     const Shape& s2 = *n2.s;
 
@@ -92,52 +77,48 @@ static std::vector<ShapeInfo> toShapeVector(std::multiset<ShapeI, CompareShapes>
   return shapes;
 }
 
-/// Loop through all nodes and add them to the multimap
+/// Loop through all nodes (in postorder) and add them to the multimap
 static std::multiset<ShapeI, CompareShapes>
 collectShapes(NodeTree& nt) {
 
   auto& na = nt.getNA();
-  QHash<VisualNode*, int> nSols;
 
-  auto getNoOfSolutions = [&na, &nSols] (VisualNode* n) -> int {
-    int nSol = 0;
-    switch (n->getStatus()) {
+  auto root = nt.getRoot();
+
+  {
+    /// the canvas may be laying the tree out on its worker thread
+    QMutexLocker tree_lock(&nt.getTreeMutex());
+    QMutexLocker layout_lock(&nt.getLayoutMutex());
+    root->unhideAll(na);
+    root->layout(na);
+  }
+
+  const auto snapshot = nt.snapshot();
+  const auto& s = *snapshot;
+
+  /// number of solutions in the subtree, indexed by preorder;
+  /// a backwards scan sees every child before its parent
+  std::vector<int> nSols(s.size(), 0);
+
+  for (int i = s.size() - 1; i >= 0; --i) {
+    switch (s.status(i)) {
         case SOLVED:
-          nSol = 1;
-        break;
-        case FAILED:
-        case SKIPPED:
-        case UNDETERMINED:
-          nSol = 0;
+          nSols[i] = 1;
         break;
         case BRANCH:
-          nSol = 0;
-          for (int i=n->getNumberOfChildren(); i--;) {
-            nSol += nSols.value(n->getChild(na,i));
+          for (auto kid = s.childrenBegin(i); kid != s.childrenEnd(i); ++kid) {
+            nSols[i] += nSols[*kid];
           }
         break;
-        default: break;    /// To avoid compiler warnings
+        default: break;
     }
-
-    return nSol;
-  };
+  }
 
   std::multiset<ShapeI, CompareShapes> res;
 
-  auto action = [&res, &nSols, getNoOfSolutions](VisualNode* n) {
-
-    auto nSol = getNoOfSolutions(n);
-
-    nSols[n] = nSol;
-    res.insert(detail::ShapeI(nSol,n));
-  };
-
-  auto root = nt.getRoot();
-
-  root->unhideAll(na);
-  root->layout(na);
-
-  utils::applyToEachNodePO(nt, action);
+  s.forEachPostorder(0, [&](int i) {
+    res.insert(detail::ShapeI(nSols[i], na[s.gid(i)]));
+  });
 
   return res;
 }
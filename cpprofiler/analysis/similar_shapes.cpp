@@ -160,13 +160,19 @@ SimilarShapesWindow::~SimilarShapesWindow() = default;
 
 void highlightAllSubtrees(NodeTree& nt, std::vector<SubtreeInfo>& groups) {
 
-  utils::applyToEachNode(nt, [](VisualNode* n) {
+  auto& na = nt.getNA();
+
+  /// outlines are only drawn again where the tree is dirty
+  utils::applyToEachNode(nt, [&na](VisualNode* n) {
+    if (!n->isHighlighted()) return;
     n->setHighlighted(false);
+    n->dirtyUp(na);
   });
 
   for (auto& group : groups) {
     for (auto node : group.nodes) {
       node->setHighlighted(true);
+      node->dirtyUp(na);
     }
   }
 
@@ -613,8 +619,12 @@ void SimilarShapesWindow::drawHistogram() {
   auto& na = node_tree.getNA();
   VisualNode* root = node_tree.getRoot();
 
-  root->unhideAll(na);
-  root->layout(na);
+  {
+    QMutexLocker tree_lock(&node_tree.getTreeMutex());
+    QMutexLocker layout_lock(&node_tree.getLayoutMutex());
+    root->unhideAll(na);
+    root->layout(na);
+  }
 
   for (const auto& group : groups_shown) {
     const int count = group.size();
@@ -182,8 +182,12 @@ void SubtreeCompWindow::drawComparisonHistogram() {
   auto& na = node_tree.getNA();
   VisualNode* root = node_tree.getRoot();
 
-  root->unhideAll(na);
-  root->layout(na);
+  {
+    QMutexLocker tree_lock(&node_tree.getTreeMutex());
+    QMutexLocker layout_lock(&node_tree.getLayoutMutex());
+    root->unhideAll(na);
+    root->layout(na);
+  }
 
   std::vector<SubtreeInfo2> vec;
   vec.reserve(m_identicalGroups.size());
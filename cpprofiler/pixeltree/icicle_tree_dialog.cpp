@@ -21,13 +21,16 @@
 #include "icicle_tree_dialog.hh"
 #include <QAbstractScrollArea>
 #include <QComboBox>
+#include <algorithm>
 #include <climits>
 #include <functional>
 #include <set>
+#include <unordered_map>
 
 #include "treecanvas.hh"
 #include "execution.hh"
 #include "nodetree.hh"
+#include "treesnapshot.hh"
 #include "globalhelper.hh"
 #include "spacenode.hh"
 #include "data.hh"
@@ -179,27 +182,34 @@ bool IcicleTreeCanvas::compressInit(VisualNode& root, int idx, int absX) {
   return hasSolved | (statistic[idx].ns == SOLVED);
 }
 
-static std::map<std::string, QRgb> initVariableMap(const TreeCanvas& tc, const NodeTree& nt) {
+/// Variable id of the decision at `gid` (0, the empty name, if not a decision)
+static int32_t decisionVar(const Data& data, int gid) {
+  auto entry = data.getEntry(gid);
+  if (!entry) return 0;
+  const auto& decision = entry.decision();
+  return decision.isDecision() ? decision.var : 0;
+}
+
+static std::unordered_map<int32_t, QRgb> initVariableMap(const TreeCanvas& tc, const NodeTree& nt) {
 
-  using std::string; using std::set; using std::map; using std::vector;
+  using std::set; using std::vector;
 
-  map<string, QRgb> var2color;
+  std::unordered_map<int32_t, QRgb> var2color;
 
   auto& na = nt.getNA();
+  auto& data = tc.getExecution().getData();
+  const auto& labels = utils::LabelDictionary::global();
 
-  set<string> all_vars_set;
+  set<int32_t> all_vars_set;
 
   for (auto gid = 0; gid < na.size(); gid++) {
-    auto label = tc.getLabel(gid);
-
-    string var = "";
-    auto found = findAnyOf(label, "=", "!=", "<", ">", ">=", "=<");
-    if (found != string::npos) var = label.substr(0, found);
-    all_vars_set.insert(var);
+    all_vars_set.insert(decisionVar(data, gid));
   }
 
-  auto all_vars = vector<string>{all_vars_set.begin(), all_vars_set.end()};
-  std::sort(all_vars.begin(), all_vars.end());
+  auto all_vars = vector<int32_t>{all_vars_set.begin(), all_vars_set.end()};
+  std::sort(all_vars.begin(), all_vars.end(), [&labels](int32_t lhs, int32_t rhs) {
+    return labels.variable(lhs) < labels.variable(rhs);
+  });
 
   for (auto var_idx = 0u; var_idx < all_vars.size(); var_idx++) {
     auto var = all_vars[var_idx];
@@ -216,7 +226,7 @@ IcicleTreeCanvas::IcicleTreeCanvas(QAbstractScrollArea* parent, TreeCanvas* tc)
   compressLevel = 0;
   auto& na = node_tree.getNA();
   statistic.resize(na.size());
-  initTreeStatistic(*node_tree.getRoot(), 0, 0);
+  initTreeStatistic();
   connect(sa_.horizontalScrollBar(), SIGNAL(valueChanged(int)), this,
           SLOT(sliderChanged(int)));
   connect(sa_.verticalScrollBar(), SIGNAL(valueChanged(int)), this,
@@ -324,9 +334,12 @@ QRgb IcicleTreeCanvas::getColorByType(const VisualNode& node) {
   auto& na = node_tree.getNA();
   auto& data = tc_.getExecution().getData();
   auto gid = node.getIndex(na);
-  auto* entry = data.getEntry(gid);
-  // auto domain_red = entry == nullptr ? 0 : entry->domain;
-  auto domain_red = 0;
+  auto entry = data.getEntry(gid);
+  /// decoded from the node's info; only looked up when shown
+  double domain_red = 0;
+  if (entry && color_mapping_type == ColorMappingType::DOMAIN_REDUCTION) {
+    domain_red = std::max(0.0, data.getNodeInfo(entry.nodeUID()).domain_reduction);
+  }
   domain_red_sum += domain_red;
   switch (IcicleTreeCanvas::color_mapping_type) {
     case ColorMappingType::DEFAULT: {
@@ -340,20 +353,13 @@ QRgb IcicleTreeCanvas::getColorByType(const VisualNode& node) {
       color = QColor::fromHsv(0, 0, color_value).rgba();
     } break;
     case ColorMappingType::NODE_TIME: {
-      auto node_time = entry == nullptr ? 0 : entry->node_time;
+      auto node_time = !entry ? 0 : entry.nodeTime();
       /// TODO(maxim): need to normalize the node time
       int color_value = static_cast<float>(node_time);
       color = QColor::fromHsv(0, 0, color_value).rgba();
     }
     case ColorMappingType::VARIABLES: {
-      auto gid = node_tree.getIndex(&node);
-      auto label = tc_.getLabel(gid);
-
-      std::string var = "";
-      auto found = findAnyOf(label, "=", "!=", "<", ">", ">=", "=<");
-      if (found != std::string::npos) var = label.substr(0, found);
-
-      color = var2color[var];
+      color = var2color[decisionVar(data, gid)];
     } break;
   }
 
@@ -467,19 +473,33 @@ void IcicleTreeCanvas::mousePressEvent(QMouseEvent*) {
   }
 }
 
-IcicleNodeStatistic IcicleTreeCanvas::initTreeStatistic(VisualNode& root, int idx, int absX) {
-  const int kids = root.getNumberOfChildren();
-  auto& na = node_tree.getNA();
-  IcicleNodeStatistic cntRoot = IcicleNodeStatistic{kids?0: 1, 0, absX, root.getStatus()};
-  for (int i=0; i < kids; i++) {
-    VisualNode& kid = *root.getChild(na, i);
-    int kidIdx = root.getChild(i);
-    IcicleNodeStatistic cntKid = initTreeStatistic(kid, kidIdx, absX + cntRoot.leafCnt);
-    cntRoot.leafCnt += cntKid.leafCnt;
-    cntRoot.height = std::max(cntRoot.height, cntKid.height + 1);
+void IcicleTreeCanvas::initTreeStatistic() {
+  const auto snapshot = node_tree.snapshot();
+  const auto& s = *snapshot;
+
+  for (int i = 0; i < s.size(); ++i) {
+    statistic[s.gid(i)] = IcicleNodeStatistic{s.childCount(i) ? 0 : 1, 0, 0, s.status(i)};
+  }
+
+  /// leaf counts and heights: backwards, so that a subtree
+  /// is complete before it is added to its parent
+  for (int i = s.size() - 1; i > 0; --i) {
+    const auto& kid = statistic[s.gid(i)];
+    auto& parent = statistic[s.gid(s.parent(i))];
+    parent.leafCnt += kid.leafCnt;
+    parent.height = std::max(parent.height, kid.height + 1);
+  }
+
+  /// positions: forwards, the children of a node are placed
+  /// one after another starting where the node starts
+  for (int i = 0; i < s.size(); ++i) {
+    int absX = statistic[s.gid(i)].absX;
+    for (auto kid = s.childrenBegin(i); kid != s.childrenEnd(i); ++kid) {
+      auto& stat = statistic[s.gid(*kid)];
+      stat.absX = absX;
+      absX += stat.leafCnt;
+    }
   }
-  statistic[idx] = cntRoot;
-  return cntRoot;
 }
 
 void IcicleTreeCanvas::changeColorMapping(const QString& text) {
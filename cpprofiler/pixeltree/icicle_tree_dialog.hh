@@ -24,6 +24,7 @@
 #define CPPROFILER_PIXELVIEW_ICICLETREEDIALOG_HH
 
 #include <QDialog>
+#include <unordered_map>
 #include "pixelImage.hh"
 #include "maybeCaller.hh"
 #include "spacenode.hh"
@@ -88,7 +89,8 @@ class IcicleTreeCanvas : public QWidget {
   std::vector<IcicleRect> icicle_rects_;
   std::vector<VisualNode*> nodes_selected;  // to know which nodes to deselect
 
-  std::map<std::string, QRgb> var2color;
+  /// variable id (see `utils::LabelDictionary`) -> colour
+  std::unordered_map<int32_t, QRgb> var2color;
 
   ColorMappingType color_mapping_type = ColorMappingType::DEFAULT;
 
@@ -102,8 +104,8 @@ class IcicleTreeCanvas : public QWidget {
   /// TODO(maxim): temporarily here
   float domain_red_sum;
 
-  // init size of subtree
-  IcicleNodeStatistic initTreeStatistic(VisualNode& root, int idx, int absX);
+  // init size of subtree (for every node, from the tree's snapshot)
+  void initTreeStatistic();
 
   void redrawAll();
   void drawIcicleTree();
@@ -21,6 +21,8 @@
 #ifndef CPPROFILER_PIXELTREE_PIXELITEM_HH
 #define CPPROFILER_PIXELTREE_PIXELITEM_HH
 
+#include "visualnode.hh"
+
 namespace cpprofiler {
 namespace pixeltree {
 
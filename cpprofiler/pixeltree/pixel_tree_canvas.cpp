@@ -21,8 +21,8 @@
 
 #include "pixel_tree_canvas.hh"
 #include <numeric>
-#include <stack>
 #include <set>
+#include <unordered_map>
 #include <utility>
 
 #include "cpprofiler/analysis/backjumps.hh"
@@ -30,6 +30,11 @@
 #include "libs/perf_helper.hh"
 #include "globalhelper.hh"
 #include "data.hh"
+#include "treecanvas.hh"
+#include "execution.hh"
+#include "nodetree.hh"
+#include "treesnapshot.hh"
+#include "visualnode.hh"
 
 using namespace cpprofiler::pixeltree;
 using std::chrono::high_resolution_clock;
@@ -87,7 +92,7 @@ PixelTreeCanvas::PixelTreeCanvas(QWidget* parent, TreeCanvas& tc, InfoPanel& ip)
   da_data = depthAnalysis.runMSL();
 
   Backjumps bj;
-  bj_data = bj.findBackjumps(_na[0], _na);
+  bj_data = bj.findBackjumps(_tc.getExecution().nodeTree());
 
   // perfHelper.begin("construct/compress pixel tree");
   const int compr = m_State.approximation;
@@ -219,7 +224,7 @@ void PixelTreeCanvas::compressTimeHistogram(vector<float>& compressed,
 
     auto entry = _data.getEntry(pixel_list[i].node()->getIndex(_na));
 
-    auto value = (entry == nullptr) ? 0 : entry->node_time;
+    auto value = (!entry) ? 0 : entry.nodeTime();
     group_value += value;
 
     if (group_count == compression) {
@@ -344,41 +349,41 @@ void PixelTreeCanvas::gatherVarData() {
   var_decisions.clear();
   var_decisions.reserve(data_length);
 
-  std::set<std::string> all_vars_set;
+  const auto& labels = utils::LabelDictionary::global();
+
+  /// Variable (dictionary id) of every pixel's decision;
+  /// 0 (the empty name) if it is not a decision
+  std::vector<int32_t> pixel_vars;
+  pixel_vars.reserve(data_length);
+
+  std::set<int32_t> all_vars_set;
 
-  /// Obtain all variable names:
   for (auto& p : pixel_data.pixel_list) {
-    auto label = _data.getLabel(p.node()->getIndex(_na));
-    auto found = findAnyOf(label, "=", "!=", "<", ">", ">=", "=<");
+    auto entry = _data.getEntry(p.node()->getIndex(_na));
 
-    string var = "";
-    if (found != string::npos) var = label.substr(0, found);
+    int32_t var = 0;
+    if (entry && entry.decision().isDecision()) var = entry.decision().var;
 
+    pixel_vars.push_back(var);
     all_vars_set.insert(var);
   }
 
-  all_vars_vector = std::vector<std::string>{all_vars_set.begin(), all_vars_set.end()};
-
-  std::sort(all_vars_vector.begin(), all_vars_vector.end());
-
-
-  for (auto&p : pixel_data.pixel_list) {
-    auto var_id = -1;
+  std::vector<int32_t> all_vars{all_vars_set.begin(), all_vars_set.end()};
+  std::sort(all_vars.begin(), all_vars.end(), [&labels](int32_t lhs, int32_t rhs) {
+    return labels.variable(lhs) < labels.variable(rhs);
+  });
 
-    auto label = _data.getLabel(p.node()->getIndex(_na));
-    auto found = findAnyOf(label, "=", "!=", "<", ">", ">=", "=<");
+  /// dictionary id -> position in `all_vars_vector`
+  std::unordered_map<int32_t, int> var_index;
 
-    string var = "";
-    if (found != string::npos) var = label.substr(0, found);
-
-    for (auto i = 0u; i < all_vars_vector.size(); i++) {
-      if (all_vars_vector[i] == var) {
-        var_id = i;
-        break;
-      }
-    }
+  all_vars_vector.clear();
+  for (auto var : all_vars) {
+    var_index[var] = static_cast<int>(all_vars_vector.size());
+    all_vars_vector.push_back(labels.variable(var));
+  }
 
-    var_decisions.push_back(var_id);
+  for (auto var : pixel_vars) {
+    var_decisions.push_back(var_index[var]);
   }
 
 }
@@ -391,15 +396,15 @@ void PixelTreeCanvas::gatherNogoodData() {
   auto data_length = pixel_data.pixel_list.size();
   nogood_counts.resize(data_length);
 
-  auto uid2nogood = _data.getNogoods();
+  auto& uid2nogood = _data.getNogoods();
 
   for (unsigned i = 0; i < data_length; i++) {
     auto node = pixel_data.pixel_list[i].node();
     auto gid = node->getIndex(_na);
     auto uid = _data.gid2uid(gid);
     auto it = uid2nogood.find(uid);
-    if (it != uid2nogood.end()) {
-      auto nogood = it->second;
+    if (it) {
+      auto& nogood = *it;
       // qDebug() << "nogood: " << nogood.c_str();
       /// work out var length
       auto count = 0;
@@ -451,75 +456,38 @@ void PixelTreeCanvas::compressNogoodData(int compression) {
 }
 
 PixelData PixelTreeCanvas::traverseTree(VisualNode* root) {
-  /// 0. prepare a stack for exploration
-  std::stack<VisualNode*> explorationStack;
-  std::stack<unsigned int> depthStack;
 
   PixelData pixelData(_nodeCount);
 
-  /// 1. push the root node
-  explorationStack.push(root);
-  /// TODO(maxim): do I really need a stack here?
-  depthStack.push(1);
-
-  /// 2. traverse the stack
-  while (explorationStack.size() > 0) {
-    VisualNode* node = explorationStack.top();
-    explorationStack.pop();
-    unsigned int depth = depthStack.top();
-    depthStack.pop();
-
-    pixelData.pixel_list.emplace_back(PixelItem(0, node, depth));
-
-    /// 2.1. add the children to the stack
-    int kids = node->getNumberOfChildren();
-    for (int i = kids - 1; i >= 0; --i) {
-      auto kid = node->getChild(_na, i);
-      explorationStack.push(kid);
-      depthStack.push(depth + 1);
-    }
+  const auto snapshot = _tc.getExecution().nodeTree().snapshot();
+  const auto& s = *snapshot;
+
+  /// the subtree of `root` is a contiguous range of the (preorder) snapshot
+  const int r = s.preorder(root->getIndex(_na));
+  const int base_depth = s.depth(r) - 1;
+
+  for (int i = r; i < s.end(r); ++i) {
+    pixelData.pixel_list.emplace_back(
+        PixelItem(0, _na[s.gid(i)], s.depth(i) - base_depth));
   }
 
   return pixelData;
 }
 
 PixelData PixelTreeCanvas::traverseTreePostOrder(VisualNode* root) {
-  std::stack<VisualNode*> nodeStack1;
-  std::stack<unsigned int> depthStack1;
-
-  std::stack<VisualNode*> nodeStack2;
-  std::stack<unsigned int> depthStack2;
 
   PixelData pixelData(_nodeCount);
 
-  nodeStack1.push(root);
-  depthStack1.push(1);
+  const auto snapshot = _tc.getExecution().nodeTree().snapshot();
+  const auto& s = *snapshot;
 
-  while (nodeStack1.size() > 0) {
-    VisualNode* node = nodeStack1.top();
-    nodeStack1.pop();
-    unsigned int depth = depthStack1.top();
-    depthStack1.pop();
+  const int r = s.preorder(root->getIndex(_na));
+  const int base_depth = s.depth(r) - 1;
 
-    nodeStack2.push(node);
-    depthStack2.push(depth);
-
-    uint kids = node->getNumberOfChildren();
-    for (uint i = 0; i < kids; ++i) {
-      auto kid = node->getChild(_na, i);
-      nodeStack1.push(kid);
-      depthStack1.push(depth + 1);
-    }
-  }
-
-  while (nodeStack2.size() > 0) {
-    VisualNode* node = nodeStack2.top();
-    nodeStack2.pop();
-    unsigned int depth = depthStack2.top();
-    depthStack2.pop();
-
-    pixelData.pixel_list.emplace_back(PixelItem(0, node, depth));
-  }
+  s.forEachPostorder(r, [&](int i) {
+    pixelData.pixel_list.emplace_back(
+        PixelItem(0, _na[s.gid(i)], s.depth(i) - base_depth));
+  });
 
   return pixelData;
 }
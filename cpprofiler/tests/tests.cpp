@@ -2,6 +2,21 @@
 
 #include "cpprofiler/utils/literals.hh"
 #include "cpprofiler/utils/nogood_subsumption.hh"
+#include "cpprofiler/utils/spsc_queue.hh"
+#include "cpprofiler/utils/uid_map.hh"
+#include "cpprofiler/utils/receive_buffer.hh"
+#include "cpprofiler/utils/symbol_index.hh"
+#include "cpprofiler/utils/label_dictionary.hh"
+#include "cpprofiler/utils/spill_file.hh"
+#include "data.hh"
+#include "tracefile.hh"
+#include "nodebatch.hh"
+#include "nodeinfo.hh"
+#include "treesnapshot.hh"
+#include "parallellayout.hh"
+#include "layoutgeneration.hh"
+#include "drawingcursor.hh"
+#include "tilecache.hh"
 
 
 namespace cpprofiler {
@@ -11,6 +26,21 @@ namespace unit_tests {
 
     utils::lits::test_module();
     utils::subsum::test_module();
+    utils::spsc::test_module();
+    utils::uidmap::test_module();
+    utils::recvbuf::test_module();
+    utils::symidx::test_module();
+    utils::labeldict::test_module();
+    utils::spill::test_module();
+    tracefile::test_module();
+    nodebatch::test_module();
+    nodeinfo::test_module();
+    ingest::test_module();
+    treesnapshot::test_module();
+    parallellayout::test_module();
+    layoutgeneration::test_module();
+    drawingcursor::test_module();
+    tilecache::test_module();
 
   }
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <sstream>
+#include <cstdint>
+#include <functional>
 #include "cpprofiler/utils/string_utils.hh"
 
 struct NodeUID {
@@ -38,14 +40,22 @@ inline bool operator<(const NodeUID& lhs, const NodeUID& rhs) {
     return false;
 }
 
+/// Mixes all three components; the previous `h1 ^ (h2 << 1) ^ (h3 << 1)`
+/// made tid and rid indistinguishable (e.g. {n, 1, 0} == {n, 0, 1})
 struct NodeUIDHash
 {
-    std::size_t operator()(NodeUID const& a) const 
+    std::size_t operator()(NodeUID const& a) const
     {
-        size_t const h1 ( std::hash<int>{}(a.nid) );
-        size_t const h2 ( std::hash<int>{}(a.tid) );
-        size_t const h3 ( std::hash<int>{}(a.rid) );
-        return h1 ^ (h2 << 1) ^ (h3 << 1); // or use boost::hash_combine (see Discussion)
+        uint64_t h = static_cast<uint32_t>(a.nid);
+        h ^= static_cast<uint64_t>(static_cast<uint32_t>(a.tid)) << 32;
+        h ^= static_cast<uint64_t>(static_cast<uint32_t>(a.rid)) * 0x9E3779B97F4A7C15ULL;
+        /// finaliser from MurmurHash3
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
     }
 };
 
@@ -55,10 +65,7 @@ namespace std
     {
         size_t operator()(NodeUID const& a) const
         {
-            size_t const h1 ( std::hash<int>{}(a.nid) );
-            size_t const h2 ( std::hash<int>{}(a.tid) );
-            size_t const h3 ( std::hash<int>{}(a.rid) );
-            return h1 ^ (h2 << 1) ^ (h3 << 1); // or use boost::hash_combine (see Discussion)
+            return NodeUIDHash{}(a);
         }
     };
 }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace utils {
+
+  /// Position of the highest set bit of `x`, which must not be 0
+  inline unsigned highestBit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(static_cast<unsigned long long>(x));
+#elif defined(_MSC_VER)
+    unsigned long bit;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&bit, x);
+    return bit;
+#else
+    /// no 64-bit scan on 32-bit targets
+    if (_BitScanReverse(&bit, static_cast<unsigned long>(x >> 32))) return bit + 32;
+    _BitScanReverse(&bit, static_cast<unsigned long>(x));
+    return bit;
+#endif
+#else
+    unsigned bit = 0;
+    while (x >>= 1) ++bit;
+    return bit;
+#endif
+  }
+
+}
@@ -0,0 +1,224 @@
+#include "label_dictionary.hh"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+#include "libs/perf_helper.hh"
+
+namespace utils {
+
+  static bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+  static std::string trimmed(const std::string& str, size_t begin, size_t end) {
+    while (begin < end && isSpace(str[begin])) ++begin;
+    while (end > begin && isSpace(str[end - 1])) --end;
+    return str.substr(begin, end - begin);
+  }
+
+  /// Operator starting at `pos` (NONE if there is none); sets its length
+  static RelOp opAt(const std::string& str, size_t pos, size_t& length) {
+
+    const char c = str[pos];
+    const char next = pos + 1 < str.size() ? str[pos + 1] : '\0';
+
+    length = 2;
+    switch (c) {
+      case '=':
+        if (next == '<') return RelOp::LE;
+        if (next == '=') return RelOp::EQ;
+        length = 1;
+        return RelOp::EQ;
+      case '!':
+        return next == '=' ? RelOp::NQ : RelOp::NONE;
+      case ':':
+        return next == '=' ? RelOp::EQ : RelOp::NONE;
+      case '<':
+        if (next == '=') return RelOp::LE;
+        length = 1;
+        return RelOp::LT;
+      case '>':
+        if (next == '=') return RelOp::GE;
+        length = 1;
+        return RelOp::GT;
+      default:
+        return RelOp::NONE;
+    }
+  }
+
+  static bool parseInteger(const std::string& str, int64_t& value) {
+
+    size_t pos = 0;
+    const bool negative = !str.empty() && str[0] == '-';
+    if (negative) ++pos;
+
+    if (pos == str.size() || str.size() - pos > 18) return false;
+
+    int64_t result = 0;
+    for (; pos < str.size(); ++pos) {
+      if (str[pos] < '0' || str[pos] > '9') return false;
+      result = result * 10 + (str[pos] - '0');
+    }
+
+    value = negative ? -result : result;
+    return true;
+  }
+
+  Decision parseDecision(const std::string& label, std::string& var_name) {
+
+    Decision d;
+    d.var = -1;
+
+    for (size_t pos = 0; pos < label.size(); ++pos) {
+      size_t length;
+      const RelOp op = opAt(label, pos, length);
+      if (op == RelOp::NONE) continue;
+
+      var_name = trimmed(label, 0, pos);
+      /// not a decision after all (e.g. "=5")
+      if (var_name.empty()) break;
+
+      d.op = op;
+      d.has_value = parseInteger(trimmed(label, pos + length, label.size()), d.value);
+      return d;
+    }
+
+    var_name = trimmed(label, 0, label.size());
+    return d;
+  }
+
+  LabelDictionary::LabelDictionary() {
+    m_decisions.push_back(Decision{});
+  }
+
+  LabelDictionary& LabelDictionary::global() {
+    static LabelDictionary dictionary;
+    return dictionary;
+  }
+
+  int32_t LabelDictionary::intern(const std::string& label) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const size_t known = m_labels.size();
+    const int32_t id = m_labels.intern(label);
+    if (static_cast<size_t>(id) < known) return id;
+
+    std::string var_name;
+    Decision d = parseDecision(label, var_name);
+    d.var = m_vars.intern(var_name);
+    m_decisions.push_back(d);
+
+    return id;
+  }
+
+namespace labeldict {
+
+  static void test_parsing() {
+
+    struct Case {
+      const char* label;
+      const char* var;
+      RelOp op;
+      bool has_value;
+      int64_t value;
+    };
+
+    const Case cases[] = {
+      {"x[1]=4", "x[1]", RelOp::EQ, true, 4},
+      {"X_INTRODUCED_123 = -7", "X_INTRODUCED_123", RelOp::EQ, true, -7},
+      {"x == 2", "x", RelOp::EQ, true, 2},
+      {"x := 3", "x", RelOp::EQ, true, 3},
+      {"x!=3", "x", RelOp::NQ, true, 3},
+      {"x<=10", "x", RelOp::LE, true, 10},
+      {"x =< 10", "x", RelOp::LE, true, 10},
+      {"x<10", "x", RelOp::LT, true, 10},
+      {"x>=1", "x", RelOp::GE, true, 1},
+      {"x>1", "x", RelOp::GT, true, 1},
+      {"b = true", "b", RelOp::EQ, false, 0},
+      {"restart", "restart", RelOp::NONE, false, 0},
+      {"=5", "=5", RelOp::NONE, false, 0},
+      {"", "", RelOp::NONE, false, 0},
+    };
+
+    bool passed = true;
+
+    for (auto& c : cases) {
+      std::string var;
+      const Decision d = parseDecision(c.label, var);
+      if (var != c.var || d.op != c.op || d.has_value != c.has_value ||
+          (c.has_value && d.value != c.value)) {
+        std::cerr << "wrong parse of \"" << c.label << "\"\n";
+        passed = false;
+      }
+    }
+
+    if (passed) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (label parsing)\n";
+    }
+  }
+
+  /// Several threads intern overlapping labels: every label must end up
+  /// with exactly one id, and labels with the same variable share it
+  static void test_concurrent_interning() {
+
+    constexpr int THREADS = 4;
+    constexpr int LABELS = 200000;
+
+    LabelDictionary dict;
+
+    std::vector<std::vector<int32_t>> ids(THREADS);
+    std::vector<std::thread> threads;
+
+    perfHelper.begin("label dictionary: 4 x 200K labels");
+
+    for (int t = 0; t < THREADS; ++t) {
+      threads.emplace_back([&dict, &ids, t]() {
+        for (int i = 0; i < LABELS; ++i) {
+          const int n = (i * 7 + t * 13) % (LABELS / 4);
+          ids[t].push_back(dict.intern("X_INTRODUCED_" + std::to_string(n % 1000) +
+                                       "=" + std::to_string(n / 1000)));
+        }
+      });
+    }
+
+    for (auto& thread : threads) thread.join();
+
+    perfHelper.end();
+
+    bool passed = dict.size() == LABELS / 4 + 1 && dict.variableCount() == 1000 + 1;
+
+    std::unordered_map<std::string, int32_t> seen;
+
+    for (auto& thread_ids : ids) {
+      for (auto id : thread_ids) {
+        const auto& label = dict.label(id);
+        auto it = seen.emplace(label, id).first;
+        if (it->second != id) passed = false;
+
+        const auto& d = dict.decision(id);
+        const auto& var = dict.variable(d.var);
+        if (label.compare(0, var.size(), var) != 0 ||
+            label[var.size()] != '=' || d.op != RelOp::EQ || !d.has_value) {
+          passed = false;
+        }
+      }
+    }
+
+    if (passed) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (labels: " << dict.size()
+                << ", variables: " << dict.variableCount() << ")\n";
+    }
+  }
+
+  void test_module() {
+    test_parsing();
+    test_concurrent_interning();
+  }
+
+}}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <mutex>
+
+#include "cpprofiler/utils/string_pool.hh"
+#include "cpprofiler/utils/segmented_vector.hh"
+
+namespace utils {
+
+  namespace labeldict { void test_module(); }
+
+  /// Relation of a branching decision (`x <= 3` etc.)
+  enum class RelOp : uint8_t {
+    NONE, /// the label is not of the form `var op val`
+    EQ,   /// `=`, `==`, `:=`
+    NQ,   /// `!=`
+    LE,   /// `<=`, `=<`
+    LT,   /// `<`
+    GE,   /// `>=`
+    GT    /// `>`
+  };
+
+  /// A label split into (variable, operator, value)
+  struct Decision {
+    /// id of the variable part (see `LabelDictionary::variable`);
+    /// for labels that are not decisions this is the whole label,
+    /// so labels can always be grouped by it
+    int32_t var = 0;
+    RelOp op = RelOp::NONE;
+    /// whether `value` holds the right hand side (it may not be an integer)
+    bool has_value = false;
+    int64_t value = 0;
+
+    bool isDecision() const { return op != RelOp::NONE; }
+  };
+
+  /// Parse `label` as `var op val` (whitespace around the parts is ignored);
+  /// `var` is left as -1, the name of the variable goes into `var_name`
+  Decision parseDecision(const std::string& label, std::string& var_name);
+
+  /// Every distinct label seen by the profiler, shared by all executions
+  /// (the same labels show up in every run of a model). A label is parsed
+  /// once, when it is first interned; nodes only keep its id.
+  /// Interning may happen on any thread; what has been interned can be
+  /// read without locking. Id 0 is the empty label (variable 0 is "").
+  class LabelDictionary {
+
+    std::mutex m_mutex;
+
+    StringPool m_labels;
+    StringPool m_vars;
+    /// indexed by label id
+    SegmentedVector<Decision> m_decisions;
+
+  public:
+
+    LabelDictionary();
+
+    LabelDictionary(const LabelDictionary&) = delete;
+    LabelDictionary& operator=(const LabelDictionary&) = delete;
+
+    static LabelDictionary& global();
+
+    int32_t intern(const std::string& label);
+
+    const std::string& label(int32_t id) const { return m_labels.get(id); }
+
+    const Decision& decision(int32_t id) const { return m_decisions[id]; }
+
+    const std::string& variable(int32_t var) const { return m_vars.get(var); }
+
+    /// number of distinct labels
+    size_t size() const { return m_decisions.size(); }
+
+    size_t variableCount() const { return m_vars.size(); }
+  };
+
+}
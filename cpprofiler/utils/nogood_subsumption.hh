@@ -47,7 +47,7 @@ private:
                        bool renamed, bool simplified);
 
   std::vector<Clause> clauses;
-  std::unordered_map<NodeUID, Clause*> uid2clause;
+  utils::UidMap<Clause*> uid2clause;
   std::map<int, std::vector<NodeUID>> ordered_uids;
   bool _renamed {false};
   bool _simplified {false};
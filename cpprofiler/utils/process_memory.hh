@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace utils {
+
+  /// Resident memory of this process in bytes (0 if it can't be told)
+  uint64_t residentBytes();
+
+  /// Physical memory of the machine in bytes (0 if it can't be told)
+  uint64_t physicalBytes();
+
+}
@@ -0,0 +1,73 @@
+#include "receive_buffer.hh"
+
+#include <iostream>
+#include <random>
+#include <cstdint>
+#include <string>
+#include <algorithm>
+
+#include "libs/perf_helper.hh"
+
+namespace utils { namespace recvbuf {
+
+  /// Frames of random sizes arrive in randomly sized pieces
+  /// and must be parsed back intact and in order
+  static void test_framing() {
+
+    constexpr int FRAMES = 200000;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> frame_size(0, 300);
+    std::uniform_int_distribution<int> piece_size(1, 5000);
+
+    std::string stream;
+    for (int i = 0; i < FRAMES; ++i) {
+      const int32_t size = frame_size(rng);
+      stream.append(reinterpret_cast<const char*>(&size), sizeof(size));
+      for (int j = 0; j < size; ++j) stream.push_back(static_cast<char>(i + j));
+    }
+
+    /// small, so that it has to compact and grow
+    ReceiveBuffer buffer(64);
+
+    int parsed = 0;
+    bool intact = true;
+
+    perfHelper.begin("receive buffer: 200K frames");
+
+    size_t pos = 0;
+    while (pos < stream.size()) {
+      const size_t piece = std::min<size_t>(piece_size(rng), stream.size() - pos);
+      buffer.append(stream.data() + pos, piece);
+      pos += piece;
+
+      while (buffer.size() >= sizeof(int32_t)) {
+        int32_t size;
+        std::memcpy(&size, buffer.data(), sizeof(size));
+        if (buffer.size() < sizeof(size) + size) break;
+
+        const char* frame = buffer.data() + sizeof(size);
+        for (int j = 0; j < size; ++j) {
+          if (frame[j] != static_cast<char>(parsed + j)) intact = false;
+        }
+
+        buffer.consume(sizeof(size) + size);
+        ++parsed;
+      }
+    }
+
+    perfHelper.end();
+
+    if (intact && parsed == FRAMES && buffer.size() == 0) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (parsed " << parsed << " of " << FRAMES
+                << ", intact: " << intact << ")\n";
+    }
+  }
+
+  void test_module() {
+    test_framing();
+  }
+
+}}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+namespace utils {
+
+  namespace recvbuf { void test_module(); }
+
+  /// Byte buffer for a framed stream: data is written (e.g. read from a
+  /// socket) straight into the free space at the end and frames are
+  /// parsed in place at the front. Consumed bytes are never moved;
+  /// the unread tail (at most one partial frame, normally) is moved to
+  /// the front only when the free space runs out.
+  class ReceiveBuffer {
+
+    std::vector<char> m_data;
+    /// first unread byte
+    size_t m_begin = 0;
+    /// one past the last written byte
+    size_t m_end = 0;
+
+  public:
+
+    explicit ReceiveBuffer(size_t capacity) : m_data(capacity) {}
+
+    ReceiveBuffer(const ReceiveBuffer&) = delete;
+    ReceiveBuffer& operator=(const ReceiveBuffer&) = delete;
+
+    /// Make room for at least `n` more bytes; returns where to write them
+    /// (followed by `commit`)
+    char* prepare(size_t n) {
+      if (m_data.size() - m_end >= n) return m_data.data() + m_end;
+
+      const size_t unread = m_end - m_begin;
+
+      if (unread + n <= m_data.size()) {
+        std::memmove(m_data.data(), m_data.data() + m_begin, unread);
+      } else {
+        size_t new_size = 2 * m_data.size();
+        if (new_size < unread + n) new_size = unread + n;
+        std::vector<char> bigger(new_size);
+        std::memcpy(bigger.data(), m_data.data() + m_begin, unread);
+        m_data.swap(bigger);
+      }
+
+      m_begin = 0;
+      m_end = unread;
+      return m_data.data() + m_end;
+    }
+
+    /// `n` bytes were written at the pointer returned by `prepare`
+    void commit(size_t n) { m_end += n; }
+
+    /// Copy `n` bytes in
+    void append(const char* src, size_t n) {
+      std::memcpy(prepare(n), src, n);
+      commit(n);
+    }
+
+    /// Unread bytes
+    char* data() { return m_data.data() + m_begin; }
+    const char* data() const { return m_data.data() + m_begin; }
+    size_t size() const { return m_end - m_begin; }
+
+    /// Mark `n` bytes at the front as read
+    void consume(size_t n) {
+      m_begin += n;
+      /// cheap to start over while nothing is left unread
+      if (m_begin == m_end) m_begin = m_end = 0;
+    }
+
+    size_t capacity() const { return m_data.size(); }
+  };
+
+}
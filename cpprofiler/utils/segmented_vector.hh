@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "cpprofiler/utils/bits.hh"
+
+namespace utils {
+
+  /// A growable array whose elements never move once allocated: storage
+  /// is a fixed table of segments, segment `k` holding `BASE << k` elements.
+  /// Other threads can keep reading elements (and pointers to them) that
+  /// were published before, while the owner keeps appending.
+  /// Releasing the whole thing is a handful of `delete[]`.
+  template <typename T, unsigned BASE_BITS = 10>
+  class SegmentedVector {
+
+    static constexpr unsigned MAX_SEGMENTS = 48;
+
+    T* m_segments[MAX_SEGMENTS] = {};
+    std::atomic<size_t> m_size{0};
+    size_t m_capacity = 0;
+
+    static unsigned segmentOf(size_t j) {
+      return highestBit(j) - BASE_BITS;
+    }
+
+    void grow() {
+      const unsigned seg = segmentOf(m_capacity + (size_t{1} << BASE_BITS));
+      const size_t seg_size = size_t{1} << (seg + BASE_BITS);
+      m_segments[seg] = new T[seg_size]();
+      m_capacity += seg_size;
+    }
+
+  public:
+
+    SegmentedVector() = default;
+    SegmentedVector(const SegmentedVector&) = delete;
+    SegmentedVector& operator=(const SegmentedVector&) = delete;
+
+    ~SegmentedVector() { clear(); }
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+    bool empty() const { return size() == 0; }
+
+    T& operator[](size_t i) {
+      const size_t j = i + (size_t{1} << BASE_BITS);
+      const unsigned seg = segmentOf(j);
+      return m_segments[seg][j - (size_t{1} << (seg + BASE_BITS))];
+    }
+
+    const T& operator[](size_t i) const {
+      return const_cast<SegmentedVector&>(*this)[i];
+    }
+
+    void push_back(T value) {
+      const size_t n = m_size.load(std::memory_order_relaxed);
+      if (n == m_capacity) grow();
+      (*this)[n] = std::move(value);
+      m_size.store(n + 1, std::memory_order_release);
+    }
+
+    /// Grow to at least `n` elements, new elements set to `fill`
+    void resize(size_t n, const T& fill) {
+      const size_t old_size = m_size.load(std::memory_order_relaxed);
+      if (n <= old_size) return;
+      while (m_capacity < n) grow();
+      for (size_t i = old_size; i < n; ++i) (*this)[i] = fill;
+      m_size.store(n, std::memory_order_release);
+    }
+
+    void clear() {
+      for (auto& seg : m_segments) {
+        delete[] seg;
+        seg = nullptr;
+      }
+      m_capacity = 0;
+      m_size.store(0);
+    }
+
+    /// Bytes allocated for elements (excluding what they own)
+    size_t allocatedBytes() const { return m_capacity * sizeof(T); }
+  };
+
+}
@@ -0,0 +1,127 @@
+#include "spill_file.hh"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "libs/perf_helper.hh"
+
+namespace utils {
+
+  static int seekTo(std::FILE* file, uint64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), whence);
+#else
+    return fseeko(file, static_cast<off_t>(offset), whence);
+#endif
+  }
+
+  SpillFile::SpillFile() : m_file(std::tmpfile()) {
+    if (!m_file) std::cerr << "could not create a spill file\n";
+  }
+
+  SpillFile::~SpillFile() {
+    if (m_file) std::fclose(m_file);
+  }
+
+  bool SpillFile::write(const std::string& str, SpillRef& ref) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_file || str.size() > UINT32_MAX) return false;
+
+    if (m_reading) {
+      if (seekTo(m_file, 0, SEEK_END) != 0) return false;
+      m_reading = false;
+    }
+
+    if (std::fwrite(str.data(), 1, str.size(), m_file) != str.size()) {
+      /// whatever made it in is lost, but later writes stay consistent
+      seekTo(m_file, m_size, SEEK_SET);
+      return false;
+    }
+
+    ref.offset = m_size;
+    ref.length = static_cast<uint32_t>(str.size());
+    m_size += str.size();
+    return true;
+  }
+
+  std::string SpillFile::read(const SpillRef& ref) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_file || ref.offset + ref.length > m_size) return {};
+
+    m_reading = true;
+
+    std::string str(ref.length, '\0');
+    if (seekTo(m_file, ref.offset, SEEK_SET) != 0 ||
+        std::fread(&str[0], 1, ref.length, m_file) != ref.length) {
+      return {};
+    }
+    return str;
+  }
+
+  uint64_t SpillFile::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+  }
+
+namespace spill {
+
+  /// A writer and a reader at the same time; everything read back
+  /// must match what was written
+  static void test_round_trip() {
+
+    constexpr int COUNT = 200000;
+
+    SpillFile file;
+
+    std::vector<std::string> strings;
+    for (int i = 0; i < COUNT; ++i) {
+      strings.push_back("{\"reasons\": [" + std::to_string(i) + "], \"pad\": \"" +
+                        std::string(i % 97, 'x') + "\"}");
+    }
+
+    std::vector<SpillRef> refs(COUNT);
+    std::atomic<int> written{0};
+    std::atomic<bool> passed{file.isOpen()};
+
+    perfHelper.begin("spill file: 200K strings");
+
+    std::thread reader([&]() {
+      int checked = 0;
+      while (checked < COUNT) {
+        const int avail = written.load();
+        for (; checked < avail; checked += 7) {
+          if (file.read(refs[checked]) != strings[checked]) passed = false;
+        }
+        if (avail == 0 || checked >= avail) std::this_thread::yield();
+      }
+    });
+
+    for (int i = 0; i < COUNT; ++i) {
+      if (!file.write(strings[i], refs[i])) passed = false;
+      written.store(i + 1);
+    }
+
+    reader.join();
+
+    for (int i = 0; i < COUNT; ++i) {
+      if (file.read(refs[i]) != strings[i]) passed = false;
+    }
+
+    perfHelper.end();
+
+    if (passed.load()) {
+      std::cerr << "test passed! (" << file.size() / (1 << 20) << " MB spilled)\n";
+    } else {
+      std::cerr << "test did NOT pass! (spilled strings differ)\n";
+    }
+  }
+
+  void test_module() {
+    test_round_trip();
+  }
+
+}}
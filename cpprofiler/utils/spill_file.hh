@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <mutex>
+
+namespace utils {
+
+  namespace spill { void test_module(); }
+
+  /// Where a string went in a SpillFile
+  struct SpillRef {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+  };
+
+  /// Anonymous scratch file for strings that don't have to stay in memory
+  /// (deleted by the OS once closed). Strings are appended and read back
+  /// by their SpillRef; any thread may do either.
+  class SpillFile {
+
+    mutable std::mutex m_mutex;
+    std::FILE* m_file = nullptr;
+    uint64_t m_size = 0;
+    /// whether the file position was last moved by a read
+    /// (stdio needs a seek between reading and writing)
+    mutable bool m_reading = false;
+
+  public:
+
+    SpillFile();
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    /// False if the string could not be written (keep it in memory then)
+    bool write(const std::string& str, SpillRef& ref);
+
+    /// Empty if `ref` can't be read back
+    std::string read(const SpillRef& ref) const;
+
+    /// bytes written so far
+    uint64_t size() const;
+  };
+
+}
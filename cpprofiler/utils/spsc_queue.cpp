@@ -0,0 +1,60 @@
+#include "spsc_queue.hh"
+
+#include <thread>
+#include <iostream>
+
+#include "libs/perf_helper.hh"
+
+namespace utils { namespace spsc {
+
+  static void test_order_and_handoff() {
+
+    constexpr int N = 2000000;
+
+    SpscQueue<int> queue(1024);
+
+    perfHelper.begin("spsc queue: 2M items");
+
+    std::thread producer([&queue]() {
+      for (int i = 0; i < N; ++i) {
+        queue.push(int{i});
+      }
+      queue.close();
+    });
+
+    std::vector<int> batch;
+    int expected = 0;
+    bool in_order = true;
+
+    while (true) {
+      batch.clear();
+      queue.popMany(batch, 256);
+
+      for (auto v : batch) {
+        if (v != expected) in_order = false;
+        ++expected;
+      }
+
+      if (batch.empty()) {
+        if (queue.isClosed() && queue.empty()) break;
+        queue.waitForData(std::chrono::milliseconds(10));
+      }
+    }
+
+    producer.join();
+
+    perfHelper.end();
+
+    if (in_order && expected == N) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (received " << expected
+                << " of " << N << ", in order: " << in_order << ")\n";
+    }
+  }
+
+  void test_module() {
+    test_order_and_handoff();
+  }
+
+}}
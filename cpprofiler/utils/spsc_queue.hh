@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+
+namespace utils {
+
+  namespace spsc { void test_module(); }
+
+  /// Bounded single-producer/single-consumer ring buffer.
+  /// `push` must only be called from one thread and `pop*` from another;
+  /// neither touches the mutex unless the other side is parked waiting
+  /// (the ring is full for the producer or empty for the consumer).
+  template <typename T>
+  class SpscQueue {
+
+    std::vector<T> m_slots;
+    const size_t m_mask;
+
+    /// next slot to be read (owned by the consumer)
+    alignas(64) std::atomic<size_t> m_head{0};
+    /// next slot to be written (owned by the producer)
+    alignas(64) std::atomic<size_t> m_tail{0};
+
+    alignas(64) std::atomic<bool> m_closed{false};
+    std::atomic<bool> m_consumer_waiting{false};
+    std::atomic<bool> m_producer_waiting{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+
+    static size_t roundUp(size_t n) {
+      size_t res = 1;
+      while (res < n) res <<= 1;
+      return res;
+    }
+
+    void wakeConsumer() {
+      if (m_consumer_waiting.load()) {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_not_empty.notify_one();
+      }
+    }
+
+    void wakeProducer() {
+      if (m_producer_waiting.load()) {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_not_full.notify_one();
+      }
+    }
+
+  public:
+
+    /// `capacity` is rounded up to the next power of two
+    explicit SpscQueue(size_t capacity)
+      : m_slots(roundUp(capacity)), m_mask(roundUp(capacity) - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return m_slots.size(); }
+
+    size_t size() const {
+      return m_tail.load(std::memory_order_acquire) -
+             m_head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    bool isClosed() const { return m_closed.load(); }
+
+    /// Producer side: blocks while the ring is full
+    void push(T&& item) {
+      const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+      if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_producer_waiting.store(true);
+        m_not_full.wait(lk, [this, tail]() {
+          return tail - m_head.load() < m_slots.size();
+        });
+        m_producer_waiting.store(false);
+      }
+
+      m_slots[tail & m_mask] = std::move(item);
+      /// seq_cst so that it is ordered against `m_consumer_waiting`
+      m_tail.store(tail + 1);
+
+      wakeConsumer();
+    }
+
+    /// Consumer side: move up to `max_items` into `out`, never blocks;
+    /// returns the number of items moved
+    size_t popMany(std::vector<T>& out, size_t max_items) {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      const size_t avail = m_tail.load(std::memory_order_acquire) - head;
+      const size_t count = avail < max_items ? avail : max_items;
+
+      for (size_t i = 0; i < count; ++i) {
+        out.push_back(std::move(m_slots[(head + i) & m_mask]));
+      }
+
+      if (count > 0) {
+        m_head.store(head + count);
+        wakeProducer();
+      }
+
+      return count;
+    }
+
+    bool tryPop(T& item) {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (m_tail.load(std::memory_order_acquire) == head) return false;
+
+      item = std::move(m_slots[head & m_mask]);
+      m_head.store(head + 1);
+      wakeProducer();
+      return true;
+    }
+
+    /// Consumer side: park until there is something to read, the queue
+    /// is closed or `timeout` expires; returns whether data is available
+    template <typename Rep, typename Period>
+    bool waitForData(std::chrono::duration<Rep, Period> timeout) {
+      if (!empty()) return true;
+
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_consumer_waiting.store(true);
+      m_not_empty.wait_for(lk, timeout, [this]() {
+        return !empty() || m_closed.load();
+      });
+      m_consumer_waiting.store(false);
+
+      return !empty();
+    }
+
+    /// No more items will be pushed; wakes up a waiting consumer
+    void close() {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_closed.store(true);
+      m_not_empty.notify_one();
+    }
+  };
+
+}
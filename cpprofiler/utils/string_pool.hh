@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include "cpprofiler/utils/segmented_vector.hh"
+
+namespace utils {
+
+  /// Stores every distinct string once and refers to it by a dense id;
+  /// id 0 is always the empty string. Only one thread may intern, but
+  /// strings already interned can be read from any thread.
+  class StringPool {
+
+    SegmentedVector<std::string> m_strings;
+    std::unordered_map<std::string, int32_t> m_ids;
+
+  public:
+
+    StringPool() { intern(""); }
+
+    int32_t intern(const std::string& str) {
+      auto it = m_ids.find(str);
+      if (it != m_ids.end()) return it->second;
+
+      const auto id = static_cast<int32_t>(m_strings.size());
+      m_strings.push_back(str);
+      m_ids.emplace(str, id);
+      return id;
+    }
+
+    const std::string& get(int32_t id) const { return m_strings[id]; }
+
+    /// number of distinct strings
+    size_t size() const { return m_strings.size(); }
+  };
+
+}
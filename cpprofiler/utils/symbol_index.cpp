@@ -0,0 +1,110 @@
+#include "symbol_index.hh"
+
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+
+#include "libs/perf_helper.hh"
+
+namespace utils { namespace symidx {
+
+  /// How NameMap used to rename identifiers
+  static std::string renameWithRegex(const std::string& text,
+                                     const std::unordered_map<std::string, std::string>& names) {
+    static const std::regex ident_regex("[A-Za-z][A-Za-z0-9_]*");
+
+    std::stringstream ss;
+    size_t pos = 0;
+
+    auto begin = std::sregex_iterator(text.begin(), text.end(), ident_regex);
+    for (auto i = begin; i != std::sregex_iterator(); ++i) {
+      std::smatch match = *i;
+      ss << text.substr(pos, static_cast<size_t>(match.position()) - pos);
+      auto it = names.find(match.str());
+      ss << (it != names.end() ? it->second : match.str());
+      pos = static_cast<size_t>(match.position() + match.length());
+    }
+
+    ss << text.substr(pos, text.size());
+    return ss.str();
+  }
+
+  static std::string renameWithIndex(const std::string& text, const SymbolIndex& index,
+                                     const std::vector<std::string>& names) {
+    std::string res;
+    res.reserve(text.size());
+
+    scanIdentifiers(text,
+      [&res](const char* str, size_t len) { res.append(str, len); },
+      [&](const char* str, size_t len) {
+        const int32_t id = index.find(str, len);
+        if (id != -1) {
+          res.append(names[id]);
+        } else {
+          res.append(str, len);
+        }
+      });
+
+    return res;
+  }
+
+  /// Nogood-like clauses over FlatZinc identifiers, a few of them unknown
+  static void test_against_regex() {
+
+    constexpr int SYMBOLS = 20000;
+    constexpr int CLAUSES = 20000;
+
+    std::unordered_map<std::string, std::string> names;
+    std::vector<std::string> nice_names;
+    SymbolIndex index;
+
+    for (int i = 0; i < SYMBOLS; ++i) {
+      const std::string ident = "X_INTRODUCED_" + std::to_string(i) + "_";
+      const std::string nice = "queens[" + std::to_string(i % 97) + "]";
+      names[ident] = nice;
+      index.insert(ident, static_cast<int32_t>(nice_names.size()));
+      nice_names.push_back(nice);
+    }
+
+    std::vector<std::string> clauses;
+    for (int c = 0; c < CLAUSES; ++c) {
+      std::string clause = "[";
+      for (int l = 0; l < 10; ++l) {
+        const int var = (c * 7919 + l * 104729) % (SYMBOLS + 100);
+        if (l > 0) clause += ", ";
+        clause += "X_INTRODUCED_" + std::to_string(var) + "_ <= " + std::to_string(l);
+      }
+      clause += "] 9lives _x";
+      clauses.push_back(clause);
+    }
+
+    std::vector<std::string> expected;
+
+    perfHelper.begin("rename 20K clauses: regex");
+    for (auto& clause : clauses) expected.push_back(renameWithRegex(clause, names));
+    perfHelper.end();
+
+    bool passed = true;
+
+    perfHelper.begin("rename 20K clauses: scanner + symbol index");
+    for (size_t c = 0; c < clauses.size(); ++c) {
+      if (renameWithIndex(clauses[c], index, nice_names) != expected[c]) passed = false;
+    }
+    perfHelper.end();
+
+    if (index.find("X_INTRODUCED_") != -1 || index.find(std::string{}) != -1) passed = false;
+    if (index.size() != SYMBOLS) passed = false;
+
+    if (passed) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (scanner disagrees with regex)\n";
+    }
+  }
+
+  void test_module() {
+    test_against_regex();
+  }
+
+}}
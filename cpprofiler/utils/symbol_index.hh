@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace utils {
+
+  namespace symidx { void test_module(); }
+
+  inline bool isIdentStart(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+  }
+
+  inline bool isIdentChar(char c) {
+    return isIdentStart(c) || (c >= '0' && c <= '9') || c == '_';
+  }
+
+  /// Splits `text` into identifiers (`[A-Za-z][A-Za-z0-9_]*`, found the
+  /// same way as with std::regex_search) and the text between them:
+  /// `on_text(begin, length)` / `on_ident(begin, length)` are called in order
+  template <typename T, typename I>
+  void scanIdentifiers(const std::string& text, T&& on_text, I&& on_ident) {
+    const char* const data = text.data();
+    const size_t size = text.size();
+
+    size_t plain = 0; /// start of the text not passed on yet
+    size_t i = 0;
+
+    while (i < size) {
+      if (!isIdentStart(data[i])) { ++i; continue; }
+
+      size_t end = i + 1;
+      while (end < size && isIdentChar(data[end])) ++end;
+
+      if (i > plain) on_text(data + plain, i - plain);
+      on_ident(data + i, end - i);
+
+      plain = i = end;
+    }
+
+    if (size > plain) on_text(data + plain, size - plain);
+  }
+
+  /// Read-mostly map from identifiers to non-negative ids: keys live in
+  /// one buffer and the table is open-addressed (at most half full), so
+  /// a lookup hashes the characters in place and allocates nothing
+  class SymbolIndex {
+
+    struct Slot {
+      uint32_t key_offset;
+      uint32_t key_length;
+      int32_t value = -1; /// -1 for an empty slot
+    };
+
+    std::string m_keys;
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+
+    static uint32_t hash(const char* str, size_t len) {
+      uint32_t h = 2166136261u; /// FNV-1a
+      for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<uint8_t>(str[i]);
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    bool sameKey(const Slot& slot, const char* str, size_t len) const {
+      return slot.key_length == len &&
+             std::memcmp(m_keys.data() + slot.key_offset, str, len) == 0;
+    }
+
+    /// slot holding `str`, or the empty one where it would go
+    size_t findSlot(const char* str, size_t len) const {
+      const size_t mask = m_slots.size() - 1;
+      size_t pos = hash(str, len) & mask;
+      while (m_slots[pos].value != -1 && !sameKey(m_slots[pos], str, len)) {
+        pos = (pos + 1) & mask;
+      }
+      return pos;
+    }
+
+    void grow() {
+      std::vector<Slot> old(m_slots.size() ? 2 * m_slots.size() : 16);
+      old.swap(m_slots);
+      for (auto& slot : old) {
+        if (slot.value == -1) continue;
+        m_slots[findSlot(m_keys.data() + slot.key_offset, slot.key_length)] = slot;
+      }
+    }
+
+  public:
+
+    /// Map `key` to `value` (>= 0), replacing the old value if any
+    void insert(const std::string& key, int32_t value) {
+      if (2 * (m_size + 1) > m_slots.size()) grow();
+
+      Slot& slot = m_slots[findSlot(key.data(), key.size())];
+      if (slot.value == -1) {
+        slot.key_offset = static_cast<uint32_t>(m_keys.size());
+        slot.key_length = static_cast<uint32_t>(key.size());
+        m_keys.append(key);
+        ++m_size;
+      }
+      slot.value = value;
+    }
+
+    /// -1 if not there
+    int32_t find(const char* str, size_t len) const {
+      if (m_size == 0) return -1;
+      return m_slots[findSlot(str, len)].value;
+    }
+
+    int32_t find(const std::string& key) const { return find(key.data(), key.size()); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+  };
+
+}
@@ -1,5 +1,6 @@
 #include <stack>
 #include <functional>
+#include <random>
 #include "visualnode.hh"
 #include "execution.hh"
 #include "cpprofiler/utils/tree_utils.hh"
@@ -60,6 +61,48 @@ void addChildren(VisualNode* node, NodeTree& nt, int kids) {
 
 };
 
+void buildRandomTree(NodeTree& nt, int nodes, unsigned seed) {
+
+  auto& na = nt.getNA();
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> kids(0, 3);
+
+  /// grow at random open leaves until there are enough nodes
+  std::vector<VisualNode*> leaves{nt.getRoot()};
+  while (na.size() < nodes && !leaves.empty()) {
+    std::uniform_int_distribution<size_t> pick(0, leaves.size() - 1);
+    const size_t k = pick(rng);
+    auto node = leaves[k];
+    leaves[k] = leaves.back();
+    leaves.pop_back();
+
+    const int n = std::max(kids(rng), leaves.empty() ? 1 : 0);
+    if (n == 0) continue;
+
+    addChildren(node, nt, n);
+    node->setStatus(BRANCH);
+    for (int alt = 0; alt < n; ++alt) leaves.push_back(nt.getChild(*node, alt));
+  }
+}
+
+void buildCompleteTree(NodeTree& nt, int nodes,
+                       const std::vector<NodeStatus>& leaves) {
+
+  auto& na = nt.getNA();
+
+  for (int i = 0; na.size() < nodes; ++i) {
+    addChildren(na[i], nt, 2 + i % 2);
+    na[i]->setStatus(BRANCH);
+  }
+
+  for (int i = 0; i < na.size(); ++i) {
+    if (na[i]->getNumberOfChildren() == 0) {
+      na[i]->setStatus(leaves[i % leaves.size()]);
+    }
+  }
+}
+
 void applyToEachNode(NodeTree& nt, const NodeAction& action) {
   auto& na = nt.getNA();
 
@@ -190,13 +233,16 @@ void highlightSubtrees(NodeTree& nt, const std::vector<VisualNode*>& nodes,
     root->layout(na);
   }
 
-  // unhighlight all
-  applyToEachNode(nt, [](VisualNode* n) {
+  // unhighlight all (outlines are only drawn again where the tree is dirty)
+  applyToEachNode(nt, [&na](VisualNode* n) {
+    if (!n->isHighlighted()) return;
     n->setHighlighted(false);
+    n->dirtyUp(na);
   });
 
   for (auto node : nodes) {
     node->setHighlighted(true);
+    node->dirtyUp(na);
   }
 
   if (hideNotHighlighted) {
@@ -2,10 +2,12 @@
 #define CPPROFILER_TREE_UTILS
 
 #include <functional>
+#include <vector>
 
 class VisualNode;
 class NodeTree;
 class Execution;
+enum NodeStatus : char;
 
 namespace utils {
 
@@ -19,6 +21,16 @@ void copyTree(VisualNode* node_t, NodeTree& nt_t,
 /// if the node already has children
 void addChildren(VisualNode* node, NodeTree& nt, int kids);
 
+/// Grow a random tree of (at least) `nodes` nodes under the root of `nt`
+/// with 0-3 children per node; the same tree every time for the same `seed`
+void buildRandomTree(NodeTree& nt, int nodes, unsigned seed);
+
+/// Grow a complete tree of (at least) `nodes` nodes under the root of `nt`
+/// with 2-3 children per node; the leaf with index `i` gets status
+/// `leaves[i % leaves.size()]`
+void buildCompleteTree(NodeTree& nt, int nodes,
+                       const std::vector<NodeStatus>& leaves);
+
 /// Apply `action` to each node (unspecified order)
 void applyToEachNode(NodeTree& nt, const NodeAction& action);
 
@@ -0,0 +1,109 @@
+#include "uid_map.hh"
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "libs/perf_helper.hh"
+
+namespace utils { namespace uidmap {
+
+  /// Same lookups against UidIndex and unordered_map, with dense ids,
+  /// "none" restarts/threads, negative and very sparse ids mixed in
+  static void test_against_hash_map() {
+
+    UidIndex index;
+    std::unordered_map<NodeUID, int32_t> reference;
+
+    auto add = [&](NodeUID uid, int32_t value) {
+      index.set(uid, value);
+      reference[uid] = value;
+    };
+
+    int32_t value = 0;
+    for (int32_t tid = -1; tid < 4; ++tid) {
+      for (int32_t nid = 0; nid < 20000; ++nid) {
+        add({nid, 0, tid}, value++);
+      }
+    }
+    add({5, -1, -1}, value++);
+    add({-1, 0, 0}, value++);
+    add({1 << 30, 0, 0}, value++);
+    add({7, 1 << 20, 0}, value++);
+    /// far ahead of row {.., 3, 0}: stored sparse, then the row catches up
+    add({9000, 3, 0}, value++);
+    for (int32_t nid = 0; nid < 9000; ++nid) {
+      add({nid, 3, 0}, value++);
+    }
+    add({9000, 3, 0}, value++);
+
+    bool passed = index.size() == reference.size();
+
+    for (auto& kv : reference) {
+      if (index.get(kv.first) != kv.second) passed = false;
+    }
+
+    if (index.get({20000, 0, 0}) != -1) passed = false;
+    if (index.get({3, 2, 0}) != -1) passed = false;
+    if (index.get({0, 0, 100}) != -1) passed = false;
+
+    if (passed) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (UidIndex disagrees with unordered_map)\n";
+    }
+  }
+
+  static void test_lookup_speed() {
+
+    constexpr int32_t N = 1000000;
+    constexpr int32_t THREADS = 4;
+
+    UidIndex index;
+    for (int32_t nid = 0; nid < N; ++nid) {
+      index.set({nid, 0, nid % THREADS}, nid);
+    }
+
+    int64_t sum = 0;
+
+    perfHelper.begin("uid index: 10M parent lookups");
+    for (int round = 0; round < 10; ++round) {
+      for (int32_t nid = 0; nid < N; ++nid) {
+        sum += index.get({nid, 0, nid % THREADS});
+      }
+    }
+    perfHelper.end();
+
+    if (sum == 10 * (int64_t{N} * (N - 1) / 2) && index.sparseCount() == 0) {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (sum: " << sum << ", sparse: "
+                << index.sparseCount() << ")\n";
+    }
+  }
+
+  /// Values found before a burst of inserts are still where they were
+  static void test_stable_values() {
+
+    UidMap<std::string> map;
+    map[{0, 0, 0}] = "first";
+    const std::string* first = map.find({0, 0, 0});
+
+    for (int32_t nid = 1; nid < 100000; ++nid) {
+      map[{nid, 0, 0}] = std::to_string(nid);
+    }
+
+    if (first == map.find({0, 0, 0}) && *first == "first") {
+      std::cerr << "test passed!\n";
+    } else {
+      std::cerr << "test did NOT pass! (UidMap value moved on insert)\n";
+    }
+  }
+
+  void test_module() {
+    test_against_hash_map();
+    test_stable_values();
+    test_lookup_speed();
+  }
+
+}}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "cpprofiler/universal.hh"
+
+namespace utils {
+
+  namespace uidmap { void test_module(); }
+
+  /// Maps NodeUID to a non-negative int32 (-1 means "absent").
+  /// Solver node ids are nearly dense within a (restart, thread) pair,
+  /// so the common case is a direct-indexed table:
+  /// restart -> thread -> vector indexed by node id.
+  /// Ids that would make a row too sparse (or negative ones) go into
+  /// a hash map instead.
+  class UidIndex {
+
+    using Row = std::vector<int32_t>;
+
+    /// restarts/threads beyond this are kept in the hash map
+    static constexpr int32_t MAX_DENSE_ID = 1 << 12;
+    /// a row only grows over a gap of at most this many unused ids
+    /// (or the row's current size, whichever is larger)
+    static constexpr size_t MAX_DENSE_GAP = 1 << 12;
+
+    /// indexed by `rid + 1` and `tid + 1` (solvers use -1 for "none")
+    std::vector<std::vector<Row>> m_dense;
+    std::unordered_map<NodeUID, int32_t, NodeUIDHash> m_sparse;
+    size_t m_size = 0;
+
+    static bool denseKey(const NodeUID& uid) {
+      return uid.nid >= 0 &&
+             uid.rid >= -1 && uid.rid < MAX_DENSE_ID &&
+             uid.tid >= -1 && uid.tid < MAX_DENSE_ID;
+    }
+
+    const Row* findRow(const NodeUID& uid) const {
+      const size_t r = uid.rid + 1;
+      if (r >= m_dense.size()) return nullptr;
+      const size_t t = uid.tid + 1;
+      if (t >= m_dense[r].size()) return nullptr;
+      return &m_dense[r][t];
+    }
+
+    /// Row that can hold `uid`, grown if necessary; nullptr if too sparse
+    Row* makeRow(const NodeUID& uid) {
+      const size_t r = uid.rid + 1;
+      const size_t t = uid.tid + 1;
+      const size_t nid = uid.nid;
+
+      if (r >= m_dense.size()) m_dense.resize(r + 1);
+      auto& threads = m_dense[r];
+      if (t >= threads.size()) threads.resize(t + 1);
+      auto& row = threads[t];
+
+      if (nid < row.size()) return &row;
+
+      const size_t max_gap = row.size() > MAX_DENSE_GAP ? row.size() : MAX_DENSE_GAP;
+      if (nid - row.size() > max_gap) return nullptr;
+
+      const size_t new_size = nid + 1 > 2 * row.size() ? nid + 1 : 2 * row.size();
+      row.resize(new_size, -1);
+      return &row;
+    }
+
+  public:
+
+    /// Value stored for `uid`, -1 if none
+    int32_t get(const NodeUID& uid) const {
+      if (denseKey(uid)) {
+        const Row* row = findRow(uid);
+        if (row && static_cast<size_t>(uid.nid) < row->size()) {
+          const int32_t value = (*row)[uid.nid];
+          if (value != -1 || m_sparse.empty()) return value;
+        } else if (m_sparse.empty()) {
+          return -1;
+        }
+      }
+
+      auto it = m_sparse.find(uid);
+      return it == m_sparse.end() ? -1 : it->second;
+    }
+
+    bool contains(const NodeUID& uid) const { return get(uid) != -1; }
+
+    /// Store `value` (must be >= 0) for `uid`, replacing the old one
+    void set(const NodeUID& uid, int32_t value) {
+      if (denseKey(uid)) {
+        if (Row* row = makeRow(uid)) {
+          int32_t& slot = (*row)[uid.nid];
+          if (slot == -1) {
+            /// the id could have been too sparse before the row grew
+            if (m_sparse.empty() || m_sparse.erase(uid) == 0) ++m_size;
+          }
+          slot = value;
+          return;
+        }
+      }
+
+      if (m_sparse.insert({uid, value}).second) {
+        ++m_size;
+      } else {
+        m_sparse[uid] = value;
+      }
+    }
+
+    size_t size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    /// how many ids ended up in the hash map
+    size_t sparseCount() const { return m_sparse.size(); }
+
+    void clear() {
+      m_dense.clear();
+      m_sparse.clear();
+      m_size = 0;
+    }
+  };
+
+  /// NodeUID-keyed map on top of `UidIndex`: the index resolves a uid
+  /// to a slot in a deque of (uid, value) pairs, so that (like with
+  /// unordered_map) pointers returned by `find` survive later inserts.
+  /// Iteration follows insertion order; there is no erase.
+  template <typename V>
+  class UidMap {
+
+    UidIndex m_index;
+    std::deque<std::pair<NodeUID, V>> m_entries;
+
+  public:
+
+    using value_type = std::pair<NodeUID, V>;
+    using iterator = typename std::deque<value_type>::iterator;
+    using const_iterator = typename std::deque<value_type>::const_iterator;
+
+    /// nullptr if there is no value for `uid`
+    V* find(const NodeUID& uid) {
+      const int32_t idx = m_index.get(uid);
+      return idx == -1 ? nullptr : &m_entries[idx].second;
+    }
+
+    const V* find(const NodeUID& uid) const {
+      const int32_t idx = m_index.get(uid);
+      return idx == -1 ? nullptr : &m_entries[idx].second;
+    }
+
+    size_t count(const NodeUID& uid) const { return m_index.contains(uid) ? 1 : 0; }
+
+    const V& at(const NodeUID& uid) const {
+      const V* value = find(uid);
+      if (!value) throw std::out_of_range("UidMap::at: " + to_string(uid));
+      return *value;
+    }
+
+    V& operator[](const NodeUID& uid) {
+      const int32_t idx = m_index.get(uid);
+      if (idx != -1) return m_entries[idx].second;
+
+      m_index.set(uid, static_cast<int32_t>(m_entries.size()));
+      m_entries.emplace_back(uid, V{});
+      return m_entries.back().second;
+    }
+
+    template <typename It>
+    void insert(It first, It last) {
+      for (; first != last; ++first) {
+        if (!count(first->first)) (*this)[first->first] = first->second;
+      }
+    }
+
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+    const_iterator cbegin() const { return m_entries.cbegin(); }
+    const_iterator cend() const { return m_entries.cend(); }
+
+    void clear() {
+      m_index.clear();
+      m_entries.clear();
+    }
+  };
+
+}
@@ -21,8 +21,11 @@
 #include "namemap.hh"
 #include "cpprofiler/utils/utils.hh"
 #include "cpprofiler/utils/literals.hh"
+#include "tracefile.hh"
+#include "nodebatch.hh"
+#include "execution.hh"
+#include "nodetree.hh"
 
-#include "third-party/json.hpp"
 
 #include <iostream>
 #include <qdebug.h>
@@ -31,8 +34,12 @@
 #include <QString>
 #include <QThread>
 #include <ctime>
+#include <thread>
+#include <algorithm>
 
 #include "visualnode.hh"
+#include "libs/perf_helper.hh"
+#include "cpprofiler/utils/process_memory.hh"
 
 using namespace std;
 using namespace std::chrono;
@@ -46,13 +53,13 @@ ostream& operator<<(ostream& s, const NodeUID& uid) {
 
 ostream& operator<<(ostream& s, const DbEntry& e) {
     s << "dbEntry: {";
-    s << " uid: "   << e.nodeUID;
-    s << " p_uid: " << e.parentUID;
-    s << " gid: "   << e.gid;
-    s << " alt: "   << e.alt;
-    s << " kids: "  << e.numberOfKids;
-    s << " tid: "   << e.thread_id;
-    s << " restart: "  << e.nodeUID.rid;
+    s << " uid: "   << e.nodeUID();
+    s << " p_uid: " << e.parentUID();
+    s << " gid: "   << e.gid();
+    s << " alt: "   << e.alt();
+    s << " kids: "  << e.numberOfKids();
+    s << " tid: "   << e.threadId();
+    s << " restart: "  << e.nodeUID().rid;
     s << " }";
     return s;
 }
@@ -101,6 +108,12 @@ class NodeTimer {
     finished = true;
   }
 
+  /// End at `last_node` if that is later than this timer's own last node
+  void end(TP last_node) {
+    if (last_node > current_time) current_time = last_node;
+    end();
+  }
+
   uint64_t on_node() {
     current_time = system_clock::now();
 
@@ -111,10 +124,37 @@ class NodeTimer {
     return time_passed;
   }
 
+  /// time of the last node relative to the start
+  uint64_t since_start() { return microseconds_passed(begin_time, current_time); }
+
+  TP last_node_time() const { return current_time; }
+
   uint64_t total_time() { return finished ? m_total_time : 0; }
 };
 
-Data::Data() : search_timer{new NodeTimer}, nameMap{nullptr} {}
+/// Number of decoded nodes a source's queue can hold before
+/// its producer has to wait for the builder
+static constexpr size_t INGEST_QUEUE_CAPACITY = 1 << 16;
+
+class IngestSource {
+public:
+    utils::SpscQueue<NodeRecord> queue{INGEST_QUEUE_CAPACITY};
+    /// node times are measured per producer
+    NodeTimer timer;
+    bool closed = false;
+};
+
+IngestLimits IngestLimits::defaults() {
+    IngestLimits res;
+    const uint64_t physical = utils::physicalBytes();
+    res.spill_memory = physical / 2;
+    res.stats_memory = physical / 4 * 3;
+    return res;
+}
+
+Data::Data()
+    : search_timer{new NodeTimer},
+      nameMap{nullptr} {}
 
 void Data::initReceiving() {
     QMutexLocker locker(&dataMutex);
@@ -122,119 +162,663 @@ void Data::initReceiving() {
     search_timer->start();
 }
 
-void Data::setDoneReceiving() {
-    QMutexLocker locker(&dataMutex);
+IngestSource* Data::openSource() {
+    std::lock_guard<std::mutex> lk(sources_mutex);
+
+    sources.emplace_back(new IngestSource);
+    sources.back()->timer.start();
+    ++open_sources;
+
+    return sources.back().get();
+}
+
+bool Data::closeSource(IngestSource* source) {
+    /// `search_timer` sees no nodes (the sources time them):
+    /// the search ends with the last node of any source
+    TP last_node;
+    {
+        std::lock_guard<std::mutex> lk(sources_mutex);
+        if (source->closed) return false;
+        source->closed = true;
+        if (--open_sources > 0) return false;
+
+        last_node = source->timer.last_node_time();
+        for (auto& other : sources) {
+            last_node = std::max(last_node, other->timer.last_node_time());
+        }
+    }
 
-    search_timer->end();
+    {
+        QMutexLocker locker(&dataMutex);
+        search_timer->end(last_node);
+    }
 
     _isDone = true;
+
+    /// wake up the builder if it is waiting for more nodes
+    std::lock_guard<std::mutex> lk(ingest_mutex);
+    ingest_cond.notify_one();
+
+    return true;
 }
 
-void Data::handleNodeCallback(const cpprofiler::Message& node) {
-    QMutexLocker locker(&dataMutex);
-    uint64_t node_time = search_timer->on_node();
+void Data::wakeBuilder() {
+    if (builder_waiting.load()) {
+        std::lock_guard<std::mutex> lk(ingest_mutex);
+        ingest_cond.notify_one();
+    }
+}
+
+/// NOTE(maxim): this runs on the receiver thread and must not take
+/// `dataMutex`: the node only becomes visible once the builder commits it
+void Data::handleNodeCallback(IngestSource* source, const cpprofiler::Message& node) {
+    uint64_t node_time = source->timer.on_node();
+    uint64_t time_stamp = source->timer.since_start();
 
     auto n_uid = node.nodeUID();
     auto p_uid = node.parentUID();
 
-    NodeUID nodeUID {n_uid.nid, n_uid.rid, n_uid.tid};
-    NodeUID parentUID {p_uid.nid, p_uid.rid, p_uid.tid};
+    NodeRecord rec;
+    rec.nodeUID = NodeUID{n_uid.nid, n_uid.rid, n_uid.tid};
+    rec.parentUID = NodeUID{p_uid.nid, p_uid.rid, p_uid.tid};
+    rec.alt = node.alt();
+    rec.numberOfKids = node.kids();
+    rec.status = node.status();
+    rec.thread_id = n_uid.tid;
+    rec.node_time = node_time;
+    rec.time_stamp = time_stamp;
+
+    if (node.has_label()) rec.label = node.label();
+    if (node.has_info()) rec.info = node.info();
+    if (node.has_nogood()) rec.nogood = node.nogood();
+
+    handleNodeRecord(source, std::move(rec));
+}
+
+bool Data::handleNodeBatch(IngestSource* source, const char* payload, size_t size) {
+
+    nodebatch::Decoder decoder(payload, size);
+
+    /// the nodes arrived together: split the time since the
+    /// previous node evenly between them
+    const uint64_t batch_time = source->timer.on_node();
+    const uint64_t time_stamp = source->timer.since_start();
+    const uint64_t node_time = decoder.count() > 0 ? batch_time / decoder.count() : 0;
+
+    NodeRecord rec;
+    while (decoder.next(rec)) {
+        rec.node_time = node_time;
+        rec.time_stamp = time_stamp;
+        handleNodeRecord(source, std::move(rec));
+    }
+
+    return !decoder.error();
+}
+
+void Data::handleNodeRecord(IngestSource* source, NodeRecord&& rec) {
+    /// seq_cst, so that either the builder sees the node or we see it waiting
+    source->queue.push(std::move(rec));
+    ++nodes_ingested;
+    wakeBuilder();
+}
+
+void Data::saveNodes(tracefile::Writer& writer) const {
+    QMutexLocker locker(&dataMutex);
+
+    NodeRecord rec;
+
+    for (auto aid = 0u; aid < nodes.size(); ++aid) {
+        const auto& uid = nodes.uid(aid);
+
+        rec.nodeUID = uid;
+        rec.parentUID = nodes.parentUID(aid);
+        rec.alt = nodes.alt(aid);
+        rec.numberOfKids = nodes.kids(aid);
+        rec.thread_id = nodes.tid(aid);
+        rec.status = nodes.status(aid);
+        rec.time_stamp = nodes.timeStamp(aid);
+        rec.node_time = nodes.nodeTime(aid);
+        rec.label = nodes.label(aid);
+
+        /// NOTE(maxim): straight from the trace, so that saving a lazily
+        /// loaded execution does not pull everything into memory
+        auto ng = uid2nogood.find(uid);
+        if (ng) {
+            rec.nogood = ng->original;
+        } else if (auto ref = uid2spilled_nogood.find(uid)) {
+            rec.nogood = spill->read(*ref);
+        } else {
+            rec.nogood = lazy_trace ? lazy_trace->nogood(aid) : std::string{};
+        }
+
+        auto info = uid2info.find(uid);
+        if (info) {
+            rec.info = **info;
+        } else if (auto ref = uid2spilled_info.find(uid)) {
+            rec.info = spill->read(*ref);
+        } else {
+            rec.info = lazy_trace ? lazy_trace->info(aid) : std::string{};
+        }
+
+        writer.addNode(rec);
+    }
+}
+
+bool Data::isBackedUp(const IngestSource* source) const {
+    return source->queue.size() > source->queue.capacity() / 2;
+}
+
+void Data::checkMemory() {
+    if (ingestMode() == IngestMode::STATS_ONLY) return;
+
+    const auto now = steady_clock::now();
+    if (now - last_memory_check < milliseconds(250)) return;
+    last_memory_check = now;
+
+    const uint64_t resident = utils::residentBytes();
+    if (resident == 0) return;
+
+    if (limits.stats_memory > 0 && resident > limits.stats_memory) {
+        escalate(IngestMode::STATS_ONLY);
+    } else if (limits.spill_memory > 0 && resident > limits.spill_memory) {
+        escalate(IngestMode::SPILL);
+    }
+}
+
+void Data::escalate(IngestMode mode) {
+    if (mode <= ingestMode()) return;
+
+    if (mode == IngestMode::SPILL) {
+        spill.reset(new utils::SpillFile);
+        std::cerr << "overloaded: nogoods and info go to a spill file from now on\n";
+    } else {
+        std::cerr << "overloaded: further nodes are only counted, not drawn\n";
+    }
+
+    ingest_mode.store(static_cast<int>(mode));
+}
+
+void Data::spillBatch() {
+    spill_batch.clear();
+    if (!spill || !spill->isOpen()) return;
+
+    spill_batch.resize(commit_batch.size());
+
+    for (size_t i = 0; i < commit_batch.size(); ++i) {
+        auto& rec = commit_batch[i];
+        auto& refs = spill_batch[i];
+
+        /// on failure the string simply stays in memory
+        if (!rec.nogood.empty() && spill->write(rec.nogood, refs.first)) {
+            std::string().swap(rec.nogood);
+        }
+        if (!rec.info.empty() && spill->write(rec.info, refs.second)) {
+            std::string().swap(rec.info);
+        }
+    }
+}
+
+void Data::countNode(const NodeRecord& rec) {
+    ++counted.total;
+
+    switch (rec.status) {
+        case SOLVED: ++counted.solved; break;
+        case FAILED: ++counted.failed; break;
+        case BRANCH: ++counted.branch; break;
+        case SKIPPED: ++counted.skipped; break;
+        default: break;
+    }
+
+    /// same as the builder: roots are at depth 1
+    int32_t depth = -1;
+    if (rec.parentUID.nid == -1) {
+        depth = 1;
+    } else {
+        const int32_t parent_aid = uid2aid.get(rec.parentUID);
+        const int32_t parent_depth = parent_aid != -1 ? nodes.depth(parent_aid)
+                                                      : counted_depth.get(rec.parentUID);
+        if (parent_depth != -1) depth = parent_depth + 1;
+    }
+
+    if (depth != -1) {
+        counted_depth.set(rec.nodeUID, depth);
+        if (counted.by_depth.size() <= static_cast<size_t>(depth)) {
+            counted.by_depth.resize(depth + 1, 0);
+        }
+        ++counted.by_depth[depth];
+    }
+
+    const size_t second = rec.time_stamp / 1000000;
+    if (counted.per_second.size() <= second) counted.per_second.resize(second + 1, 0);
+    ++counted.per_second[second];
+}
 
-    auto entry = new DbEntry(nodeUID, parentUID, node.alt(), node.kids(), node.status());
+CountedNodes Data::countedNodes() const {
+    QMutexLocker locker(&dataMutex);
+    return counted;
+}
+
+bool Data::hasPendingNodes() const {
+    std::lock_guard<std::mutex> lk(sources_mutex);
+    for (auto& source : sources) {
+        if (!source->queue.empty()) return true;
+    }
+    return false;
+}
 
-    entry->node_time = node_time;
+void Data::waitForNodes() {
+    std::unique_lock<std::mutex> lk(ingest_mutex);
+    builder_waiting.store(true);
+    ingest_cond.wait_for(lk, std::chrono::milliseconds(100), [this]() {
+        return _isDone.load() || hasPendingNodes();
+    });
+    builder_waiting.store(false);
+}
 
-    entry->label = node.has_label() ? node.label() : "";
+size_t Data::commitPendingNodes(size_t max_count) {
 
-    if (node.has_info() && node.info().length() > 0) {
-        uid2info[nodeUID] = make_shared<std::string>(node.info());
+    auto& batch = commit_batch;
+    batch.clear();
 
-        // try {
-        //     auto info_json = nlohmann::json::parse(node.info());
-        //     auto obj_value = info_json.find("objective");
+    {
+        /// round-robin, so that one busy connection doesn't starve the others
+        std::lock_guard<std::mutex> lk(sources_mutex);
+        const size_t count = sources.size();
+        for (size_t i = 0; i < count && batch.size() < max_count; ++i) {
+            auto& queue = sources[(next_source + i) % count]->queue;
+            queue.popMany(batch, max_count - batch.size());
+        }
+        if (count > 0) next_source = (next_source + 1) % count;
+    }
 
-        //     if(obj_value != info_json.end()) {
-        //         auto el = (*obj_value)[0];
-        //         if (el.is_number()) {
-        //             uid2obj[nodeUID] = el.get<int>();
-        //         }
-        //     }
-        // } catch (std::exception& e) {
-        //     // std::cerr << "Can't parse json near objective: " << e.what() << "\n";
-        // }
+    if (batch.empty()) return 0;
 
+    checkMemory();
+
+    /// the file is written to before `dataMutex` is taken
+    if (ingestMode() == IngestMode::SPILL) {
+        spillBatch();
+    } else {
+        spill_batch.clear();
     }
 
-    pushInstance(entry);
+    QMutexLocker locker(&dataMutex);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+
+        auto& rec = batch[i];
+
+        if (limits.node_budget > 0 && nodes.size() >= limits.node_budget) {
+            escalate(IngestMode::STATS_ONLY);
+        }
+
+        if (ingestMode() == IngestMode::STATS_ONLY) {
+            countNode(rec);
+            continue;
+        }
+
+        /// NOTE: don't distinguish between -1 and 0
+        /// -1 is the default for Chuffed and 0 -- for Gecode
+        if (rec.thread_id == -1) { rec.thread_id = 0; }
+
+        int32_t aid;
+        if (rec.label_id >= 0) {
+            aid = nodes.addInterned(rec.nodeUID, rec.parentUID, rec.alt,
+                                    rec.numberOfKids, rec.thread_id, rec.status,
+                                    rec.time_stamp, rec.node_time,
+                                    trace_label_ids[rec.label_id]);
+        } else {
+            aid = nodes.add(rec.nodeUID, rec.parentUID, rec.alt,
+                            rec.numberOfKids, rec.thread_id, rec.status,
+                            rec.time_stamp, rec.node_time, rec.label);
+        }
+
+        /// NOTE(maxim): `sid` != `aid`, because there are also
+        /// '-1' nodes (backjumped) that dont get counted
+        uid2aid.set(rec.nodeUID, aid);
 
-    if (node.has_nogood() && node.nogood().length() > 0) {
+        if (rec.info.length() > 0) {
+            uid2info[rec.nodeUID] = make_shared<std::string>(std::move(rec.info));
+            pending_info.push_back(rec.nodeUID);
+        }
 
-        /// simplify nogood here
-        NogoodViews ng(node.nogood());
+        if (rec.nogood.length() > 0) {
 
-        if (nameMap) {
-            string renamed = nameMap->replaceNames(ng.original, true);
-            ng.renamed = utils::lits::remove_redundant_wspaces(renamed);
-            ng.simplified = utils::lits::simplify_ng(ng.renamed);
+            uid2nogood[rec.nodeUID] = NogoodViews(std::move(rec.nogood));
+            pending_views.push_back(rec.nodeUID);
         }
 
-        uid2nogood[entry->nodeUID] = ng;
+        if (!spill_batch.empty()) {
+            const auto& refs = spill_batch[i];
+            if (refs.first.length > 0) uid2spilled_nogood[rec.nodeUID] = refs.first;
+            if (refs.second.length > 0) uid2spilled_info[rec.nodeUID] = refs.second;
+        }
     }
+
+    if ((!pending_views.empty() && nameMap) || !pending_info.empty()) {
+        scheduleDecoding();
+    }
+
+    return batch.size();
 }
 
 std::string Data::getLabel(int gid) {
     QMutexLocker locker(&dataMutex);
-    auto it = gid2entry.find(gid);
-    if (it != gid2entry.end() && it->second != nullptr) {
-        return it->second->label;
+    auto entry = getEntry(gid);
+    if (entry) {
+        return entry.label();
     }
     return "";
 
 }
 
+int32_t Data::getLabelId(int gid) const {
+    QMutexLocker locker(&dataMutex);
+    auto entry = getEntry(gid);
+    return entry ? entry.labelId() : 0;
+}
+
 NodeUID Data::gid2uid(int gid) const {
     QMutexLocker locker(&dataMutex);
 
     /// not for any gid there is entry (TODO: there should be a 'default' one)
-    auto it = gid2entry.find(gid);
-    if (it != gid2entry.end())
-        return gid2entry.at(gid)->nodeUID;
+    auto entry = getEntry(gid);
+    if (entry)
+        return entry.nodeUID();
     return {-1, -1, -1};
 
 }
 
+void Data::connectNodeToEntry(int gid, DbEntry entry) {
+    if (entry.store() == &nodes) {
+        gid2aid.resize(gid + 1, -1);
+        gid2aid[gid] = entry.aid();
+    } else {
+        gid2foreign[gid] = entry;
+    }
+}
+
+void Data::assignGid(int32_t aid, int32_t gid, int32_t depth) {
+    nodes.setGid(aid, gid);
+    nodes.setDepth(aid, depth);
+    gid2aid.resize(gid + 1, -1);
+    gid2aid[gid] = aid;
+}
+
 uint64_t Data::getTotalTime() {
     QMutexLocker locker(&dataMutex);
     return search_timer->total_time();
 }
 
-
+/// NOTE(maxim): columns are released a segment at a time
 Data::~Data(void) {
+    if (decoder.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(decoder_mutex);
+            decoder_stop = true;
+        }
+        decoder_cond.notify_one();
+        decoder.join();
+    }
+}
+
+static void renameNogood(const NameMap& names, const std::string& original,
+                         std::string& renamed, std::string& simplified) {
+    renamed = utils::lits::remove_redundant_wspaces(names.replaceNames(original, true));
+    simplified = utils::lits::simplify_ng(renamed);
+}
+
+void Data::makeViews(NogoodViews& ng) const {
+    if (ng.has_views || !nameMap) return;
+
+    renameNogood(*nameMap, ng.original, ng.renamed, ng.simplified);
+    ng.has_views = true;
+}
+
+void Data::storeDecoded(const NodeUID& uid, NodeInfo&& info) {
+    if (info.has_objective) uid2obj[uid] = info.objective;
+    uid2decoded[uid] = std::move(info);
+}
+
+const NodeInfo* Data::decodedInfo(const NodeUID& uid) {
+    if (auto info = uid2decoded.find(uid)) return info;
+
+    auto raw = getInfo(uid);
+    if (!raw) return nullptr;
+
+    storeDecoded(uid, nodeinfo::parse(*raw));
+    return uid2decoded.find(uid);
+}
+
+void Data::scheduleDecoding() {
+    {
+        std::lock_guard<std::mutex> lk(decoder_mutex);
+        decoder_has_work = true;
+    }
+
+    if (!decoder.joinable()) {
+        decoder = std::thread(&Data::decodeInBackground, this);
+    } else {
+        decoder_cond.notify_one();
+    }
+}
+
+/// Takes a few nogoods/infos at a time, so that `dataMutex` is only held
+/// for copying them out and storing the results
+void Data::decodeInBackground() {
+
+    constexpr size_t DECODE_BATCH = 256;
+
+    struct RenameJob {
+        NodeUID uid;
+        std::string original;
+        std::string renamed;
+        std::string simplified;
+    };
+
+    struct InfoJob {
+        NodeUID uid;
+        /// shared with `uid2info`, no need to copy the text
+        std::shared_ptr<std::string> raw;
+        NodeInfo decoded;
+    };
+
+    std::vector<RenameJob> rename_jobs;
+    std::vector<InfoJob> info_jobs;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(decoder_mutex);
+            decoder_cond.wait(lk, [this]() { return decoder_has_work || decoder_stop; });
+            if (decoder_stop) return;
+            decoder_has_work = false;
+        }
+
+        while (!decoder_stop) {
+
+            const NameMap* names;
+
+            rename_jobs.clear();
+            info_jobs.clear();
+            {
+                QMutexLocker locker(&dataMutex);
+                names = nameMap;
+
+                while (names && !pending_views.empty() && rename_jobs.size() < DECODE_BATCH) {
+                    const NodeUID uid = pending_views.back();
+                    pending_views.pop_back();
+
+                    auto ng = uid2nogood.find(uid);
+                    if (ng && !ng->has_views) {
+                        rename_jobs.push_back(RenameJob{uid, ng->original, {}, {}});
+                    }
+                }
+
+                while (!pending_info.empty() && info_jobs.size() < DECODE_BATCH) {
+                    const NodeUID uid = pending_info.back();
+                    pending_info.pop_back();
+
+                    auto raw = uid2info.find(uid);
+                    if (raw && *raw && !uid2decoded.count(uid)) {
+                        info_jobs.push_back(InfoJob{uid, *raw, {}});
+                    }
+                }
+            }
+
+            if (rename_jobs.empty() && info_jobs.empty()) break;
+
+            for (auto& job : rename_jobs) {
+                renameNogood(*names, job.original, job.renamed, job.simplified);
+            }
+
+            for (auto& job : info_jobs) {
+                job.decoded = nodeinfo::parse(*job.raw);
+            }
+
+            QMutexLocker locker(&dataMutex);
+            for (auto& job : rename_jobs) {
+                auto ng = uid2nogood.find(job.uid);
+                if (ng && !ng->has_views) {
+                    ng->renamed = std::move(job.renamed);
+                    ng->simplified = std::move(job.simplified);
+                    ng->has_views = true;
+                }
+            }
+
+            for (auto& job : info_jobs) {
+                if (!uid2decoded.count(job.uid)) {
+                    storeDecoded(job.uid, std::move(job.decoded));
+                }
+            }
+        }
+    }
+}
+
+void Data::attachTrace(std::shared_ptr<const tracefile::Reader> trace) {
+    QMutexLocker locker(&dataMutex);
+
+    lazy_trace = std::move(trace);
+
+    trace_label_ids.clear();
+    for (const auto& label : lazy_trace->labels()) {
+        trace_label_ids.push_back(nodes.internLabel(label));
+    }
+}
+
+const Uid2Nogood& Data::getNogoods(void) {
     QMutexLocker locker(&dataMutex);
-    for (auto it = nodes_arr.begin(); it != nodes_arr.end();) {
-        delete (*it);
-        it = nodes_arr.erase(it);
+
+    if (lazy_trace && !lazy_nogoods_complete) {
+        for (auto aid = 0u; aid < nodes.size(); ++aid) {
+            const auto& uid = nodes.uid(aid);
+            if (uid2nogood.find(uid)) continue;
+
+            auto nogood = lazy_trace->nogood(aid);
+            if (!nogood.empty()) {
+                uid2nogood[uid] = NogoodViews(std::move(nogood));
+            }
+        }
+
+        /// later calls have nothing to add once all nodes are in
+        lazy_nogoods_complete = _isDone && nodes.size() >= lazy_trace->nodeCount();
+    }
+
+    for (auto& kv : uid2spilled_nogood) {
+        if (uid2nogood.find(kv.first)) continue;
+        auto nogood = spill->read(kv.second);
+        if (!nogood.empty()) uid2nogood[kv.first] = NogoodViews(std::move(nogood));
+    }
+
+    /// whatever the decoder hasn't got to yet
+    for (auto& kv : uid2nogood) {
+        makeViews(kv.second);
     }
+
+    return uid2nogood;
 }
 
-/// ***********************
-/// *** private methods ***
-/// ***********************
+const NogoodViews* Data::findNogood(const NodeUID& uid) {
+    QMutexLocker locker(&dataMutex);
+
+    if (auto ng = uid2nogood.find(uid)) {
+        makeViews(*ng);
+        return ng;
+    }
+
+    /// brought back into memory for good: the caller keeps the pointer
+    if (auto ref = uid2spilled_nogood.find(uid)) {
+        auto nogood = spill->read(*ref);
+        if (nogood.empty()) return nullptr;
+        auto& ng = uid2nogood[uid];
+        ng = NogoodViews(std::move(nogood));
+        makeViews(ng);
+        return &ng;
+    }
+
+    if (!lazy_trace) return nullptr;
 
-// NOTE(maxim): this can be replaced with multiple arrays: one for each restart 
-void Data::pushInstance(DbEntry* entry) {
+    const int32_t aid = uid2aid.get(uid);
+    if (aid == -1) return nullptr;
+
+    auto it = lazy_nogoods.find(aid);
+    if (it == lazy_nogoods.end()) {
+        auto nogood = lazy_trace->nogood(aid);
+        if (nogood.empty()) return nullptr;
+        it = lazy_nogoods.emplace(aid, NogoodViews(std::move(nogood))).first;
+    }
+
+    makeViews(it->second);
+    return &it->second;
+}
+
+std::shared_ptr<std::string> Data::getInfo(const NodeUID& uid) {
     QMutexLocker locker(&dataMutex);
 
-    /// NOTE(maxim): `sid` != `nodes_arr.size`, because there are also
-    /// '-1' nodes (backjumped) that dont get counted
+    if (auto info = uid2info.find(uid)) return *info;
+
+    /// brought back into memory for good: `Execution::getInfo` hands
+    /// out the raw pointer
+    if (auto ref = uid2spilled_info.find(uid)) {
+        auto info = spill->read(*ref);
+        if (info.empty()) return nullptr;
+        auto& kept = uid2info[uid];
+        kept = make_shared<std::string>(std::move(info));
+        return kept;
+    }
+
+    if (!lazy_trace) return nullptr;
+
+    const int32_t aid = uid2aid.get(uid);
+    if (aid == -1) return nullptr;
+
+    auto it = lazy_info.find(aid);
+    if (it == lazy_info.end()) {
+        auto info = lazy_trace->info(aid);
+        if (info.empty()) return nullptr;
+        it = lazy_info.emplace(aid, make_shared<std::string>(std::move(info))).first;
+    }
+
+    return it->second;
+}
 
-    nodes_arr.push_back(entry);
-    uid2aid[entry->nodeUID] = nodes_arr.size() - 1;
+NodeInfo Data::getNodeInfo(const NodeUID& uid) {
+    QMutexLocker locker(&dataMutex);
+    auto info = decodedInfo(uid);
+    return info ? *info : NodeInfo{};
+}
+
+const int* Data::getObjective(NodeUID uid) {
+    QMutexLocker locker(&dataMutex);
+    decodedInfo(uid);
+    return uid2obj.find(uid);
 }
 
 void Data::setNameMap(NameMap* names) {
     QMutexLocker locker(&dataMutex);
     nameMap = names;
+
+    /// nogoods received before the name map was known
+    if (nameMap && !pending_views.empty()) scheduleDecoding();
 }
 
 #ifdef MAXIM_DEBUG
@@ -243,21 +827,18 @@ void Data::setNameMap(NameMap* names) {
 void Data::setLabel(int gid, const std::string& str) {
     QMutexLocker locker(&dataMutex);
 
-    auto it = gid2entry.find(gid);
-    if (it != gid2entry.end() && it->second != nullptr) {
-        it->second->label = str;
+    auto entry = getEntry(gid);
+    if (entry && entry.store() == &nodes) {
+        nodes.setLabel(entry.aid(), str);
     } else {
-        auto entry = new DbEntry{};
-        nodes_arr.push_back(entry);
-        gid2entry[gid] = entry;
-
         static int dummy_sid = 0;
         dummy_sid++;
         NodeUID dummy_uid{dummy_sid, -1, -1};
+        NodeUID no_parent{-1, -1, -1};
 
-        uid2aid[dummy_uid] = nodes_arr.size() - 1;
-
-        entry->label = str;
+        auto aid = nodes.add(dummy_uid, no_parent, 0, 0, 0, 0, 0, 0, str);
+        uid2aid.set(dummy_uid, aid);
+        connectNodeToEntry(gid, DbEntry{&nodes, aid});
     }
 }
 
@@ -265,9 +846,9 @@ const std::string Data::getDebugInfo() const {
     QMutexLocker locker(&dataMutex);
     std::ostringstream os;
 
-    os << "---nodes_arr---" << '\n';
-    for (auto it = nodes_arr.cbegin(); it != nodes_arr.end(); ++it) {
-      os << **(it) << "\n";
+    os << "---nodes---" << '\n';
+    for (auto aid = 0u; aid < nodes.size(); ++aid) {
+      os << DbEntry{&nodes, static_cast<int32_t>(aid)} << "\n";
     }
     os << "---------------" << '\n';
 
@@ -283,3 +864,232 @@ const std::string Data::getDebugInfo() const {
 
 #endif
 
+
+namespace ingest {
+
+    static NodeRecord makeNode(int32_t nid, int32_t tid) {
+        NodeRecord rec;
+        rec.nodeUID = NodeUID{nid, 0, tid};
+        rec.parentUID = NodeUID{nid / 2, 0, tid};
+        rec.alt = nid % 2;
+        rec.numberOfKids = 2;
+        rec.status = 2;
+        rec.thread_id = tid;
+        rec.label = "x := " + std::to_string(nid % 100);
+        return rec;
+    }
+
+    /// What the builder does with the ingest side of Data
+    static void drain(Data& data) {
+        while (true) {
+            data.commitPendingNodes(4096);
+            if (data.isDone() && !data.hasPendingNodes()) break;
+            if (!data.hasPendingNodes()) data.waitForNodes();
+        }
+    }
+
+    /// `producers` connections (one thread each) feed the same Data
+    static bool sharedExecution(int producers, int nodes_each) {
+
+        Data data;
+        data.initReceiving();
+        std::vector<IngestSource*> sources;
+        for (int p = 0; p < producers; ++p) sources.push_back(data.openSource());
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&data, &sources, p, nodes_each]() {
+                for (int32_t nid = 0; nid < nodes_each; ++nid) {
+                    data.handleNodeRecord(sources[p], makeNode(nid, p));
+                }
+                data.closeSource(sources[p]);
+            });
+        }
+
+        drain(data);
+        for (auto& t : threads) t.join();
+
+        if (data.size() != producers * nodes_each) return false;
+        /// timed by the sources, not by the execution's own timer
+        if (data.getTotalTime() == 0) return false;
+
+        for (int p = 0; p < producers; ++p) {
+            for (int32_t nid = 0; nid < nodes_each; ++nid) {
+                if (!data.uid2aid.contains(NodeUID{nid, 0, p})) return false;
+            }
+        }
+        return true;
+    }
+
+    /// `pipelines` independent executions, each with its own connection
+    /// and builder; returns nodes per second over all of them
+    static double throughput(int pipelines, int nodes_each, bool& committed) {
+
+        std::vector<std::unique_ptr<Data>> datas;
+        for (int i = 0; i < pipelines; ++i) datas.emplace_back(new Data);
+
+        perf_helper::Timer timer;
+        timer.begin();
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < pipelines; ++i) {
+            Data& data = *datas[i];
+            threads.emplace_back([&data, nodes_each]() {
+                auto source = data.openSource();
+                for (int32_t nid = 0; nid < nodes_each; ++nid) {
+                    data.handleNodeRecord(source, makeNode(nid, 0));
+                }
+                data.closeSource(source);
+            });
+            threads.emplace_back([&data]() { drain(data); });
+        }
+        for (auto& t : threads) t.join();
+
+        const auto ms = std::max<int64_t>(timer.end(), 1);
+
+        committed = true;
+        for (auto& data : datas) {
+            if (data->size() != nodes_each) committed = false;
+        }
+
+        return 1000.0 * pipelines * nodes_each / ms;
+    }
+
+    /// Past the node budget nodes are counted instead of stored
+    static bool nodeBudget(int nodes_total, uint64_t budget) {
+
+        Data data;
+        IngestLimits limits;
+        limits.node_budget = budget;
+        data.setIngestLimits(limits);
+
+        auto source = data.openSource();
+
+        /// up to the budget (fewer records than the queue holds): stored,
+        /// then given their depth as the builder would (node `nid` hangs
+        /// under node `nid / 2`)
+        for (int32_t nid = 0; nid < static_cast<int32_t>(budget); ++nid) {
+            data.handleNodeRecord(source, makeNode(nid, 0));
+        }
+        while (static_cast<uint64_t>(data.size()) < budget) data.commitPendingNodes(4096);
+
+        std::vector<int32_t> depth(budget, 1);
+        for (int32_t nid = 0; nid < static_cast<int32_t>(budget); ++nid) {
+            if (nid > 0) depth[nid] = depth[nid / 2] + 1;
+            data.assignGid(data.uid2aid.get(NodeUID{nid, 0, 0}), nid, depth[nid]);
+        }
+
+        /// past it: more records than the queue holds, so they are
+        /// drained while they arrive
+        std::thread producer([&data, source, budget, nodes_total]() {
+            for (int32_t nid = static_cast<int32_t>(budget); nid < nodes_total; ++nid) {
+                data.handleNodeRecord(source, makeNode(nid, 0));
+            }
+            data.closeSource(source);
+        });
+
+        drain(data);
+        producer.join();
+
+        const auto counted = data.countedNodes();
+
+        uint64_t with_depth = 0;
+        for (auto n : counted.by_depth) with_depth += n;
+
+        return data.ingestMode() == IngestMode::STATS_ONLY &&
+               static_cast<uint64_t>(data.size()) == budget &&
+               counted.total == nodes_total - budget &&
+               counted.branch == counted.total && with_depth == counted.total;
+    }
+
+    /// Nogoods and info that went to the spill file come back intact
+    static bool spilling(int nodes_total) {
+
+        std::unique_ptr<Data> owned{new Data};
+        Data& data = *owned;
+        IngestLimits limits;
+        /// any process is over this
+        limits.spill_memory = 1;
+        data.setIngestLimits(limits);
+
+        auto source = data.openSource();
+        for (int32_t nid = 0; nid < nodes_total; ++nid) {
+            auto rec = makeNode(nid, 0);
+            rec.nogood = "ng" + std::to_string(nid);
+            rec.info = "info" + std::to_string(nid);
+            data.handleNodeRecord(source, std::move(rec));
+        }
+        data.closeSource(source);
+        drain(data);
+
+        if (data.ingestMode() != IngestMode::SPILL || data.size() != nodes_total) {
+            return false;
+        }
+
+        /// through Execution, as the GUI asks: the pointers it hands
+        /// out are only checked once all of them have been taken
+        Execution ex{std::unique_ptr<NodeTree>{new NodeTree}, std::move(owned)};
+        std::vector<const std::string*> infos;
+        for (int32_t nid = 0; nid < nodes_total; ++nid) {
+            auto info = ex.getInfo(NodeUID{nid, 0, 0});
+            if (!info) return false;
+            infos.push_back(info);
+        }
+        for (int32_t nid = 0; nid < nodes_total; ++nid) {
+            if (*infos[nid] != "info" + std::to_string(nid)) return false;
+        }
+
+        /// the nogoods of every 7th node are looked up on their own
+        for (int32_t nid = 0; nid < nodes_total; nid += 7) {
+            auto ng = data.findNogood(NodeUID{nid, 0, 0});
+            if (!ng || ng->original != "ng" + std::to_string(nid)) return false;
+        }
+
+        return data.getNogoods().size() == static_cast<size_t>(nodes_total);
+    }
+
+    void test_module() {
+
+        if (sharedExecution(4, 100000)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (nodes lost between sources or no total time)\n";
+        }
+
+        /// every pipeline takes two threads (receiver and builder)
+        const int max_pipelines = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+        constexpr int NODES = 500000;
+
+        bool passed = true;
+        double base = 0;
+
+        for (int k = 1; k <= max_pipelines; k *= 2) {
+            bool committed;
+            const double nps = throughput(k, NODES, committed);
+            if (k == 1) base = nps;
+            passed = passed && committed;
+
+            std::cout << "ingest: " << k << " connection(s): " << static_cast<int64_t>(nps)
+                      << " nodes/s, speedup " << nps / base << "\n";
+        }
+
+        if (passed) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (not every node committed)\n";
+        }
+
+        if (nodeBudget(100000, 10000)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (nodes past the budget)\n";
+        }
+
+        if (spilling(50000)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (spilled nogoods/info)\n";
+        }
+    }
+}
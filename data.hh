@@ -36,69 +36,166 @@
 
 #include <cstdint>
 #include <cassert>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include "nogood_representation.hh"
 #include "cpprofiler/universal.hh"
+#include "cpprofiler/utils/spsc_queue.hh"
+#include "cpprofiler/utils/segmented_vector.hh"
+#include "cpprofiler/utils/uid_map.hh"
+#include "cpprofiler/utils/spill_file.hh"
+#include "nodestore.hh"
+#include "nodeinfo.hh"
 
 class NameMap;
 namespace cpprofiler {
 class Message;
 }
+namespace tracefile {
+class Writer;
+class Reader;
+}
 
+/// Handle to a node in a NodeStore (possibly owned by another Data
+/// instance, as in merged trees); cheap to copy, false if not set
 class DbEntry {
 
-public:
-    DbEntry(NodeUID uid, NodeUID parent_uid, int _alt, int _kids,
-            std::string _label, int tid, int _status, int64_t _time_stamp,
-            int64_t _node_time) :
-        nodeUID(uid), parentUID(parent_uid), alt(_alt), numberOfKids(_kids), label(_label), thread_id(tid), time_stamp(_time_stamp), node_time(_node_time), status(_status)
-    {
-        /// Map message status to profiler status;
-        /// alternatively could make treebuilder use message status
-        // switch (_status) {
-        //     case 0:
-
-        //     break;
-        // }
-        // status 
-    }
-
-    DbEntry(NodeUID uid, NodeUID parent_uid, int alt, int kids, int status)
-        : nodeUID(uid),
-          parentUID(parent_uid),
-          alt(alt),
-          numberOfKids(kids),
-          status(status) {}
+    const NodeStore* m_store = nullptr;
+    int32_t m_aid = -1;
 
+public:
     DbEntry() = default;
+    DbEntry(const NodeStore* store, int32_t aid) : m_store(store), m_aid(aid) {}
+
+    explicit operator bool() const { return m_store != nullptr; }
+
+    const NodeStore* store() const { return m_store; }
+    int32_t aid() const { return m_aid; }
+
+    const NodeUID& nodeUID() const { return m_store->uid(m_aid); }
+    const NodeUID& parentUID() const { return m_store->parentUID(m_aid); }
+    int32_t gid() const { return m_store->gid(m_aid); }
+    int32_t alt() const { return m_store->alt(m_aid); } // which child by order
+    int32_t numberOfKids() const { return m_store->kids(m_aid); }
+    const std::string& label() const { return m_store->label(m_aid); }
+    /// see `utils::LabelDictionary`
+    int32_t labelId() const { return m_store->labelId(m_aid); }
+    const utils::Decision& decision() const { return m_store->decision(m_aid); }
+    int32_t threadId() const { return m_store->tid(m_aid); }
+    int32_t depth() const { return m_store->depth(m_aid); }
+    uint64_t timeStamp() const { return m_store->timeStamp(m_aid); }
+    uint64_t nodeTime() const { return m_store->nodeTime(m_aid); }
+    char status() const { return m_store->status(m_aid); }
 
     friend std::ostream& operator<<(std::ostream& s, const DbEntry& e);
-
-    NodeUID nodeUID;
-    NodeUID parentUID;
-
-    int32_t gid {-1}; // gist id, set to -1 so we don't forget to assign the real value
-    int32_t alt; // which child by order
-    int32_t numberOfKids;
-    std::string label;
-    int32_t thread_id{-1};
-    int32_t depth {-1};
-    uint64_t time_stamp{0};
-    uint64_t node_time{0};
-    char status;
 };
 
 class NodeTimer;
 
+/// One producer of nodes for a Data instance (a solver connection or a
+/// trace loader); opaque outside of data.cpp
+class IngestSource;
+
+namespace ingest { void test_module(); }
+
+/// How much of every new node is kept when the solver outpaces the
+/// profiler; only ever escalates
+enum class IngestMode : int {
+    FULL,
+    /// nogoods and info go to a spill file, read back when asked for
+    SPILL,
+    /// nodes are no longer added to the tree, only counted
+    STATS_ONLY
+};
+
+/// Thresholds of the overload policy (0 disables a check)
+struct IngestLimits {
+    /// resident memory of the process, in bytes, above which
+    /// IngestMode::SPILL / IngestMode::STATS_ONLY sets in
+    uint64_t spill_memory = 0;
+    uint64_t stats_memory = 0;
+    /// nodes kept in the tree before IngestMode::STATS_ONLY sets in
+    uint64_t node_budget = 0;
+
+    /// a half / three quarters of the machine's memory, no node budget
+    static IngestLimits defaults();
+};
+
+/// What is known of the nodes received in IngestMode::STATS_ONLY
+struct CountedNodes {
+    uint64_t total = 0;
+    uint64_t solved = 0;
+    uint64_t failed = 0;
+    uint64_t branch = 0;
+    uint64_t skipped = 0;
+    /// nodes per depth (those whose depth could be told)
+    std::vector<uint64_t> by_depth;
+    /// nodes per second since the search started
+    std::vector<uint64_t> per_second;
+};
+
 class Data : public QObject {
 Q_OBJECT
 
     std::unique_ptr<NodeTimer> search_timer;
 
-    std::vector<DbEntry*> nodes_arr;
-
-    // Whether received DONE_SENDING message
-    bool _isDone{false};
+    NodeStore nodes;
+
+    /// Decoded nodes on their way from the producers to the builder,
+    /// one queue per producer so that they never contend
+    std::vector<std::unique_ptr<IngestSource>> sources;
+    /// guards `sources` and `open_sources`
+    mutable std::mutex sources_mutex;
+    int open_sources = 0;
+    /// where the builder continues draining `sources`
+    size_t next_source = 0;
+
+    /// the builder parks on this when there is nothing to commit;
+    /// producers only touch the mutex while it is parked
+    std::mutex ingest_mutex;
+    std::condition_variable ingest_cond;
+    std::atomic<bool> builder_waiting{false};
+
+    void wakeBuilder();
+
+    /// Reused by the builder thread when committing from `sources`
+    std::vector<NodeRecord> commit_batch;
+
+    /// Nodes pushed by producers / placed into the tree so far
+    std::atomic<uint64_t> nodes_ingested{0};
+    std::atomic<uint64_t> nodes_placed{0};
+
+    /// Overload policy, applied by the builder as it commits nodes
+    IngestLimits limits = IngestLimits::defaults();
+    std::atomic<int> ingest_mode{static_cast<int>(IngestMode::FULL)};
+    std::chrono::steady_clock::time_point last_memory_check;
+
+    /// Check the resident memory (at most every few hundred ms)
+    /// and escalate `ingest_mode` if over a limit
+    void checkMemory();
+    void escalate(IngestMode mode);
+
+    /// Nogoods/info received in IngestMode::SPILL (see `getInfo` etc.)
+    std::unique_ptr<utils::SpillFile> spill;
+    utils::UidMap<utils::SpillRef> uid2spilled_nogood;
+    utils::UidMap<utils::SpillRef> uid2spilled_info;
+    /// Reused by the builder: where the strings of `commit_batch` went
+    std::vector<std::pair<utils::SpillRef, utils::SpillRef>> spill_batch;
+
+    /// Move the nogoods/info of `commit_batch` to `spill` (no locks held)
+    void spillBatch();
+
+    /// Nodes received in IngestMode::STATS_ONLY (requires `dataMutex`)
+    CountedNodes counted;
+    /// depths of the counted nodes, for their children's
+    utils::UidIndex counted_depth;
+    void countNode(const NodeRecord& rec);
+
+    // Whether every source has been closed
+    std::atomic<bool> _isDone{false};
 
     /// How many nodes received within each NODE_RATE_STEP interval
     std::vector<float> node_rate;
@@ -110,74 +207,177 @@ Q_OBJECT
 
     NameMap* nameMap;
 
+    /// Set if the nodes come from a saved trace: their nogoods and info
+    /// stay in the (mapped) file until asked for; a node's aid is then
+    /// its ordinal in the trace
+    std::shared_ptr<const tracefile::Reader> lazy_trace;
+    /// Maps label ids of `lazy_trace` to label ids of `nodes`
+    std::vector<int32_t> trace_label_ids;
+    /// Nogoods and info of `lazy_trace` resolved so far (by aid)
+    std::unordered_map<int32_t, NogoodViews> lazy_nogoods;
+    std::unordered_map<int32_t, std::shared_ptr<std::string>> lazy_info;
+    /// Whether every nogood of `lazy_trace` is in `uid2nogood`
+    bool lazy_nogoods_complete = false;
+
+    /// Nogoods are stored as received; renaming them (regex heavy) is
+    /// left to `decoder`, or done on first access if it hasn't got to
+    /// them yet. Nogoods (in `uid2nogood`) still without views:
+    std::vector<NodeUID> pending_views;
+
+    /// Same for info: its fields are decoded into `uid2decoded`
+    /// (and `uid2obj`), the raw text is kept for display only.
+    /// Info (in `uid2info`) not decoded yet:
+    std::vector<NodeUID> pending_info;
+    utils::UidMap<NodeInfo> uid2decoded;
+
+    std::thread decoder;
+    std::mutex decoder_mutex;
+    std::condition_variable decoder_cond;
+    bool decoder_has_work = false;
+    std::atomic<bool> decoder_stop{false};
+
+    /// Wake up `decoder` (starting it if necessary)
+    void scheduleDecoding();
+    void decodeInBackground();
+
+    /// Make the renamed/simplified views of `ng` unless done already
+    /// (requires `dataMutex`)
+    void makeViews(NogoodViews& ng) const;
+
+    /// Decoded info of `uid`, decoding it now if `decoder` hasn't yet;
+    /// nullptr if the node has no info (requires `dataMutex`)
+    const NodeInfo* decodedInfo(const NodeUID& uid);
+    void storeDecoded(const NodeUID& uid, NodeInfo&& info);
+
     /// node rate intervals
     std::vector<int> nr_intervals;
 
-    std::unordered_map<NodeUID, int> uid2obj;
+    utils::UidMap<int> uid2obj;
 
 public:
 
-    /// Mapping from solver Id to array Id (nodes_arr)
-    /// can't use vector because sid is too big with threads
-    std::unordered_map<NodeUID, int> uid2aid;
+    /// Mapping from solver Id to array Id (nodes)
+    utils::UidIndex uid2aid;
 
-    /// Maps gist Id to dbEntry (possibly in the other Data instance);
+private:
+
+    /// Maps gist Id to array Id of an own node (-1 if none)
+    utils::SegmentedVector<int32_t> gid2aid;
+
+    /// Maps gist Id to an entry in the other Data instance;
     /// i.e. needed for a merged tree to show labels etc.
-    /// TODO(maixm): this should probably be a vector?
-    std::unordered_map<int, DbEntry*> gid2entry;
+    std::unordered_map<int, DbEntry> gid2foreign;
 
-    std::unordered_map<NodeUID, std::shared_ptr<std::string>> uid2info;
+public:
+
+    utils::UidMap<std::shared_ptr<std::string>> uid2info;
 
     /// synchronise access to data entries
     mutable QMutex dataMutex {QMutex::Recursive};
 
-private:
-
-    /// Populate nodes_arr with the data coming from
-    void pushInstance(DbEntry* entry);
-
-public:
 
     Data();
     ~Data();
 
-    void handleNodeCallback(const cpprofiler::Message& node);
+    /// Register a new producer of nodes (any thread); each source
+    /// must only be fed from one thread at a time
+    IngestSource* openSource();
+
+    /// No more nodes will come from `source`; returns true if it was
+    /// the last open one, i.e. receiving is done
+    bool closeSource(IngestSource* source);
+
+    /// Decode a node and pass it on to the builder (receiver thread)
+    void handleNodeCallback(IngestSource* source, const cpprofiler::Message& node);
+
+    /// Pass an already decoded node on to the builder, keeping its
+    /// timing (receiver or trace loader thread)
+    void handleNodeRecord(IngestSource* source, NodeRecord&& rec);
+
+    /// Decode the nodes of a NODE_BATCH payload in one pass and pass them
+    /// on to the builder (receiver thread); false if it is malformed
+    bool handleNodeBatch(IngestSource* source, const char* payload, size_t size);
+
+    /// Write all committed nodes (with their nogoods and info)
+    void saveNodes(tracefile::Writer& writer) const;
+
+    /// Nodes will come from `trace` (lazily, see `tracefile::Reader::readChunk`);
+    /// must be called before any node is received
+    void attachTrace(std::shared_ptr<const tracefile::Reader> trace);
+
+    /// Move up to `max_count` decoded nodes into the data entries
+    /// (builder thread); returns how many were committed
+    size_t commitPendingNodes(size_t max_count);
+
+    /// Block the builder until more nodes arrive or receiving is done
+    void waitForNodes();
+
+    /// Whether there are decoded nodes not yet committed
+    bool hasPendingNodes() const;
+
+    /// Whether the producer of `source` should stop reading for a while:
+    /// the builder is falling behind (any thread)
+    bool isBackedUp(const IngestSource* source) const;
+
+    /// Must be called before any node is received
+    void setIngestLimits(const IngestLimits& ingest_limits) { limits = ingest_limits; }
+
+    IngestMode ingestMode() const { return static_cast<IngestMode>(ingest_mode.load()); }
+
+    /// Nodes that were only counted (see IngestMode::STATS_ONLY)
+    CountedNodes countedNodes() const;
+
+    void notifyPlaced(uint64_t count) { nodes_placed += count; }
 
     /// TODO(maxim): Do I want a reference here?
     /// return label by gid (Gist ID)
     std::string getLabel(int gid);
 
+    /// id of the label in `utils::LabelDictionary::global()` (0 if none)
+    int32_t getLabelId(int gid) const;
+
     /// return solver id by gid (Gist ID)
     NodeUID gid2uid(int gid) const;
 
-    void connectNodeToEntry(int gid, DbEntry* const entry);
+    void connectNodeToEntry(int gid, DbEntry entry);
+
+    /// Record where the builder placed an own node
+    void assignGid(int32_t aid, int32_t gid, int32_t depth);
 
     /// return total number of nodes
-    int size() const { return nodes_arr.size(); }
+    int size() const { return nodes.size(); }
 
 /// ********* GETTERS **********
 
     bool isDone(void) const { return _isDone; }
 
-    const std::vector<DbEntry*>& getEntries() const { return nodes_arr; }
-    inline const Uid2Nogood& getNogoods(void) { return uid2nogood; }
+    uint64_t nodesIngested() const { return nodes_ingested; }
+    uint64_t nodesPlaced() const { return nodes_placed; }
+
+    const NodeStore& getEntries() const { return nodes; }
+    /// All nogoods (for a lazily loaded trace this reads every one of them)
+    const Uid2Nogood& getNogoods(void);
+
+    /// Nogood of a node, nullptr if none
+    const NogoodViews* findNogood(const NodeUID& uid);
+
+    /// Info of a node, nullptr if none
+    std::shared_ptr<std::string> getInfo(const NodeUID& uid);
+
+    /// Decoded fields of a node's info (defaults if it has none)
+    NodeInfo getNodeInfo(const NodeUID& uid);
 
     uint64_t getTotalTime();
 
-    int32_t getGidByUID(NodeUID uid) {
-        return nodes_arr[uid2aid[uid]]->gid;
+    int32_t getGidByUID(NodeUID uid) const {
+        const int32_t aid = uid2aid.get(uid);
+        if (aid == -1) return -1;
+        return nodes.gid(aid);
     }
 
-    const int* getObjective(NodeUID uid) const {
-        auto it = uid2obj.find(uid);
-        if (it != uid2obj.end()) {
-            return &it->second;
-        } else {
-            return nullptr;
-        }
-    }
-    /// NOTE(maxim): this only works for a merged tree now?
-    DbEntry* getEntry(int gid) const;
+    const int* getObjective(NodeUID uid);
+    /// Entry shown at `gid`, either own or connected from another Data
+    DbEntry getEntry(int gid) const;
 
     const NameMap* getNameMap() const { return nameMap; }
     void setNameMap(NameMap* names);
@@ -189,9 +389,6 @@ public:
 /// Starts node timer
     void initReceiving();
 
-    public Q_SLOTS:
-
-    void setDoneReceiving();
 #ifdef MAXIM_DEBUG
     void setLabel(int gid, const std::string& str);
     const std::string getDebugInfo() const;
@@ -199,18 +396,20 @@ public:
 };
 
 inline
-void Data::connectNodeToEntry(int gid, DbEntry* const entry) {
-    gid2entry[gid] = entry;
-}
+DbEntry Data::getEntry(int gid) const {
 
-inline
-DbEntry* Data::getEntry(int gid) const {
+    if (gid >= 0 && static_cast<size_t>(gid) < gid2aid.size()) {
+        const int32_t aid = gid2aid[gid];
+        if (aid != -1) return DbEntry{&nodes, aid};
+    }
+
+    if (gid2foreign.empty()) return DbEntry{};
 
-    auto it = gid2entry.find(gid);
-    if (it != gid2entry.end()) {
+    auto it = gid2foreign.find(gid);
+    if (it != gid2foreign.end()) {
         return it->second;
     } else {
-        return nullptr;
+        return DbEntry{};
     }
 }
 
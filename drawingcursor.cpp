@@ -19,7 +19,13 @@
  *
  */
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "drawingcursor.hh"
+#include "nodetree.hh"
+#include "cpprofiler/utils/tree_utils.hh"
+#include "libs/perf_helper.hh"
 
 using namespace cpprofiler::colors;
 
@@ -33,15 +39,29 @@ constexpr double SHADOW_OFFSET = 3.0;
 constexpr double HIDDEN_DEPTH =
     static_cast<double>(Layout::dist_y) + FAILED_WIDTH;
 
+/// Subtrees narrower than this on the screen (in pixels) are drawn
+/// as a single glyph (see `drawGeneration`)
+constexpr double LOD_MIN_PIXELS = 4.0;
+/// Below this scale labels are not drawn (nor measured): they
+/// would not be readable
+constexpr double LABEL_MIN_SCALE = 0.4;
+
 
 namespace Pens {
     const QPen hovered = QPen{Qt::black, 3};
 }
 
+static QPolygonF pentagon(int myx, int myy);
+static QPolygonF triangle(int myx, int myy);
+static QPolygonF diamond(int myx, int myy);
+static QPolygonF sizedRect(int myx, int myy, int subtreeSize);
 static void drawPentagon(QPainter& painter, int myx, int myy, bool shadow);
 static void drawTriangle(QPainter& painter, int myx, int myy, bool shadow);
 static void drawDiamond(QPainter& painter, int myx, int myy, bool shadow);
-static void drawShape(QPainter& painter, int myx, int myy, VisualNode* node);
+static void drawOutlines(QPainter& painter, const PlacedNode& n, uint16_t flags,
+                         const Extent* outline, int depth);
+static void drawShape(QPainter& painter, int myx, int myy, const Extent* shape, int depth);
+static void drawEdge(QPainter& painter, const PlacedNode& n, bool onPath);
 static void drawSizedRect(QPainter& painter, int myx, int myy, int subtreeSize, bool shadow);
 static void drawSizedTriangle(QPainter& painter, int myx, int myy, int subtreeSize, bool shadow);
 
@@ -61,49 +81,266 @@ void
 DrawingCursor::processCurrentNode(void) {
     VisualNode* n = node();
     VisualNode* parent = n->getParent(na);
-    double parentX = x - static_cast<double>(n->getOffset());
-    double parentY = y - static_cast<double>(Layout::dist_y) + NODE_WIDTH;
-
-    double myx = x;
-    double myy = y;
-
-    if (n != startNode()) {
-        if (n->isOnPath())
-            painter.setPen(Qt::red);
-        else
-            painter.setPen(Qt::black);
-        // Here we use drawPath instead of drawLine in order to
-        // workaround a strange redraw artefact on Windows
-        QPainterPath path;
-        path.moveTo(myx,myy);
-        path.lineTo(parentX,parentY);
-        painter.drawPath(path);
 
-    }
+    PlacedNode p;
+    p.x = x;
+    p.y = y;
+    p.parent_x = x - n->getOffset();
+    p.flags = PlacedNode::flagsOf(*n);
+    if (!parent || parent->_tid != n->_tid) p.flags |= PlacedNode::NEW_THREAD;
+    p.status = n->getStatus();
+    p.tid = n->_tid;
+    p.subtree_size = static_cast<int8_t>(n->getSubtreeSize());
 
-    QFontMetrics fm = painter.fontMetrics();
     QString label = na.getLabel(n);
     int alt = n->getAlternative(na);
     int n_alt = parent ? parent->getNumberOfChildren() : 1;
-    int tw = fm.width(label);
-    int lx;
+    PlacedNode::LabelSide side = PlacedNode::LABEL_CENTER;
     if (alt == 0 && n_alt > 1) {
-        lx = myx - tw - 4;
+        side = PlacedNode::LABEL_LEFT;
     } else if (alt == n_alt - 1 && n_alt > 1) {
-        lx = myx + 4;
-    } else {
-        lx = myx - tw / 2;
+        side = PlacedNode::LABEL_RIGHT;
+    }
+
+    Shape* shape = n->getShape();
+    if (shape == nullptr && (p.flags & (PlacedNode::NEW_THREAD | PlacedNode::HIGHLIGHTED))) {
+        std::cerr << "WARNING: node has no shape\n";
+        abort();
+    }
+
+    drawPlacedNode(painter, p, p.flags, n != startNode(), &label, side,
+                   shape ? &(*shape)[0] : nullptr, shape ? shape->depth() : 0);
+}
+
+namespace {
+
+/// Primitives of one frame grouped by how they look, so that they are
+/// drawn with a few calls at the end (see `drawGeneration`) rather than
+/// with a pen and brush change and a draw call per node
+class PaintBatch {
+public:
+    enum Style {
+        SOLVED_NODE, FAILED_NODE, BRANCH_NODE, OPEN_BRANCH_NODE,
+        UNDETERMINED_NODE, SKIPPED_NODE, MERGING_NODE,
+        SOLVED_HIDDEN, FAILED_HIDDEN,
+        SOLVED_GLYPH, FAILED_GLYPH, OPEN_GLYPH,
+        STYLE_COUNT
+    };
+
+private:
+    QVector<QLineF> m_edges;
+    /// edges on the path to the selected node
+    QVector<QLineF> m_path_edges;
+    QPainterPath m_glyphs[STYLE_COUNT];
+
+    void addPolygon(Style style, const QPolygonF& polygon) {
+        m_glyphs[style].addPolygon(polygon);
+        m_glyphs[style].closeSubpath();
+    }
+
+public:
+    PaintBatch() {
+        /// overlapping glyphs of the same style must not cancel out
+        for (auto& path : m_glyphs) path.setFillRule(Qt::WindingFill);
+    }
+
+    void addEdge(const PlacedNode& n, bool onPath) {
+        const double parentY = n.y - static_cast<double>(Layout::dist_y) + NODE_WIDTH;
+        (onPath ? m_path_edges : m_edges) << QLineF(n.x, n.y, n.parent_x, parentY);
+    }
+
+    /// Add the glyph of node `n` (without its label); returns false if
+    /// the node has to be drawn on its own (see `drawPlacedNode`)
+    bool addNode(const PlacedNode& n, uint16_t flags);
+
+    /// Add the whole subtree of `n` as one box over the rows it takes,
+    /// in the colour of what it contains
+    void addSubtree(const PlacedNode& n, uint16_t flags);
+
+    void flush(QPainter& painter) const;
+};
+
+bool PaintBatch::addNode(const PlacedNode& n, uint16_t flags) {
+
+    constexpr uint16_t alone = PlacedNode::MARKED | PlacedNode::HOVERED |
+                             PlacedNode::SELECTED | PlacedNode::BOOKMARKED;
+    if (flags & alone) return false;
+    if (flags & PlacedNode::INVISIBLE) return true;
+
+    const int myx = n.x;
+    const int myy = n.y;
+
+    if (flags & PlacedNode::HIDDEN) {
+        if (n.status == MERGING) {
+            addPolygon(MERGING_NODE, pentagon(myx, myy));
+            return true;
+        }
+        /// gradients differ from node to node
+        if (flags & PlacedNode::OPEN_CHILDREN) return false;
+
+        const Style style = (flags & PlacedNode::SOLVED_CHILDREN) ? SOLVED_HIDDEN
+                                                                  : FAILED_HIDDEN;
+        addPolygon(style, n.subtree_size != -1 ? sizedRect(myx, myy, n.subtree_size)
+                                               : triangle(myx, myy));
+        return true;
+    }
+
+    switch (n.status) {
+    case SOLVED:
+        addPolygon(SOLVED_NODE, diamond(myx, myy));
+        break;
+    case FAILED:
+        m_glyphs[FAILED_NODE].addRect(myx - HALF_FAILED_WIDTH, myy, FAILED_WIDTH, FAILED_WIDTH);
+        break;
+    case BRANCH: {
+        const Style style = (flags & PlacedNode::LAYOUT_DONE) ? BRANCH_NODE
+                                                              : OPEN_BRANCH_NODE;
+        m_glyphs[style].addEllipse(myx - HALF_NODE_WIDTH, myy, NODE_WIDTH, NODE_WIDTH);
+        break;
+    }
+    case UNDETERMINED:
+        m_glyphs[UNDETERMINED_NODE].addEllipse(myx - HALF_NODE_WIDTH, myy,
+                                               NODE_WIDTH, NODE_WIDTH);
+        break;
+    case SKIPPED:
+        m_glyphs[SKIPPED_NODE].addRect(myx - HALF_FAILED_WIDTH, myy, FAILED_WIDTH, FAILED_WIDTH);
+        break;
+    case MERGING:
+        addPolygon(MERGING_NODE, pentagon(myx, myy));
+        break;
+    default: break;
+    }
+
+    return true;
+}
+
+void PaintBatch::addSubtree(const PlacedNode& n, uint16_t flags) {
+
+    const bool solved = (flags & PlacedNode::SOLVED_CHILDREN) || n.status == SOLVED;
+    const bool failed = (flags & PlacedNode::FAILED_CHILDREN) ||
+                        n.status == FAILED || n.status == SKIPPED;
+
+    const Style style = solved ? SOLVED_GLYPH : (failed ? FAILED_GLYPH : OPEN_GLYPH);
+
+    const double height = n.bottom - n.y - 2 * Layout::dist_y + NODE_WIDTH;
+    m_glyphs[style].addRect(n.left, n.y, n.right - n.left, height);
+}
+
+void PaintBatch::flush(QPainter& painter) const {
+
+    painter.setPen(Qt::black);
+    painter.drawLines(m_edges);
+    painter.setPen(Qt::red);
+    painter.drawLines(m_path_edges);
+
+    /// the same colours as in `drawPlacedNode`
+    const QBrush brushes[STYLE_COUNT] = {
+        QBrush(green), QBrush(red), QBrush(blue), QBrush(white),
+        QBrush(Qt::white), QBrush(Qt::gray), QBrush(orange),
+        QBrush(green), QBrush(red),
+        QBrush(green), QBrush(red), QBrush(lightBlue)
+    };
+
+    for (int style = 0; style < STYLE_COUNT; ++style) {
+        if (m_glyphs[style].isEmpty()) continue;
+        if (style >= SOLVED_GLYPH) {
+            painter.setPen(Qt::NoPen);
+        } else {
+            painter.setPen(Qt::SolidLine);
+        }
+        painter.setBrush(brushes[style]);
+        painter.drawPath(m_glyphs[style]);
     }
+}
+
+}
+
+int lodMinWidth(double scale) {
+    return static_cast<int>(LOD_MIN_PIXELS / scale);
+}
+
+void drawGeneration(QPainter& painter, const LayoutGeneration& gen,
+                    const QRect& clip, double scale,
+                    const std::unordered_map<int, uint16_t>* live) {
+
+    QPen pen = painter.pen();
+    pen.setWidth(1);
+    painter.setPen(pen);
+
+    const int min_width = lodMinWidth(scale);
+    const bool labels = scale >= LABEL_MIN_SCALE;
 
-    // QFont font(painter.font());
-    // font.setPixelSize(28);
-    // painter.setFont(font);
+    PaintBatch batch;
 
-        painter.drawText(QPointF(lx, myy - 4), label);
-    // painter.drawText(QPointF(lx-5, myy), label);
+    /// nodes drawn one by one over the batch: selected, bookmarked,
+    /// labelled etc. (a handful on any screen)
+    std::vector<std::pair<int, uint16_t>> own;
 
-    if (!parent || parent->_tid != n->_tid) {
-        switch (n->_tid) {
+    gen.visit(clip, min_width, [&](int i, bool whole) {
+        const PlacedNode& n = gen[i];
+
+        uint16_t flags = n.flags;
+        if (live != nullptr) {
+            auto it = live->find(i);
+            if (it != live->end()) {
+                flags &= ~PlacedNode::INTERACTIVE;
+                flags |= it->second;
+            }
+        }
+
+        if (i != 0) batch.addEdge(n, flags & PlacedNode::ONPATH);
+
+        if (whole) {
+            batch.addSubtree(n, flags);
+            return;
+        }
+
+        /// outlines go under everything in the subtree, so they are
+        /// drawn straight away
+        const std::vector<Extent>* outline = gen.outline(i);
+        if (outline != nullptr) {
+            drawOutlines(painter, n, flags, outline->data(),
+                         static_cast<int>(outline->size()));
+        }
+
+        PlacedNode::LabelSide side;
+        const bool labelled = labels && gen.label(i, side) != nullptr;
+
+        if (labelled || !batch.addNode(n, flags)) own.emplace_back(i, flags);
+    });
+
+    batch.flush(painter);
+
+    for (const auto& node : own) {
+        PlacedNode::LabelSide side = PlacedNode::LABEL_CENTER;
+        const QString* label = labels ? gen.label(node.first, side) : nullptr;
+        drawPlacedNode(painter, gen[node.first], node.second, false, label, side,
+                       nullptr, 0);
+    }
+}
+
+static void drawEdge(QPainter& painter, const PlacedNode& n, bool onPath) {
+    double parentX = n.parent_x;
+    double parentY = n.y - static_cast<double>(Layout::dist_y) + NODE_WIDTH;
+
+    if (onPath)
+        painter.setPen(Qt::red);
+    else
+        painter.setPen(Qt::black);
+    // Here we use drawPath instead of drawLine in order to
+    // workaround a strange redraw artefact on Windows
+    QPainterPath path;
+    path.moveTo(n.x, n.y);
+    path.lineTo(parentX,parentY);
+    painter.drawPath(path);
+}
+
+/// The shapes of `n` filled in the colour of its thread and/or
+/// as highlighted, under everything else in the subtree
+static void drawOutlines(QPainter& painter, const PlacedNode& n, uint16_t flags,
+                         const Extent* outline, int depth) {
+    if (flags & PlacedNode::NEW_THREAD) {
+        switch (n.tid) {
             case 0:
                 painter.setBrush(QColor(255, 255, 255, 255));
             break;
@@ -119,33 +356,71 @@ DrawingCursor::processCurrentNode(void) {
             default:
                 painter.setBrush(QColor(255, 255, 255, 255));
         }
-        drawShape(painter, myx, myy, n);
+        drawShape(painter, n.x, n.y, outline, depth);
     }
 
     // draw the shape if the node is highlighted
     painter.setBrush(QColor(160, 160, 160, 100));
-    if (n->isHighlighted()) {
-      drawShape(painter, myx, myy, n);
+    if (flags & PlacedNode::HIGHLIGHTED) {
+      drawShape(painter, n.x, n.y, outline, depth);
+    }
+}
+
+void drawPlacedNode(QPainter& painter, const PlacedNode& n, uint16_t flags,
+                    bool edge, const QString* label, PlacedNode::LabelSide side,
+                    const Extent* outline, int depth) {
+    double myx = n.x;
+    double myy = n.y;
+
+    const bool hidden = flags & PlacedNode::HIDDEN;
+    const bool marked = flags & PlacedNode::MARKED;
+
+    if (edge) {
+        drawEdge(painter, n, flags & PlacedNode::ONPATH);
+    } else {
+        painter.setPen(Qt::black);
+    }
+
+    if (label != nullptr) {
+        QFontMetrics fm = painter.fontMetrics();
+        int tw = fm.width(*label);
+        int lx;
+        if (side == PlacedNode::LABEL_LEFT) {
+            lx = myx - tw - 4;
+        } else if (side == PlacedNode::LABEL_RIGHT) {
+            lx = myx + 4;
+        } else {
+            lx = myx - tw / 2;
+        }
+
+        // QFont font(painter.font());
+        // font.setPixelSize(28);
+        // painter.setFont(font);
+
+        painter.drawText(QPointF(lx, myy - 4), *label);
+        // painter.drawText(QPointF(lx-5, myy), label);
     }
 
-    if (n->isInvisible()) return;
+    if (outline != nullptr) drawOutlines(painter, n, flags, outline, depth);
+
+    if (flags & PlacedNode::INVISIBLE) return;
 
     // draw as currently selected
-    if (n->isMarked()) {
+    if (marked) {
         painter.setBrush(Qt::gray);
         painter.setPen(Qt::NoPen);
-        if (n->isHidden()) {
-            if (n->getStatus() == MERGING)
+        if (hidden) {
+            if (n.status == MERGING)
                 drawPentagon(painter, myx, myy, true);
             else
-              if (n->getSubtreeSize() != -1) {
-                drawSizedRect(painter, myx, myy, n->getSubtreeSize(), true);
+              if (n.subtree_size != -1) {
+                drawSizedRect(painter, myx, myy, n.subtree_size, true);
             }
               else {
                 drawTriangle(painter, myx, myy, true);
               }
         } else {
-            switch (n->getStatus()) {
+            switch (n.status) {
             case SOLVED:
                 drawDiamond(painter, myx, myy, true);
                 break;
@@ -174,7 +449,7 @@ DrawingCursor::processCurrentNode(void) {
         }
     }
 
-    if (n->isHovered() || n->isSelected()) {
+    if (flags & (PlacedNode::HOVERED | PlacedNode::SELECTED)) {
         /// TODO(maxim): maybe make the brush color darker as well
         // pen.set
         painter.setPen(Pens::hovered);
@@ -182,23 +457,23 @@ DrawingCursor::processCurrentNode(void) {
         painter.setPen(Qt::SolidLine);
     }
 
-    if (n->isHidden()) {
+    if (hidden) {
 
-        if (n->getStatus() == MERGING) {
-            if (n->isMarked()) {
+        if (n.status == MERGING) {
+            if (marked) {
                 painter.setBrush(gold);
             } else {
                 painter.setBrush(orange);
             }
             drawPentagon(painter, myx, myy, false);
         } else {
-            if (n->hasOpenChildren()) {
+            if (flags & PlacedNode::OPEN_CHILDREN) {
                 QLinearGradient gradient(myx - NODE_WIDTH, myy,
                     myx + NODE_WIDTH * 1.3, myy + HIDDEN_DEPTH * 1.3);
-                if (n->hasSolvedChildren()) {
+                if (flags & PlacedNode::SOLVED_CHILDREN) {
                     gradient.setColorAt(0, white);
                     gradient.setColorAt(1, green);
-                } else if (n->hasFailedChildren()) {
+                } else if (flags & PlacedNode::FAILED_CHILDREN) {
                     gradient.setColorAt(0, white);
                     gradient.setColorAt(1, red);
                 } else {
@@ -207,20 +482,20 @@ DrawingCursor::processCurrentNode(void) {
                 }
                 painter.setBrush(gradient);
             } else {
-                if (n->hasSolvedChildren())
+                if (flags & PlacedNode::SOLVED_CHILDREN)
                     painter.setBrush(QBrush(green));
                 else
                     painter.setBrush(QBrush(red));
             }
 
-            if (n->getSubtreeSize() != -1)
-              drawSizedRect(painter, myx, myy, n->getSubtreeSize(), false);
+            if (n.subtree_size != -1)
+              drawSizedRect(painter, myx, myy, n.subtree_size, false);
             else
               drawTriangle(painter, myx, myy, false);
         }
 
     } else {
-        switch (n->getStatus()) {
+        switch (n.status) {
         case SOLVED:
             // if (n->isCurrentBest(curBest)) {
                 // painter.setBrush(QBrush(orange));
@@ -230,7 +505,7 @@ DrawingCursor::processCurrentNode(void) {
             drawDiamond(painter, myx, myy, false);
             break;
         case FAILED:
-            if (n->isMarked())
+            if (marked)
                 painter.setBrush(gold);
             else
                 painter.setBrush(QBrush(red));
@@ -242,26 +517,26 @@ DrawingCursor::processCurrentNode(void) {
             //     painter.setBrush(gold);
             // else
 #endif
-                painter.setBrush(n->childrenLayoutIsDone() ? QBrush(blue) :
-                                                             QBrush(white));
+                painter.setBrush((flags & PlacedNode::LAYOUT_DONE) ? QBrush(blue) :
+                                                                     QBrush(white));
             painter.drawEllipse(myx - HALF_NODE_WIDTH, myy, NODE_WIDTH, NODE_WIDTH);
             break;
         case UNDETERMINED:
-            if (n->isMarked())
+            if (marked)
                 painter.setBrush(gold);
             else
                 painter.setBrush(Qt::white);
             painter.drawEllipse(myx - HALF_NODE_WIDTH, myy, NODE_WIDTH, NODE_WIDTH);
             break;
         case SKIPPED:
-            if (n->isMarked())
+            if (marked)
                 painter.setBrush(gold);
             else
                 painter.setBrush(Qt::gray);
             painter.drawRect(myx - HALF_FAILED_WIDTH, myy, FAILED_WIDTH, FAILED_WIDTH);
             break;
         case MERGING:
-            if (n->isMarked()) {
+            if (marked) {
                 painter.setBrush(gold);
             } else {
                 painter.setBrush(orange);
@@ -272,7 +547,7 @@ DrawingCursor::processCurrentNode(void) {
         }
     }
 
-    if (n->isBookmarked()) {
+    if (flags & PlacedNode::BOOKMARKED) {
         painter.setBrush(Qt::black);
         painter.drawEllipse(myx-10-0, myy, 10.0, 10.0);
     }
@@ -281,34 +556,61 @@ DrawingCursor::processCurrentNode(void) {
 
 }
 
-static void drawPentagon(QPainter& painter, int myx, int myy, bool shadow) {
+static QPolygonF pentagon(int myx, int myy) {
 
-    QPointF points[5] = { QPointF(myx, myy),
-        QPointF(myx + HALF_NODE_WIDTH, myy + THIRD_NODE_WIDTH),
-        QPointF(myx + THIRD_NODE_WIDTH, myy + NODE_WIDTH),
-        QPointF(myx - THIRD_NODE_WIDTH, myy + NODE_WIDTH),
-        QPointF(myx - HALF_NODE_WIDTH, myy + THIRD_NODE_WIDTH)
-    };
+    QPolygonF points;
+    points << QPointF(myx, myy)
+           << QPointF(myx + HALF_NODE_WIDTH, myy + THIRD_NODE_WIDTH)
+           << QPointF(myx + THIRD_NODE_WIDTH, myy + NODE_WIDTH)
+           << QPointF(myx - THIRD_NODE_WIDTH, myy + NODE_WIDTH)
+           << QPointF(myx - HALF_NODE_WIDTH, myy + THIRD_NODE_WIDTH);
+    return points;
+}
 
-    if (shadow) {
-        for (auto&& p : points) { p += QPointF(SHADOW_OFFSET, SHADOW_OFFSET);}
-    }
+static QPolygonF triangle(int myx, int myy) {
 
-    painter.drawConvexPolygon(points, 5);
+    QPolygonF points;
+    points << QPointF(myx, myy)
+           << QPointF(myx + NODE_WIDTH, myy + HIDDEN_DEPTH)
+           << QPointF(myx - NODE_WIDTH, myy + HIDDEN_DEPTH);
+    return points;
 }
 
-static void drawTriangle(QPainter& painter, int myx, int myy, bool shadow){
+static QPolygonF sizedRect(int myx, int myy, int subtreeSize) {
+    using sized_rect::K; using sized_rect::BASE_HEIGHT; using sized_rect::HALF_WIDTH;
 
-    QPointF points[3] = { QPointF(myx, myy),
-        QPointF(myx + NODE_WIDTH, myy + HIDDEN_DEPTH),
-        QPointF(myx - NODE_WIDTH, myy + HIDDEN_DEPTH)
-    };
+    int height = K * subtreeSize;
 
-    if (shadow) {
-        for (auto&& p : points) { p += QPointF(SHADOW_OFFSET, SHADOW_OFFSET);}
-    }
+    QPolygonF points;
+    points << QPointF(myx, myy)
+           << QPointF(myx + HALF_WIDTH, myy + BASE_HEIGHT)
+           << QPointF(myx + HALF_WIDTH, myy + BASE_HEIGHT + height)
+           << QPointF(myx - HALF_WIDTH, myy + BASE_HEIGHT + height)
+           << QPointF(myx - HALF_WIDTH, myy + BASE_HEIGHT);
+    return points;
+}
 
-    painter.drawConvexPolygon(points, 3);
+static QPolygonF diamond(int myx, int myy) {
+
+    QPolygonF points;
+    points << QPointF(myx, myy)
+           << QPointF(myx + HALF_NODE_WIDTH, myy + HALF_NODE_WIDTH)
+           << QPointF(myx, myy + NODE_WIDTH)
+           << QPointF(myx - HALF_NODE_WIDTH, myy + HALF_NODE_WIDTH);
+    return points;
+}
+
+static void drawGlyph(QPainter& painter, QPolygonF glyph, bool shadow) {
+    if (shadow) glyph.translate(SHADOW_OFFSET, SHADOW_OFFSET);
+    painter.drawConvexPolygon(glyph);
+}
+
+static void drawPentagon(QPainter& painter, int myx, int myy, bool shadow) {
+    drawGlyph(painter, pentagon(myx, myy), shadow);
+}
+
+static void drawTriangle(QPainter& painter, int myx, int myy, bool shadow){
+    drawGlyph(painter, triangle(myx, myy), shadow);
 }
 
 static void drawSizedTriangle(QPainter& painter, int myx, int myy, int subtreeSize, bool shadow) {
@@ -327,22 +629,7 @@ static void drawSizedTriangle(QPainter& painter, int myx, int myy, int subtreeSi
 }
 
 static void drawSizedRect(QPainter& painter, int myx, int myy, int subtreeSize, bool shadow) {
-    using sized_rect::K; using sized_rect::BASE_HEIGHT; using sized_rect::HALF_WIDTH;
-
-    int height = K * subtreeSize;
-
-    QPointF points[5] = { QPointF(myx, myy),
-        QPointF(myx + HALF_WIDTH, myy + BASE_HEIGHT),
-        QPointF(myx + HALF_WIDTH, myy + BASE_HEIGHT + height),
-        QPointF(myx - HALF_WIDTH, myy + BASE_HEIGHT + height),
-        QPointF(myx - HALF_WIDTH, myy + BASE_HEIGHT)
-    };
-
-    if (shadow) {
-        for (auto&& p : points) { p += QPointF(SHADOW_OFFSET, SHADOW_OFFSET);}
-    }
-
-    painter.drawConvexPolygon(points, 5);
+    drawGlyph(painter, sizedRect(myx, myy, subtreeSize), shadow);
 
     // QRectF rect { (float)myx - HALF_NODE_WIDTH, (float)myy, (float)NODE_WIDTH, (float)height };
 
@@ -352,34 +639,17 @@ static void drawSizedRect(QPainter& painter, int myx, int myy, int subtreeSize,
 }
 
 static void drawDiamond(QPainter& painter, int myx, int myy, bool shadow) {
-
-    QPointF points[4] = { QPointF(myx, myy),
-        QPointF(myx + HALF_NODE_WIDTH, myy + HALF_NODE_WIDTH),
-        QPointF(myx, myy + NODE_WIDTH),
-        QPointF(myx - HALF_NODE_WIDTH, myy + HALF_NODE_WIDTH)
-    };
-
-    if (shadow) {
-        for (auto&& p : points) { p += QPointF(SHADOW_OFFSET, SHADOW_OFFSET);}
-    }
-
-    painter.drawConvexPolygon(points, 4);
+    drawGlyph(painter, diamond(myx, myy), shadow);
 }
 
 
-static void drawShape(QPainter& painter, int myx, int myy, VisualNode* node){
+static void drawShape(QPainter& painter, int myx, int myy, const Extent* shape, int depth){
     painter.setPen(Qt::NoPen);
 
-    Shape* shape = node->getShape();
-    if (shape == nullptr) {
-        std::cerr << "WARNING: node has no shape\n";
-        abort();
-    }
-    int depth = shape->depth();
     QPointF *points = new QPointF[depth * 2];
 
-    int l_x = myx + (*shape)[0].l;
-    int r_x = myx + (*shape)[0].r;
+    int l_x = myx + shape[0].l;
+    int r_x = myx + shape[0].r;
     int y = myy + NODE_WIDTH / 2;
 
     points[0] = QPointF(l_x, myy);
@@ -387,13 +657,127 @@ static void drawShape(QPainter& painter, int myx, int myy, VisualNode* node){
 
     for (int i = 1; i <  depth; i++){
         y += static_cast<double>(Layout::dist_y);
-        l_x += (*shape)[i].l;
-        r_x += (*shape)[i].r;
+        l_x += shape[i].l;
+        r_x += shape[i].r;
         points[i] = QPointF(l_x, y);
         points[depth * 2 - i - 1] = QPointF(r_x, y);
     }
 
-    painter.drawConvexPolygon(points, shape->depth() * 2);
+    painter.drawConvexPolygon(points, depth * 2);
 
     delete[] points;
-}
\ No newline at end of file
+}
+
+namespace drawingcursor {
+
+    static int inkedPixels(const QImage& image) {
+        int inked = 0;
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                if (image.pixel(x, y) != qRgb(255, 255, 255)) ++inked;
+            }
+        }
+        return inked;
+    }
+
+    /// Paint `gen` within `clip` at `scale`, either batched (as the canvas
+    /// does) or with a few draw calls per node (as `DrawingCursor` does)
+    static void paint(QImage& image, const LayoutGeneration& gen,
+                      const QRect& clip, double scale, bool batched) {
+
+        image.fill(Qt::white);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.scale(scale, scale);
+        painter.translate(-clip.x(), -clip.y());
+
+        if (batched) {
+            drawGeneration(painter, gen, clip, scale, nullptr);
+            return;
+        }
+
+        gen.visit(clip, lodMinWidth(scale), [&](int i, bool whole) {
+            const PlacedNode& n = gen[i];
+            if (!whole) {
+                const std::vector<Extent>* outline = gen.outline(i);
+                drawPlacedNode(painter, n, n.flags, i != 0, nullptr, PlacedNode::LABEL_CENTER,
+                               outline ? outline->data() : nullptr,
+                               outline ? static_cast<int>(outline->size()) : 0);
+                return;
+            }
+            if (i != 0) drawEdge(painter, n, false);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(lightBlue);
+            painter.drawRect(n.left, n.y, n.right - n.left,
+                             n.bottom - n.y - 2 * Layout::dist_y + NODE_WIDTH);
+        });
+    }
+
+    /// Paint time against the number of nodes on a 1600x1000 screen over
+    /// the widest (bottom) rows of the tree, zooming out; the batched
+    /// picture must not lose anything drawn node by node
+    static bool paintTimes(const LayoutGeneration& gen) {
+
+        constexpr int WIDTH = 1600;
+        constexpr int HEIGHT = 1000;
+        constexpr int FRAMES = 5;
+
+        const BoundingBox bb = gen.boundingBox();
+        const int bottom = gen.depth() * Layout::dist_y;
+
+        QImage batched(WIDTH, HEIGHT, QImage::Format_ARGB32_Premultiplied);
+        QImage single(WIDTH, HEIGHT, QImage::Format_ARGB32_Premultiplied);
+
+        bool passed = true;
+
+        for (double scale : {1.0, 0.5, 0.2, 0.05}) {
+
+            const int w = WIDTH / scale;
+            const int h = HEIGHT / scale;
+            const QRect clip((bb.left + bb.right - w) / 2, std::max(0, bottom - h), w, h);
+
+            int visible = 0;
+            gen.visit(clip, lodMinWidth(scale), [&visible](int, bool) { ++visible; });
+
+            std::cerr << "scale " << scale << ": " << visible << " nodes/glyphs visible\n";
+
+            perfHelper.begin("paint 5 frames: batched");
+            for (int i = 0; i < FRAMES; ++i) paint(batched, gen, clip, scale, true);
+            perfHelper.end();
+
+            perfHelper.begin("paint 5 frames: draw calls per node");
+            for (int i = 0; i < FRAMES; ++i) paint(single, gen, clip, scale, false);
+            perfHelper.end();
+
+            /// the order of overlapping primitives differs, little else should
+            const int expected = inkedPixels(single);
+            const int inked = inkedPixels(batched);
+            if (visible == 0 || inked == 0 || std::abs(inked - expected) > expected / 10) {
+                std::cerr << "scale " << scale << ": " << inked << " pixels drawn, "
+                          << expected << " expected\n";
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    void test_module() {
+
+        NodeTree nt;
+        /// leaves of every kind
+        utils::buildCompleteTree(nt, 300000, {FAILED, SOLVED, FAILED, SKIPPED, UNDETERMINED});
+
+        auto& na = nt.getNA();
+        nt.getRoot()->layout(na);
+
+        const auto gen = LayoutGeneration::build(nt.getRoot(), na, 1);
+
+        if (paintTimes(*gen)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (batched painting)\n";
+        }
+    }
+}
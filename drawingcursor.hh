@@ -24,8 +24,11 @@
 
 #include "nodecursor.hh"
 #include "layoutcursor.hh"
+#include "layoutgeneration.hh"
 #include <QtGui>
 
+namespace drawingcursor { void test_module(); }
+
 namespace cpprofiler {
 namespace colors {
     /// The color for selected nodes
@@ -91,6 +94,27 @@ public:
     //@}
 };
 
+/// Draw node \a n with \a flags (see `PlacedNode::Flags`), and the edge
+/// to its parent if \a edge is set; \a label and \a outline (the node's
+/// shape, \a depth extents) may be nullptr
+void drawPlacedNode(QPainter& painter, const PlacedNode& n, uint16_t flags,
+                    bool edge, const QString* label, PlacedNode::LabelSide side,
+                    const Extent* outline, int depth);
+
+/// Subtrees narrower than this (in tree coordinates) are drawn as a
+/// single glyph at \a scale (see `drawGeneration`)
+int lodMinWidth(double scale);
+
+/// Draw the nodes of \a gen the way `DrawingCursor` draws the tree,
+/// without descending into subtrees outside of \a clip. At \a scale,
+/// subtrees a few pixels wide are drawn as a single glyph and labels
+/// are left out once they would be unreadable. The flags the user may
+/// have changed since the layout (see `PlacedNode::INTERACTIVE`) are
+/// taken from \a live (by node index) for the nodes it has.
+void drawGeneration(QPainter& painter, const LayoutGeneration& gen,
+                    const QRect& clip, double scale,
+                    const std::unordered_map<int, uint16_t>* live);
+
 #include "drawingcursor.hpp"
 
 #endif
@@ -65,6 +65,7 @@ static void deleteNode(Execution& ex, Node* n) {
   if (!parent) return;
   parent->removeChild(n->getIndex(na));
   parent->dirtyUp(na);
+  ex.nodeTree().thaw();
 }
 
 static void deleteSkippedNodes(Execution& ex) {
@@ -100,6 +101,23 @@ static void deleteWhiteNodes(Execution& ex) {
   }
 }
 
+/// The defaults, unless overridden in settings.json (0 keeps a default)
+static IngestLimits ingestLimits() {
+    auto limits = IngestLimits::defaults();
+
+    constexpr uint64_t MB = 1024 * 1024;
+
+    const int spill_mb = Settings::get_int("overload_spill_memory_mb");
+    if (spill_mb > 0) limits.spill_memory = spill_mb * MB;
+
+    const int stats_mb = Settings::get_int("overload_stats_memory_mb");
+    if (stats_mb > 0) limits.stats_memory = stats_mb * MB;
+
+    const int node_budget = Settings::get_int("overload_node_budget");
+    if (node_budget > 0) limits.node_budget = node_budget;
+
+    return limits;
+}
 
 void Execution::begin(std::string label, bool isRestarts) {
 
@@ -107,13 +125,7 @@ void Execution::begin(std::string label, bool isRestarts) {
 
     setTitle(label);
 
-    // qDebug() << "Execution::start";
-    connect(this, &Execution::doneReceiving, [this]() {
-      qDebug() << "setDoneReceiving";
-      m_Data->setDoneReceiving();
-    });
-
-    connect(m_Builder.get(), &TreeBuilder::addedNode, this, &Execution::newNode);
+    connect(m_Builder.get(), &TreeBuilder::addedNodes, this, &Execution::newNodes);
     connect(m_Builder.get(), &TreeBuilder::addedRoot, this, &Execution::newRoot);
 
     connect(m_Builder.get(), &TreeBuilder::doneBuilding, [this]() {
@@ -122,10 +134,14 @@ void Execution::begin(std::string label, bool isRestarts) {
         printSearchLog(*this);
       }
 
+      /// the tree is read-only from now on (unless edited by hand)
+      m_NodeTree->snapshot();
+
       finished = true;
       emit doneBuilding();
     });
 
+    m_Data->setIngestLimits(ingestLimits());
     m_Data->initReceiving();
     m_Builder->start();
 
@@ -135,40 +151,74 @@ void Execution::begin(std::string label, bool isRestarts) {
 const NogoodViews* Execution::getNogood(const Node& node) const {
     auto entry = getEntry(node);
     if (!entry) return nullptr;
-    auto nogood = m_Data->getNogoods().find(entry->nodeUID);
-    if (nogood == m_Data->getNogoods().end()) return nullptr;
-    return &nogood->second;
+    return m_Data->findNogood(entry.nodeUID());
 }
 
 NodeUID Execution::getParentUID(const NodeUID uid) const {
-  DbEntry* entry = getEntry(getGidByUID(uid));
-  return entry->parentUID;
+  DbEntry entry = getEntry(getGidByUID(uid));
+  if (!entry) return {-1, -1, -1};
+  return entry.parentUID();
 }
 
 const std::string* Execution::getInfo(const Node& node) const {
     auto entry = getEntry(node);
     if (!entry) return nullptr;
-    return getInfo(entry->nodeUID);
+    return getInfo(entry.nodeUID());
 }
 
 const int* Execution::getObjective(const Node& node) const {
   auto entry = getEntry(node);
   if (!entry) return nullptr;
-  return m_Data->getObjective(entry->nodeUID);
+  return m_Data->getObjective(entry.nodeUID());
 }
 
 const std::string* Execution::getInfo(NodeUID uid) const {
-  auto info = m_Data->uid2info.find(uid);
-  if (info == m_Data->uid2info.end()) return nullptr;
-  return info->second.get();
+  /// NOTE(maxim): the pointer stays valid as Data keeps its own copy
+  return m_Data->getInfo(uid).get();
+}
+
+NodeInfo Execution::getNodeInfo(const Node& node) const {
+  auto entry = getEntry(node);
+  if (!entry) return {};
+  return getNodeInfo(entry.nodeUID());
+}
+
+NodeInfo Execution::getNodeInfo(NodeUID uid) const {
+  return m_Data->getNodeInfo(uid);
+}
+
+std::vector<int> Execution::getReasons(NodeUID uid) const {
+  return m_Data->getNodeInfo(uid).reasons;
 }
 
 Statistics& Execution::getStatistics() {
         return m_NodeTree->getStatistics();
 }
 
-void Execution::handleNewNode(const cpprofiler::Message& msg) {
-    m_Data->handleNodeCallback(msg);
+IngestSource* Execution::openSource() {
+    return m_Data->openSource();
+}
+
+bool Execution::isBackedUp(const IngestSource* source) const {
+    return m_Data->isBackedUp(source);
+}
+
+bool Execution::closeSource(IngestSource* source) {
+    if (!m_Data->closeSource(source)) return false;
+
+    qDebug() << "doneReceiving";
+    emit doneReceiving();
+    return true;
+}
+
+void Execution::handleNewNode(IngestSource* source, const cpprofiler::Message& msg) {
+    m_Data->handleNodeCallback(source, msg);
+}
+
+void Execution::handleNodeBatch(IngestSource* source, const char* payload, size_t size) {
+    if (!m_Data->handleNodeBatch(source, payload, size)) {
+        std::cerr << "malformed node batch, the rest of it is ignored\n";
+    }
 }
 
 const Uid2Nogood& Execution::getNogoods() const {
@@ -177,10 +227,9 @@ const Uid2Nogood& Execution::getNogoods() const {
 
 static std::string empty_string;
 const std::string& Execution::getNogoodByUID(NodeUID uid, bool renamed, bool simplified) const {
-  const auto& ng_map = m_Data->getNogoods();
-  auto maybe_nogood = ng_map.find(uid);
-  if (maybe_nogood != ng_map.end()){
-    const NogoodViews& ng = maybe_nogood->second;
+  auto maybe_nogood = m_Data->findNogood(uid);
+  if (maybe_nogood) {
+    const NogoodViews& ng = *maybe_nogood;
 
     if(renamed && (ng.renamed != "")) {
       return simplified ? ng.simplified : ng.renamed;
@@ -192,9 +241,9 @@ const std::string& Execution::getNogoodByUID(NodeUID uid, bool renamed, bool sim
   return empty_string;
 }
 
-DbEntry* Execution::getEntry(int gid) const { return m_Data->getEntry(gid); }
+DbEntry Execution::getEntry(int gid) const { return m_Data->getEntry(gid); }
 
-DbEntry* Execution::getEntry(const Node& node) const {
+DbEntry Execution::getEntry(const Node& node) const {
     auto gid = node.getIndex(m_NodeTree->getNA());
     return getEntry(gid);
 }
@@ -215,6 +264,22 @@ std::string Execution::getLabel(const VisualNode& node, bool rename) const {
   return getLabel(gid, rename);
 }
 
+int32_t Execution::getLabelId(int gid) const { return m_Data->getLabelId(gid); }
+
+int32_t Execution::getLabelId(const VisualNode& node) const {
+  auto gid = node.getIndex(m_NodeTree->getNA());
+  return getLabelId(gid);
+}
+
+std::string Execution::getLabelText(int32_t label_id, bool rename) const {
+  const auto& origLabel = utils::LabelDictionary::global().label(label_id);
+  if(rename) {
+    const auto* nm = m_Data->getNameMap();
+    return nm ? nm->replaceNames(origLabel) : origLabel;
+  }
+  return origLabel;
+}
+
 unsigned long long Execution::getTotalTime() { return m_Data->getTotalTime(); }
 
 void Execution::compareDomains() {
@@ -8,9 +8,10 @@
 #include <memory>
 // #include "nodetree.hh"
 #include <unordered_map>
-#include <QWaitCondition>
+#include <atomic>
 
 #include "nogood_representation.hh"
+#include "nodeinfo.hh"
 
 class Data;
 class NameMap;
@@ -28,6 +29,7 @@ namespace cpprofiler {
 }
 
 class TreeBuilder;
+class IngestSource;
 
 class Execution : public QObject {
     Q_OBJECT
@@ -49,6 +51,13 @@ public:
 
     const int* getObjective(const Node& node) const;
 
+    /// Decoded fields of the node's info (see `NodeInfo`)
+    NodeInfo getNodeInfo(const Node& node) const;
+    NodeInfo getNodeInfo(NodeUID uid) const;
+
+    /// Constraint ids the node's nogood was derived from
+    std::vector<int> getReasons(NodeUID uid) const;
+
     int getExecutionId() const {
         return execution_id;
     }
@@ -65,8 +74,8 @@ public:
         return ss.str();
     }
     
-    DbEntry* getEntry(int gid) const;
-    DbEntry* getEntry(const Node& node) const;
+    DbEntry getEntry(int gid) const;
+    DbEntry getEntry(const Node& node) const;
 
     const NodeTree& nodeTree() const { return *m_NodeTree.get(); }
 
@@ -81,6 +90,14 @@ public:
 
     std::string getLabel(const VisualNode& node, bool rename = true) const;
 
+    /// Label id in `utils::LabelDictionary::global()`; labels compare
+    /// (and group) by their ids much faster than by their text
+    int32_t getLabelId(int gid) const;
+    int32_t getLabelId(const VisualNode& node) const;
+
+    /// Text of the label with id `label_id`
+    std::string getLabelText(int32_t label_id, bool rename = true) const;
+
     void setLabel(const VisualNode& n, const std::string& str);
 
     unsigned long long getTotalTime();
@@ -89,6 +106,18 @@ public:
 
     void begin(std::string label, bool isRestarts);
 
+    /// A new producer of nodes, e.g. one of several solver connections
+    /// (any thread)
+    IngestSource* openSource();
+
+    /// The producer is done; once all are, emits `doneReceiving` and
+    /// returns true
+    bool closeSource(IngestSource* source);
+
+    /// Whether the builder is falling behind `source` (the producer
+    /// should stop reading for a while)
+    bool isBackedUp(const IngestSource* source) const;
+
     bool isRestarts() const { return _is_restarts; }
 
     Statistics& getStatistics();
@@ -109,21 +138,25 @@ public:
 
     bool finished{false};
 
-    /// these two go together
-    bool has_exec_id{false};
-    QWaitCondition has_exec_id_cond;
+    /// set (on the GUI thread) once the name map is known; `execIdKnown`
+    /// follows, for receivers waiting on it
+    std::atomic<bool> has_exec_id{false};
 
 public slots:
-    void handleNewNode(const cpprofiler::Message& node);
+    void handleNewNode(IngestSource* source, const cpprofiler::Message& node);
+    /// Nodes packed into a NODE_BATCH frame (see nodebatch.hh)
+    void handleNodeBatch(IngestSource* source, const char* payload, size_t size);
     /// Compare domains of two nodes (highlighted)
     void compareDomains();
 
 signals:
-    void newNode();
+    /// Nodes [first, last) in placement order were added to the tree
+    void newNodes(quint64 first, quint64 last);
     void newRoot();
     void titleKnown();
     void doneReceiving();
     void doneBuilding();
+    void execIdKnown();
 
 private:
     std::unique_ptr<NodeTree> m_NodeTree;
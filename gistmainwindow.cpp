@@ -52,6 +52,8 @@ class NodeStatsBar : public QWidget {
   QLabel* choicesLabel;
   /// Status bar label for number of open nodes
   QLabel* openLabel;
+  /// Status bar label for nodes/sec received vs placed into the tree
+  QLabel* rateLabel;
 
 public:
 
@@ -78,6 +80,9 @@ public:
     hbl->addWidget(new NodeWidget(UNDETERMINED));
     openLabel = new QLabel("0");
     hbl->addWidget(openLabel);
+
+    rateLabel = new QLabel("");
+    hbl->addWidget(rateLabel);
   }
 
   void display(const Statistics& stats) {
@@ -87,6 +92,11 @@ public:
     choicesLabel->setNum(stats.choices);
     openLabel->setNum(stats.undetermined);
   }
+
+  void displayRates(uint64_t ingested_ps, uint64_t placed_ps) {
+    rateLabel->setText("in: " + QString::number(ingested_ps) + "/s placed: " +
+                       QString::number(placed_ps) + "/s");
+  }
 };
 
 GistMainWindow::GistMainWindow(Execution& e,
@@ -154,6 +164,10 @@ GistMainWindow::GistMainWindow(Execution& e,
 
   connect(m_Canvas.get(), &TreeCanvas::moreNodesDrawn, this, &GistMainWindow::updateStatsBar);
 
+  rateTimer = new QTimer(this);
+  connect(rateTimer, &QTimer::timeout, this, &GistMainWindow::updateRates);
+  rateTimer->start(RATE_INTERVAL_MS);
+
   /// in case the above was too late
   if (execution.getData().isDone()) {
     qDebug() << "too late!";
@@ -295,10 +309,40 @@ GistMainWindow::updateStatsBar() {
   m_NodeStatsBar->display(stats);
 }
 
+void
+GistMainWindow::updateRates() {
+  const auto& data = execution.getData();
+
+  const uint64_t ingested = data.nodesIngested();
+  const uint64_t placed = data.nodesPlaced();
+
+  m_NodeStatsBar->displayRates(
+    (ingested - lastIngested) * 1000 / RATE_INTERVAL_MS,
+    (placed - lastPlaced) * 1000 / RATE_INTERVAL_MS);
+
+  lastIngested = ingested;
+  lastPlaced = placed;
+
+  switch (data.ingestMode()) {
+    case IngestMode::SPILL:
+      statusBar()->showMessage("Overloaded: nogoods and info are kept on disk");
+      break;
+    case IngestMode::STATS_ONLY:
+      statusBar()->showMessage("Overloaded: " +
+                               QString::number(data.countedNodes().total) +
+                               " nodes counted but not drawn");
+      break;
+    default:
+      break;
+  }
+}
+
 void
 GistMainWindow::finishStatsBar() {
   QMutexLocker locker(&gistMutex);
 
+  rateTimer->stop();
+
   qDebug() << "finishStatsBar in thread: " << QThread::currentThreadId();
 
   qDebug() << "finish stats bar";
@@ -311,7 +355,15 @@ GistMainWindow::finishStatsBar() {
     auto totalTime = execution.getData().getTotalTime();
     float seconds = totalTime / 1000000.0;
 
-    statusBar()->showMessage("Done in " + QString::number(seconds) + "s");
+    /// memory taken by the layout of this execution
+    const auto shapes = execution.nodeTree().getNA().shapes().stats();
+    const QString shapes_info = QString::number(shapes.distinct) + " distinct shapes for " +
+                                QString::number(shapes.references) + " nodes: " +
+                                QString::number(shapes.bytes / 1024) + " KB (" +
+                                QString::number(shapes.unshared_bytes / 1024) +
+                                " KB if unshared)";
+
+    statusBar()->showMessage("Done in " + QString::number(seconds) + "s; " + shapes_info);
   } else {
 
     qDebug() << "~~~ not done building yet";
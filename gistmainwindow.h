@@ -27,8 +27,10 @@
 #include <QVariant>
 #include <QMutex>
 #include <memory>
+#include <cstdint>
 
 class QLabel;
+class QTimer;
 class QAction;
 class NodeStatInspector;
 class TreeCanvas;
@@ -65,6 +67,13 @@ private:
 
   QString statsFilename;
 
+  /// How often the ingest/placement rates are sampled
+  static constexpr int RATE_INTERVAL_MS = 1000;
+  QTimer* rateTimer;
+  /// Node counters at the time of the last sample
+  uint64_t lastIngested = 0;
+  uint64_t lastPlaced = 0;
+
   QMutex gistMutex {QMutex::Recursive};
 
     /// Context menu
@@ -204,6 +213,8 @@ private Q_SLOTS:
   void updateStatsBar();
   /// update "searching" to "done"
   void finishStatsBar();
+  /// update nodes/sec received vs placed (status bar)
+  void updateRates();
     /// Displays the context menu for a node
   void onContextMenu(QContextMenuEvent*);
   /// Reacts on bookmark selection
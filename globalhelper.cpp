@@ -60,6 +60,15 @@ QCommandLineOption GlobalParser::auto_compare{
 QCommandLineOption GlobalParser::auto_stats{
     "auto_stats", "Write statistics to <file_name>.", "file_name"};
 
+QCommandLineOption GlobalParser::capture_option{
+    "capture", "Record the raw stream from solvers to <file_name>.", "file_name"};
+
+QCommandLineOption GlobalParser::replay_option{
+    "replay", "Replay a stream recorded with --capture from <file_name>.", "file_name"};
+
+QCommandLineOption GlobalParser::replay_paced{
+    "replay_paced", "Replay at the pace the stream was recorded (default: as fast as possible)"};
+
 GlobalParser::GlobalParser() {
   if (_self) {
     std::cerr << "Can't have two of GlobalParser, terminate\n";
@@ -78,6 +87,9 @@ GlobalParser::GlobalParser() {
   clParser.addOption(save_log);
   clParser.addOption(auto_compare);
   clParser.addOption(auto_stats);
+  clParser.addOption(capture_option);
+  clParser.addOption(replay_option);
+  clParser.addOption(replay_paced);
 }
 
 bool GlobalParser::isSet(const QCommandLineOption& opt) {
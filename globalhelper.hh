@@ -52,6 +52,10 @@ class GlobalParser {
 
   static QCommandLineOption auto_stats;
 
+  static QCommandLineOption capture_option;
+  static QCommandLineOption replay_option;
+  static QCommandLineOption replay_paced;
+
  public:
   GlobalParser();
   ~GlobalParser();
@@ -56,6 +56,9 @@ public:
     /// Compute layout for current node
     void processCurrentNode(void);
     //@}
+
+    /// Compute layout for \a n, whose dirty children have been laid out
+    static void layoutNode(VisualNode* n, const NodeAllocator& na);
 };
 
 #include "layoutcursor.hpp"
@@ -47,13 +47,14 @@ LayoutCursor::LayoutCursor(VisualNode* theNode,
     : NodeCursor(theNode,na) {}
 
 
+/// Built in scratch space (see `Shape::scratch`), to be interned
 static Shape* sizedRectangleLevels(int levels) {
 
     using sized_rect::HALF_WIDTH;
 
     // if (levels == 1) levels = 2;
 
-    auto shape = Shape::allocate(levels);
+    auto shape = Shape::scratch(levels);
     (*shape)[0] = Extent(-HALF_WIDTH, HALF_WIDTH);
 
     if (levels > 1) {
@@ -64,8 +65,6 @@ static Shape* sizedRectangleLevels(int levels) {
         (*shape)[l] = Extent(0, 0);
     }
 
-    shape->computeBoundingBox();
-
     return shape;
 }
 
@@ -82,17 +81,16 @@ static Shape* sizedRectangle(int size) {
 }
 
 inline void
-LayoutCursor::processCurrentNode(void) {
-    VisualNode* currentNode = node();
+LayoutCursor::layoutNode(VisualNode* currentNode, const NodeAllocator& na) {
     // qDebug() << "LayoutCursor visiting node " << currentNode->debug_id << " whose dirtiness is" << currentNode->isDirty();
     if (currentNode->isDirty()) {
         // std::cerr << "LayoutCurser: node is dirty\n";
         if (currentNode->isHidden()) {
             // do nothing
             auto shape = sizedRectangle(currentNode->getSubtreeSize());
-            currentNode->setShape(shape);
+            currentNode->setShape(na.shapes().intern(shape), na);
         } else if (false && currentNode->getNumberOfChildren() < 1) {
-            currentNode->setShape(Shape::leaf);
+            currentNode->setShape(Shape::leaf, na);
         } else {
             currentNode->computeShape(na);
         }
@@ -101,3 +99,8 @@ LayoutCursor::processCurrentNode(void) {
     if (currentNode->getNumberOfChildren() >= 1)
         currentNode->setChildrenLayoutDone(true);
 }
+
+inline void
+LayoutCursor::processCurrentNode(void) {
+    layoutNode(node(), na);
+}
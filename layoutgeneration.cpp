@@ -0,0 +1,844 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#include "layoutgeneration.hh"
+#include "nodecursor.hh"
+#include "nodevisitor.hh"
+#include "nodetree.hh"
+#include "cpprofiler/utils/tree_utils.hh"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <QHash>
+#include <QFont>
+#include <QFontMetrics>
+
+#include "libs/perf_helper.hh"
+
+uint16_t PlacedNode::flagsOf(VisualNode& n) {
+    uint16_t flags = 0;
+    if (n.isHidden()) flags |= HIDDEN;
+    if (n.isMarked()) flags |= MARKED;
+    if (n.isOnPath()) flags |= ONPATH;
+    if (n.isHighlighted()) flags |= HIGHLIGHTED;
+    if (n.isBookmarked()) flags |= BOOKMARKED;
+    if (n.isSelected()) flags |= SELECTED;
+    if (n.isHovered()) flags |= HOVERED;
+    if (n.isInvisible()) flags |= INVISIBLE;
+    if (n.childrenLayoutIsDone()) flags |= LAYOUT_DONE;
+    if (n.hasOpenChildren()) flags |= OPEN_CHILDREN;
+    if (n.hasSolvedChildren()) flags |= SOLVED_CHILDREN;
+    if (n.hasFailedChildren()) flags |= FAILED_CHILDREN;
+    return flags;
+}
+
+static uint64_t mix(uint64_t h, uint64_t value) {
+    return h ^ (value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+/// Everything about `n` itself that `drawPlacedNode` draws, relative to
+/// the edge from its parent (so that a subtree keeps its hash when moved)
+static uint64_t ownHash(const PlacedNode& n, const QString* label) {
+    uint64_t h = mix(n.gid, n.x - n.parent_x);
+    h = mix(h, n.y);
+    h = mix(h, n.flags & ~PlacedNode::INTERACTIVE);
+    h = mix(h, (n.status << 16) | (n.tid << 8) | static_cast<uint8_t>(n.subtree_size));
+    if (label != nullptr) h = mix(h, qHash(*label));
+    return h;
+}
+
+std::unordered_set<int> LayoutDraft::dirtyNodes(VisualNode* root, const NodeAllocator& na) {
+
+    std::unordered_set<int> dirty;
+    if (root == nullptr) return dirty;
+
+    std::vector<VisualNode*> stack{root};
+
+    while (!stack.empty()) {
+        VisualNode* n = stack.back();
+        stack.pop_back();
+
+        /// as in `LayoutCursor::mayMoveDownwards`
+        if (!n->isDirty()) continue;
+        dirty.insert(n->getIndex(na));
+
+        for (int alt = 0; alt < static_cast<int>(n->getNumberOfChildren()); ++alt) {
+            stack.push_back(n->getChild(na, alt));
+        }
+    }
+
+    return dirty;
+}
+
+LayoutDraft::LayoutDraft(VisualNode* root, const NodeAllocator& na,
+                         std::shared_ptr<const LayoutGeneration> previous,
+                         const std::unordered_set<int>& dirty)
+    : m_previous(std::move(previous)) {
+
+    if (root == nullptr || root->getShape() == nullptr) return;
+
+    m_depth = root->getShape()->depth();
+
+    const LayoutGeneration* before = m_previous.get();
+    const int root_gid = root->getIndex(na);
+
+    struct Item {
+        VisualNode* node;
+        int gid;
+        int parent;
+        /// the node in `before`, -1 if it is not there
+        int was;
+    };
+
+    const bool reusable = before != nullptr && !before->empty() && (*before)[0].gid == root_gid;
+    std::vector<Item> stack{{root, root_gid, -1, reusable ? 0 : -1}};
+
+    /// children of the node in `before`
+    std::vector<int> kids_was;
+
+    while (!stack.empty()) {
+        const Item item = stack.back();
+        stack.pop_back();
+
+        VisualNode* n = item.node;
+        const int i = static_cast<int>(m_pieces.size());
+
+        PlacedNode p;
+        p.gid = item.gid;
+        if (item.parent == -1) {
+            p.x = 0;
+            p.y = 0;
+        } else {
+            const PlacedNode& parent = m_pieces[item.parent].node;
+            p.x = parent.x + n->getOffset();
+            p.y = parent.y + Layout::dist_y;
+        }
+        p.parent_x = p.x - n->getOffset();
+
+        /// not laid out since `before`, so drawn as it was there
+        if (item.was != -1 && dirty.count(item.gid) == 0) {
+            m_pieces.push_back(Piece{p, item.parent, item.was});
+            continue;
+        }
+
+        const Shape* shape = n->getShape();
+        const BoundingBox& bb = shape->getBoundingBox();
+        p.left = p.x + bb.left;
+        p.right = p.x + bb.right;
+        p.bottom = p.y + (shape->depth() + 1) * Layout::dist_y;
+
+        VisualNode* parent = n->getParent(na);
+
+        p.flags = PlacedNode::flagsOf(*n);
+        if (parent == nullptr || parent->_tid != n->_tid) p.flags |= PlacedNode::NEW_THREAD;
+        p.status = n->getStatus();
+        p.tid = n->_tid;
+        p.subtree_size = static_cast<int8_t>(n->getSubtreeSize());
+
+        if (na.hasLabel(n)) {
+            const int alt = parent ? n->getAlternative(na) : 0;
+            const int n_alt = parent ? parent->getNumberOfChildren() : 1;
+            PlacedNode::LabelSide side = PlacedNode::LABEL_CENTER;
+            if (alt == 0 && n_alt > 1) {
+                side = PlacedNode::LABEL_LEFT;
+            } else if (alt == n_alt - 1 && n_alt > 1) {
+                side = PlacedNode::LABEL_RIGHT;
+            }
+            m_labels.push_back(Label{i, na.getLabel(n), side});
+            p.hash = mix(ownHash(p, &m_labels.back().text), side);
+        } else {
+            p.hash = ownHash(p, nullptr);
+        }
+
+        /// the shape is drawn behind these (see `drawPlacedNode`)
+        if (p.flags & (PlacedNode::HIGHLIGHTED | PlacedNode::NEW_THREAD)) {
+            m_outlines.emplace_back(i, std::vector<Extent>());
+            auto& outline = m_outlines.back().second;
+            for (int d = 0; d < shape->depth(); ++d) outline.push_back((*shape)[d]);
+        }
+
+        /// where `VisualNode::findNode` would find the node: only its own
+        /// extent, unless it is hidden
+        const int row = p.y / Layout::dist_y;
+        const int levels = n->isHidden() ? shape->depth() : 1;
+
+        int left = p.x;
+        int right = p.x;
+        for (int d = 0; d < levels; ++d) {
+            left += (*shape)[d].l;
+            right += (*shape)[d].r;
+            m_spans.push_back(Span{row + d, left, right, i});
+        }
+
+        m_pieces.push_back(Piece{p, item.parent, -1});
+
+        /// the same nodes `DrawingCursor` would descend to
+        if (n->isHidden() || !n->childrenLayoutIsDone()) continue;
+
+        kids_was.clear();
+        if (item.was != -1) {
+            const PlacedNode& was = (*before)[item.was];
+            for (int j = item.was + 1; j < was.end; j = (*before)[j].end) kids_was.push_back(j);
+        }
+
+        const int kids = n->getNumberOfChildren();
+        const bool same_kids = static_cast<int>(kids_was.size()) == kids;
+
+        for (int alt = kids - 1; alt >= 0; --alt) {
+            const int gid = n->getChild(alt);
+            const int was = same_kids && (*before)[kids_was[alt]].gid == gid ? kids_was[alt] : -1;
+            stack.push_back({n->getChild(na, alt), gid, i, was});
+        }
+    }
+}
+
+/// Labels are drawn this far from their node (see `drawPlacedNode`)
+constexpr int LABEL_GAP = 4;
+
+/// Width of `text` in the font tiles are drawn with
+static int labelWidth(const QString& text) {
+    return QFontMetrics(QFont()).width(text);
+}
+
+std::shared_ptr<const LayoutGeneration>
+LayoutGeneration::build(const LayoutDraft& draft, uint64_t number) {
+
+    auto gen = std::make_shared<LayoutGeneration>();
+    gen->m_number = number;
+    gen->m_depth = draft.m_depth;
+
+    const auto& pieces = draft.m_pieces;
+    const int count = static_cast<int>(pieces.size());
+
+    /// where every piece went among the nodes
+    std::vector<int> index(count);
+
+    auto label = draft.m_labels.begin();
+    auto outline = draft.m_outlines.begin();
+    auto span = draft.m_spans.begin();
+
+    for (int p = 0; p < count; ++p) {
+        const auto& piece = pieces[p];
+        const int i = static_cast<int>(gen->m_nodes.size());
+        index[p] = i;
+
+        if (piece.reuse != -1) {
+            gen->copySubtree(*draft.m_previous, piece.reuse, piece.node.x, piece.node.parent_x);
+            continue;
+        }
+
+        gen->m_nodes.push_back(piece.node);
+        gen->m_nodes.back().end = i + 1;
+
+        for (; label != draft.m_labels.end() && label->piece == p; ++label) {
+            gen->m_labels.push_back(Label{i, label->text, label->side, labelWidth(label->text)});
+        }
+        for (; outline != draft.m_outlines.end() && outline->first == p; ++outline) {
+            gen->m_outlines.emplace_back(i, outline->second);
+        }
+        for (; span != draft.m_spans.end() && span->piece == p; ++span) {
+            auto& rows = gen->m_rows;
+            if (rows.size() <= static_cast<size_t>(span->row)) rows.resize(span->row + 1);
+            rows[span->row].push_back(Span{span->left, span->right, i});
+        }
+    }
+
+    /// a subtree ends where the last subtree of its children ends; the
+    /// descendants of a node (after it) are complete before it is reached
+    for (int p = count - 1; p > 0; --p) {
+        PlacedNode& parent = gen->m_nodes[index[pieces[p].parent]];
+        const PlacedNode& node = gen->m_nodes[index[p]];
+        if (node.end > parent.end) parent.end = node.end;
+        parent.hash = mix(parent.hash, node.hash);
+    }
+
+    for (const auto& label : gen->m_labels) {
+        gen->m_label_reach = std::max(gen->m_label_reach, label.width + LABEL_GAP);
+    }
+
+    return gen;
+}
+
+std::shared_ptr<const LayoutGeneration>
+LayoutGeneration::build(VisualNode* root, const NodeAllocator& na, uint64_t number) {
+    return build(LayoutDraft(root, na), number);
+}
+
+void LayoutGeneration::copySubtree(const LayoutGeneration& from, int k, int x, int parent_x) {
+
+    const PlacedNode& root = from[k];
+    const int i = static_cast<int>(m_nodes.size());
+    const int dx = x - root.x;
+    const int di = i - k;
+
+    m_nodes.insert(m_nodes.end(), from.m_nodes.begin() + k, from.m_nodes.begin() + root.end);
+    for (auto it = m_nodes.begin() + i; it != m_nodes.end(); ++it) {
+        it->x += dx;
+        it->parent_x += dx;
+        it->left += dx;
+        it->right += dx;
+        it->end += di;
+    }
+
+    PlacedNode& copy = m_nodes[i];
+    copy.parent_x = parent_x;
+
+    auto label = std::lower_bound(from.m_labels.begin(), from.m_labels.end(), k,
+                                  [](const Label& l, int k) { return l.index < k; });
+    for (; label != from.m_labels.end() && label->index < root.end; ++label) {
+        m_labels.push_back(*label);
+        m_labels.back().index += di;
+    }
+
+    using Outline = std::pair<int, std::vector<Extent>>;
+    auto outline = std::lower_bound(from.m_outlines.begin(), from.m_outlines.end(), k,
+                                    [](const Outline& o, int k) { return o.first < k; });
+    for (; outline != from.m_outlines.end() && outline->first < root.end; ++outline) {
+        m_outlines.emplace_back(outline->first + di, outline->second);
+    }
+
+    /// a row lists nodes in preorder, so those of the subtree are together
+    for (size_t row = root.y / Layout::dist_y; row < from.m_rows.size(); ++row) {
+        const auto& spans = from.m_rows[row];
+        auto it = std::lower_bound(spans.begin(), spans.end(), k,
+                                   [](const Span& span, int k) { return span.index < k; });
+        if (it == spans.end() || it->index >= root.end) break;
+
+        if (m_rows.size() <= row) m_rows.resize(row + 1);
+        for (; it != spans.end() && it->index < root.end; ++it) {
+            m_rows[row].push_back(Span{it->left + dx, it->right + dx, it->index + di});
+        }
+    }
+
+    /// only the hash of the root depends on where the subtree is now
+    PlacedNode::LabelSide side;
+    const QString* text = this->label(i, side);
+    uint64_t hash = text ? mix(ownHash(copy, text), side) : ownHash(copy, nullptr);
+
+    std::vector<int> kids;
+    for (int j = i + 1; j < copy.end; j = m_nodes[j].end) kids.push_back(j);
+    for (auto it = kids.rbegin(); it != kids.rend(); ++it) hash = mix(hash, m_nodes[*it].hash);
+
+    copy.hash = hash;
+}
+
+const QString* LayoutGeneration::label(int i, PlacedNode::LabelSide& side) const {
+    auto it = std::lower_bound(m_labels.begin(), m_labels.end(), i,
+                               [](const Label& l, int i) { return l.index < i; });
+    if (it == m_labels.end() || it->index != i) return nullptr;
+    side = it->side;
+    return &it->text;
+}
+
+const std::vector<Extent>* LayoutGeneration::outline(int i) const {
+    using Outline = std::pair<int, std::vector<Extent>>;
+    auto it = std::lower_bound(m_outlines.begin(), m_outlines.end(), i,
+                               [](const Outline& o, int i) { return o.first < i; });
+    return it == m_outlines.end() || it->first != i ? nullptr : &it->second;
+}
+
+BoundingBox LayoutGeneration::boundingBox() const {
+    BoundingBox bb;
+    bb.left = m_nodes.empty() ? 0 : m_nodes[0].left;
+    bb.right = m_nodes.empty() ? 0 : m_nodes[0].right;
+    return bb;
+}
+
+int LayoutGeneration::nodeAt(int x, int y) const {
+
+    if (y < 0 || static_cast<size_t>(y / Layout::dist_y) >= m_rows.size()) return -1;
+
+    const auto& spans = m_rows[y / Layout::dist_y];
+
+    /// the last span starting at or before `x`
+    auto it = std::upper_bound(spans.begin(), spans.end(), x,
+                               [](int x, const Span& span) { return x < span.left; });
+    if (it == spans.begin()) return -1;
+    --it;
+
+    return x <= it->right ? it->index : -1;
+}
+
+std::vector<int> LayoutGeneration::nodesIn(const QRect& rect) const {
+
+    std::vector<int> found;
+
+    if (rect.bottom() < 0 || m_rows.empty()) return found;
+
+    const int first = std::max(0, rect.top() / Layout::dist_y);
+    const int last = std::min(static_cast<int>(m_rows.size()) - 1,
+                              rect.bottom() / Layout::dist_y);
+
+    for (int row = first; row <= last; ++row) {
+        const auto& spans = m_rows[row];
+        /// the first span ending at or after the left edge
+        auto it = std::lower_bound(spans.begin(), spans.end(), rect.left(),
+                                   [](const Span& span, int x) { return span.right < x; });
+        for (; it != spans.end() && it->left <= rect.right(); ++it) {
+            found.push_back(it->index);
+        }
+    }
+
+    /// hidden nodes may be found in several rows
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    return found;
+}
+
+constexpr size_t MAX_CHANGED_AREAS = 1024;
+
+/// Where the subtree of `n` and the edge to it are drawn
+static QRect subtreeArea(const PlacedNode& n) {
+    const int left = std::min(n.left, n.parent_x);
+    const int right = std::max(n.right, n.parent_x);
+    const int top = n.y - Layout::dist_y;
+    return QRect(left, top, right - left + 1, n.bottom - top + 1);
+}
+
+std::vector<QRect> LayoutGeneration::changedAreas(const LayoutGeneration& before) const {
+
+    std::vector<QRect> areas;
+
+    if (empty() || before.empty() || m_nodes[0].gid != before[0].gid) {
+        if (!empty()) areas.push_back(subtreeArea(m_nodes[0]));
+        if (!before.empty()) areas.push_back(subtreeArea(before[0]));
+        return areas;
+    }
+
+    /// pairs of the same node in this generation and in `before`
+    std::vector<std::pair<int, int>> stack{{0, 0}};
+
+    while (!stack.empty()) {
+        const int i = stack.back().first;
+        const int k = stack.back().second;
+        stack.pop_back();
+
+        const PlacedNode& now = m_nodes[i];
+        const PlacedNode& was = before[k];
+
+        if (now.hash == was.hash) continue;
+
+        PlacedNode::LabelSide side_now, side_was;
+        const QString* label_now = label(i, side_now);
+        const QString* label_was = before.label(k, side_was);
+
+        /// outlines change with every node under them (that of thread 0
+        /// is white, though)
+        const uint16_t flags = now.flags | was.flags;
+        const bool outlined = (flags & PlacedNode::HIGHLIGHTED) ||
+            ((flags & PlacedNode::NEW_THREAD) && (now.tid != 0 || was.tid != 0));
+
+        const bool same_node = !outlined &&
+            ownHash(now, label_now) == ownHash(was, label_was) &&
+            (label_now == nullptr || side_now == side_was);
+
+        std::vector<int> kids_now, kids_was;
+        for (int j = i + 1; j < now.end; j = m_nodes[j].end) kids_now.push_back(j);
+        for (int j = k + 1; j < was.end; j = before[j].end) kids_was.push_back(j);
+
+        bool same_kids = kids_now.size() == kids_was.size();
+        for (size_t c = 0; same_kids && c < kids_now.size(); ++c) {
+            same_kids = m_nodes[kids_now[c]].gid == before[kids_was[c]].gid;
+        }
+
+        if (!same_node) {
+            areas.push_back(subtreeArea(now));
+            areas.push_back(subtreeArea(was));
+        } else if (!same_kids) {
+            for (int j : kids_now) areas.push_back(subtreeArea(m_nodes[j]));
+            for (int j : kids_was) areas.push_back(subtreeArea(before[j]));
+        } else {
+            for (size_t c = 0; c < kids_now.size(); ++c) {
+                stack.emplace_back(kids_now[c], kids_was[c]);
+            }
+        }
+    }
+
+    /// too many to test against one by one
+    if (areas.size() > MAX_CHANGED_AREAS) {
+        QRect all;
+        for (const auto& area : areas) all |= area;
+        areas.assign(1, all);
+    }
+
+    return areas;
+}
+
+namespace layoutgeneration {
+
+    /// Walks the tree the way `DrawingCursor` does (without clipping)
+    /// and records where it would draw every node
+    class PlacementCursor : public NodeCursor {
+        int x = 0;
+        int y = 0;
+    public:
+        std::vector<PlacedNode> placed;
+
+        PlacementCursor(VisualNode* root, const NodeAllocator& na)
+            : NodeCursor(root, na) {}
+
+        bool mayMoveDownwards() {
+            return NodeCursor::mayMoveDownwards() && !node()->isHidden() &&
+                   node()->childrenLayoutIsDone();
+        }
+        void moveDownwards() {
+            NodeCursor::moveDownwards();
+            x += node()->getOffset();
+            y += Layout::dist_y;
+        }
+        void moveUpwards() {
+            x -= node()->getOffset();
+            y -= Layout::dist_y;
+            NodeCursor::moveUpwards();
+        }
+        void moveSidewards() {
+            x -= node()->getOffset();
+            NodeCursor::moveSidewards();
+            x += node()->getOffset();
+        }
+        void processCurrentNode() {
+            PlacedNode p;
+            p.gid = node()->getIndex(na);
+            p.x = x;
+            p.y = y;
+            placed.push_back(p);
+        }
+    };
+
+    /// The generation must list the nodes `DrawingCursor` draws, in the
+    /// same order and at the same places, with subtrees ending where the
+    /// next node at the same depth or above starts
+    static bool matchesDrawing(NodeTree& nt) {
+
+        auto& na = nt.getNA();
+        auto* root = nt.getRoot();
+
+        perfHelper.begin("layout generation: 1M nodes");
+        const auto gen = LayoutGeneration::build(root, na, 1);
+        perfHelper.end();
+
+        PreorderNodeVisitor<PlacementCursor> visitor(PlacementCursor(root, na));
+        visitor.run();
+
+        const auto& expected = visitor.getCursor().placed;
+        if (gen->size() != expected.size()) return false;
+
+        for (int i = 0; i < static_cast<int>(expected.size()); ++i) {
+            const PlacedNode& p = (*gen)[i];
+            if (p.gid != expected[i].gid || p.x != expected[i].x ||
+                p.y != expected[i].y) return false;
+
+            if (p.end <= i || p.end > static_cast<int>(gen->size())) return false;
+            if (p.end < static_cast<int>(gen->size()) && (*gen)[p.end].y > p.y) return false;
+            for (int j = i + 1; j < p.end; j = (*gen)[j].end) {
+                if ((*gen)[j].y != p.y + Layout::dist_y) return false;
+                if ((*gen)[j].parent_x != p.x) return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Visit `gen` without clipping: every node must be passed exactly
+    /// once, on its own or within a subtree passed as a whole
+    static bool coversOnce(const LayoutGeneration& gen, int min_width, int& calls) {
+
+        int covered = 0;
+        int next = 0;
+        bool in_order = true;
+        calls = 0;
+
+        gen.visit(QRect(), min_width, [&](int i, bool whole) {
+            if (i != next) in_order = false;
+            const int count = whole ? gen[i].end - i : 1;
+            covered += count;
+            next = i + count;
+            ++calls;
+        });
+
+        return in_order && covered == static_cast<int>(gen.size());
+    }
+
+    /// Zoomed out, subtrees are passed as a whole: once the tree fits on
+    /// the screen, the number of calls must depend on how many glyphs fit
+    /// across it (a few per glyph column), not on the number of nodes
+    static bool drawsPerPixel(NodeTree& nt) {
+
+        const auto gen = LayoutGeneration::build(nt.getRoot(), nt.getNA(), 1);
+        const BoundingBox bb = gen->boundingBox();
+
+        int all;
+        if (!coversOnce(*gen, 0, all) || all != static_cast<int>(gen->size())) return false;
+
+        /// e.g. 4 pixel glyphs across a 4000 pixel wide screen
+        constexpr int COLUMNS = 1000;
+
+        int calls;
+        perfHelper.begin("layout generation: visit 1M nodes 1000 glyphs wide");
+        const bool covered = coversOnce(*gen, (bb.right - bb.left) / COLUMNS, calls);
+        perfHelper.end();
+
+        return covered && calls <= 10 * COLUMNS;
+    }
+
+    /// Hiding a subtree must be found as a change covering it, and the
+    /// nodes outside of the changed areas must be drawn as before
+    static bool changesFound(NodeTree& nt) {
+
+        auto& na = nt.getNA();
+        auto* root = nt.getRoot();
+
+        const auto before = LayoutGeneration::build(root, na, 1);
+        if (!LayoutGeneration::build(root, na, 2)->changedAreas(*before).empty()) return false;
+
+        int hidden = static_cast<int>(before->size()) / 2;
+        while ((*before)[hidden].end == hidden + 1) ++hidden;
+        const PlacedNode& was = (*before)[hidden];
+
+        na[was.gid]->toggleHidden(na);
+        root->layout(na);
+        const auto after = LayoutGeneration::build(root, na, 3);
+
+        perfHelper.begin("layout generation: changed areas");
+        const auto areas = after->changedAreas(*before);
+        perfHelper.end();
+
+        auto changed = [&areas](const PlacedNode& n) {
+            for (const auto& area : areas) {
+                if (area.contains(n.x, n.y)) return true;
+            }
+            return false;
+        };
+
+        if (areas.empty() || !changed(was)) return false;
+
+        std::vector<int> index(na.size(), -1);
+        for (int i = 0; i < static_cast<int>(before->size()); ++i) index[(*before)[i].gid] = i;
+
+        for (const auto& n : after->nodes()) {
+            if (changed(n)) continue;
+            const int i = index[n.gid];
+            if (i == -1 || (*before)[i].x != n.x || (*before)[i].y != n.y ||
+                (*before)[i].flags != n.flags) return false;
+        }
+
+        return true;
+    }
+
+    /// Clicking anywhere must find the node `VisualNode::findNode` finds.
+    /// It may find more: the shapes `findNode` descends through can be a
+    /// unit narrower than the nodes under them, so it misses the odd click
+    /// on the edge of a node. The nodes in a rectangle must include every
+    /// node found in it.
+    static bool hitsMatch(NodeTree& nt) {
+
+        constexpr int POINTS = 200000;
+
+        auto& na = nt.getNA();
+        auto* root = nt.getRoot();
+
+        const auto gen = LayoutGeneration::build(root, na, 1);
+        const BoundingBox bb = gen->boundingBox();
+        const int height = (gen->depth() + 1) * Layout::dist_y;
+
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> any_x(bb.left - 10, bb.right + 10);
+        std::uniform_int_distribution<int> any_y(0, height);
+
+        std::vector<std::pair<int, int>> points;
+        for (int i = 0; i < POINTS; ++i) points.emplace_back(any_x(rng), any_y(rng));
+
+        std::vector<int> indexed(POINTS);
+        std::vector<VisualNode*> walked(POINTS);
+
+        perfHelper.begin("layout generation: 200K clicks (index)");
+        for (int i = 0; i < POINTS; ++i) indexed[i] = gen->nodeAt(points[i].first, points[i].second);
+        perfHelper.end();
+
+        perfHelper.begin("layout generation: 200K clicks (findNode)");
+        for (int i = 0; i < POINTS; ++i) walked[i] = root->findNode(na, points[i].first, points[i].second);
+        perfHelper.end();
+
+        int hits = 0;
+        int edges = 0;
+        for (int i = 0; i < POINTS; ++i) {
+            const VisualNode* found = indexed[i] == -1 ? nullptr : na[(*gen)[indexed[i]].gid];
+            if (walked[i] != nullptr) ++hits;
+            if (found == walked[i]) continue;
+            if (walked[i] != nullptr) return false;
+            ++edges;
+        }
+        if (hits == 0 || edges > hits / 10) return false;
+
+        if (gen->nodesIn(QRect(bb.left, 0, bb.right - bb.left + 1, height)).size() != gen->size()) {
+            return false;
+        }
+
+        for (int r = 0; r < 100; ++r) {
+            const QRect rect(any_x(rng), any_y(rng), 2000, 300);
+            const auto inside = gen->nodesIn(rect);
+            for (int i = 0; i < 100; ++i) {
+                const int x = rect.x() + static_cast<int>(rng() % rect.width());
+                const int y = rect.y() + static_cast<int>(rng() % rect.height());
+                const int hit = gen->nodeAt(x, y);
+                if (hit != -1 && !std::binary_search(inside.begin(), inside.end(), hit)) return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Same nodes, labels, outlines and hit-testing
+    static bool sameGeneration(const LayoutGeneration& a, const LayoutGeneration& b) {
+
+        if (a.size() != b.size() || a.depth() != b.depth()) return false;
+        if (a.labelReach() != b.labelReach()) return false;
+
+        for (int i = 0; i < static_cast<int>(a.size()); ++i) {
+            const PlacedNode& n = a[i];
+            const PlacedNode& m = b[i];
+            if (n.gid != m.gid || n.x != m.x || n.y != m.y || n.parent_x != m.parent_x ||
+                n.end != m.end || n.left != m.left || n.right != m.right ||
+                n.bottom != m.bottom || n.flags != m.flags || n.status != m.status ||
+                n.tid != m.tid || n.subtree_size != m.subtree_size || n.hash != m.hash) {
+                return false;
+            }
+
+            PlacedNode::LabelSide side_a, side_b;
+            const QString* label_a = a.label(i, side_a);
+            const QString* label_b = b.label(i, side_b);
+            if ((label_a == nullptr) != (label_b == nullptr)) return false;
+            if (label_a && (*label_a != *label_b || side_a != side_b)) return false;
+
+            const auto* outline_a = a.outline(i);
+            const auto* outline_b = b.outline(i);
+            if ((outline_a == nullptr) != (outline_b == nullptr)) return false;
+            if (outline_a && outline_a->size() != outline_b->size()) return false;
+        }
+
+        const BoundingBox bb = a.boundingBox();
+        const int height = (a.depth() + 1) * Layout::dist_y;
+
+        std::mt19937 rng(13);
+        std::uniform_int_distribution<int> any_x(bb.left - 10, bb.right + 10);
+        std::uniform_int_distribution<int> any_y(0, height);
+
+        for (int i = 0; i < 100000; ++i) {
+            const int x = any_x(rng);
+            const int y = any_y(rng);
+            if (a.nodeAt(x, y) != b.nodeAt(x, y)) return false;
+        }
+
+        const QRect all(bb.left, 0, bb.right - bb.left + 1, height);
+        return a.nodesIn(all) == b.nodesIn(all);
+    }
+
+    /// A generation built from the previous one and the nodes laid out
+    /// since must be the one built from scratch, and only those nodes
+    /// may be copied from the tree
+    static bool draftMatches(NodeTree& nt) {
+
+        auto& na = nt.getNA();
+        auto* root = nt.getRoot();
+
+        auto previous = LayoutGeneration::build(root, na, 1);
+
+        std::mt19937 rng(11);
+
+        for (int round = 0; round < 5; ++round) {
+
+            std::uniform_int_distribution<int> any_gid(1, na.size() - 1);
+
+            for (int i = 0; i < 20; ++i) na[any_gid(rng)]->toggleHidden(na);
+
+            for (int i = 0; i < 20; ++i) {
+                VisualNode* n = na[any_gid(rng)];
+                if (n->getNumberOfChildren() > 0) continue;
+                utils::addChildren(n, nt, 2);
+                n->setStatus(BRANCH);
+            }
+
+            for (int i = 0; i < 5; ++i) {
+                VisualNode* n = na[any_gid(rng)];
+                na.setLabel(n, QString("x = ") + QString::number(i));
+                n->dirtyUp(na);
+            }
+
+            for (int i = 0; i < 5; ++i) {
+                VisualNode* n = na[any_gid(rng)];
+                n->setHighlighted(!n->isHighlighted());
+                n->dirtyUp(na);
+            }
+
+            const auto dirty = LayoutDraft::dirtyNodes(root, na);
+            root->layout(na);
+
+            perfHelper.begin("layout generation: draft (under the lock)");
+            LayoutDraft draft(root, na, previous, dirty);
+            perfHelper.end();
+
+            perfHelper.begin("layout generation: build from the draft");
+            const auto gen = LayoutGeneration::build(draft, round + 2);
+            perfHelper.end();
+
+            if (draft.copied() * 10 > gen->size()) return false;
+
+            if (!sameGeneration(*gen, *LayoutGeneration::build(root, na, round + 2))) return false;
+            if (gen->changedAreas(*previous).empty()) return false;
+
+            previous = gen;
+        }
+
+        return true;
+    }
+
+    void test_module() {
+
+        NodeTree nt;
+        utils::buildRandomTree(nt, 1000000, 3);
+
+        auto& na = nt.getNA();
+        nt.getRoot()->layout(na);
+
+        bool passed = matchesDrawing(nt);
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> any_gid(1, na.size() - 1);
+
+        for (int i = 0; i < 100; ++i) {
+            na[any_gid(rng)]->toggleHidden(na);
+        }
+        nt.getRoot()->layout(na);
+
+        passed = passed && matchesDrawing(nt) && drawsPerPixel(nt) && hitsMatch(nt) &&
+                 changesFound(nt) && draftMatches(nt);
+
+        if (passed) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (layout generation differs from drawing)\n";
+        }
+    }
+}
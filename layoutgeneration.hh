@@ -0,0 +1,296 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef LAYOUTGENERATION_HH
+#define LAYOUTGENERATION_HH
+
+#include <QString>
+#include <QRect>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+
+#include "visualnode.hh"
+
+namespace layoutgeneration { void test_module(); }
+
+/// A node as the layout placed it, with everything needed to draw it
+struct PlacedNode {
+
+    /// Copies of the `VisualNode` flags (and child states) used for drawing.
+    /// The `INTERACTIVE` ones are as they were when the node was last
+    /// copied from the tree: a subtree that did not change since the
+    /// previous generation is copied from that one (see `LayoutDraft`)
+    enum Flags : uint16_t {
+        HIDDEN          = 1 << 0,
+        MARKED          = 1 << 1,
+        ONPATH          = 1 << 2,
+        HIGHLIGHTED     = 1 << 3,
+        BOOKMARKED      = 1 << 4,
+        SELECTED        = 1 << 5,
+        HOVERED         = 1 << 6,
+        INVISIBLE       = 1 << 7,
+        LAYOUT_DONE     = 1 << 8,
+        OPEN_CHILDREN   = 1 << 9,
+        SOLVED_CHILDREN = 1 << 10,
+        FAILED_CHILDREN = 1 << 11,
+        /// drawn in the colour of its thread (see `Node::_tid`)
+        NEW_THREAD      = 1 << 12,
+        /// flags the user changes without the tree being laid out again
+        INTERACTIVE = MARKED | ONPATH | HIGHLIGHTED | BOOKMARKED |
+                      SELECTED | HOVERED
+    };
+
+    /// Where a label goes relative to its node
+    enum LabelSide : uint8_t { LABEL_LEFT, LABEL_CENTER, LABEL_RIGHT };
+
+    int gid;
+    /// Absolute position of the top of the node
+    int x;
+    int y;
+    /// Where the edge from the parent starts
+    int parent_x;
+    /// One past the last node of the subtree (in preorder)
+    int end;
+    /// Absolute bounds of the subtree's shape: the subtree is drawn
+    /// within [left, right] and above `bottom`
+    int left;
+    int right;
+    int bottom;
+    uint16_t flags;
+    /// `NodeStatus`
+    char status;
+    char tid;
+    /// `VisualNode::getSubtreeSize`
+    int8_t subtree_size;
+    /// Of the subtree as drawn relative to the edge from its parent
+    /// (places, states and labels, but not the `INTERACTIVE` flags):
+    /// subtrees with equal hashes look the same
+    uint64_t hash;
+
+    /// Flags of `n` as they are now (the caller holds the tree mutex)
+    static uint16_t flagsOf(VisualNode& n);
+};
+
+class LayoutGeneration;
+
+/// The first half of building a `LayoutGeneration`, done while the tree
+/// is locked: the nodes laid out since the previous generation are
+/// copied from the tree, the subtrees that did not change are only
+/// referred to (by where they are in the previous generation). The
+/// second half, copying those, needs no locks (see `LayoutGeneration`).
+class LayoutDraft {
+    friend class LayoutGeneration;
+
+    /// A node copied from the tree, or (`reuse` != -1) the root of an
+    /// unchanged subtree, of which only the place is known
+    struct Piece {
+        PlacedNode node;
+        /// piece of the parent, -1 for the root
+        int parent;
+        /// index of the subtree in `previous`
+        int reuse;
+    };
+
+    std::vector<Piece> m_pieces;
+
+    /// Labels, outlines and spans (see `LayoutGeneration`) of the pieces
+    /// copied from the tree, by piece
+    struct Label {
+        int piece;
+        QString text;
+        PlacedNode::LabelSide side;
+    };
+    std::vector<Label> m_labels;
+    std::vector<std::pair<int, std::vector<Extent>>> m_outlines;
+    struct Span {
+        int row;
+        int left;
+        int right;
+        int piece;
+    };
+    std::vector<Span> m_spans;
+
+    std::shared_ptr<const LayoutGeneration> m_previous;
+    int m_depth = 0;
+
+public:
+
+    /// Copy the tree of `root`, which must be laid out (the caller holds
+    /// the tree and layout mutexes). If `previous` is given, it must have
+    /// been built from the same tree, which has been laid out once since,
+    /// and `dirty` must be the nodes that layout laid out (see
+    /// `dirtyNodes`): only those are copied. Otherwise the whole tree is.
+    LayoutDraft(VisualNode* root, const NodeAllocator& na,
+                std::shared_ptr<const LayoutGeneration> previous = nullptr,
+                const std::unordered_set<int>& dirty = {});
+
+    /// Nodes (gids) the next layout of the tree of `root` will lay out,
+    /// i.e. those that are dirty; to be taken right before it
+    static std::unordered_set<int> dirtyNodes(VisualNode* root, const NodeAllocator& na);
+
+    /// Nodes copied from the tree
+    size_t copied() const { return m_pieces.size(); }
+};
+
+/// The visible part of a laid out tree, flattened in preorder: one
+/// `PlacedNode` per node that would be drawn, i.e. the children of hidden
+/// nodes and of nodes whose children are not laid out yet are left out.
+/// Once built, a generation is never changed, so it can be drawn and
+/// searched by any thread without locking the tree while the tree grows
+/// and the next generation is laid out (see `LayoutWorker`).
+class LayoutGeneration {
+
+    std::vector<PlacedNode> m_nodes;
+
+    struct Label {
+        int index;
+        QString text;
+        PlacedNode::LabelSide side;
+        /// of the text as tiles draw it (tree coordinates)
+        int width;
+    };
+
+    /// by node index, only for the (few) nodes with labels
+    std::vector<Label> m_labels;
+    /// see `labelReach`
+    int m_label_reach = 0;
+    /// Shapes of highlighted nodes and of nodes drawn in the colour of
+    /// their thread, by node index
+    std::vector<std::pair<int, std::vector<Extent>>> m_outlines;
+
+    /// A stretch of a row taken by a node
+    struct Span {
+        int left;
+        int right;
+        int index;
+    };
+
+    /// By row: where the nodes in it can be clicked, from left to right
+    /// (hidden nodes take a span in every row their glyph reaches into)
+    ///
+    /// NOTE(maxim): rebuilt with every generation rather than patched in
+    /// place: a published generation may still be hit-tested by a canvas,
+    /// so the rows can't be shared with the next one. The spans of an
+    /// unchanged subtree are copied as runs along with its nodes (see
+    /// `copySubtree`), so this costs no more than the copy itself, which is
+    /// made outside of the tree lock and is rate-limited by `LayoutWorker`.
+    std::vector<std::vector<Span>> m_rows;
+
+    /// Shape depth of the whole tree
+    int m_depth = 0;
+
+    uint64_t m_number = 0;
+
+    /// Append the subtree at `k` of `from`, placed with its root at `x`
+    void copySubtree(const LayoutGeneration& from, int k, int x, int parent_x);
+
+public:
+
+    /// Flatten the tree as `draft` has it, taking the subtrees it
+    /// refers to from its previous generation; needs no locks. `number`
+    /// identifies the generation (see `number`)
+    static std::shared_ptr<const LayoutGeneration>
+    build(const LayoutDraft& draft, uint64_t number);
+
+    /// Flatten the tree of `root` in one go (the caller holds the tree
+    /// and layout mutexes all along)
+    static std::shared_ptr<const LayoutGeneration>
+    build(VisualNode* root, const NodeAllocator& na, uint64_t number);
+
+    const std::vector<PlacedNode>& nodes() const { return m_nodes; }
+    size_t size() const { return m_nodes.size(); }
+    bool empty() const { return m_nodes.empty(); }
+    const PlacedNode& operator[](int i) const { return m_nodes[i]; }
+
+    /// The label of node `i` (null if it has none) and where it goes
+    const QString* label(int i, PlacedNode::LabelSide& side) const;
+
+    /// How far (tree coordinates) the widest label reaches out from its
+    /// node, and so possibly out of the subtree of the node
+    int labelReach() const { return m_label_reach; }
+
+    /// The shape of node `i` if it is drawn (see `m_outlines`), nullptr otherwise
+    const std::vector<Extent>* outline(int i) const;
+
+    /// Horizontal bounds of the whole tree
+    BoundingBox boundingBox() const;
+    /// Number of levels of the whole tree
+    int depth() const { return m_depth; }
+
+    /// Increases with every generation published for a tree
+    uint64_t number() const { return m_number; }
+
+    /// The node drawn at (\a x, \a y), the way `VisualNode::findNode`
+    /// finds it, or -1; takes logarithmic time
+    int nodeAt(int x, int y) const;
+
+    /// The nodes drawn within \a rect (in preorder)
+    std::vector<int> nodesIn(const QRect& rect) const;
+
+    /// Where the picture may differ from that of \a before (the previous
+    /// generation of the same tree): the areas of the subtrees that were
+    /// added, removed, moved or changed, found by descending only into
+    /// subtrees whose hashes differ
+    std::vector<QRect> changedAreas(const LayoutGeneration& before) const;
+
+    /// Call `draw(i, whole)` for every node to be drawn within `clip`
+    /// (an empty rectangle means no clipping), in preorder. A subtree
+    /// narrower than `min_width` is passed as a whole (`whole` is set)
+    /// and not descended into, so the number of calls depends on how
+    /// much of the tree fits on the screen rather than on its size.
+    /// Nodes whose subtree is outside of `clip` are still passed (their
+    /// edges may not be), but not their descendants.
+    template <typename Draw>
+    void visit(const QRect& clip, int min_width, Draw&& draw) const;
+};
+
+template <typename Draw>
+void LayoutGeneration::visit(const QRect& clip, int min_width, Draw&& draw) const {
+
+    const bool clipping = !(clip.width() == 0 && clip.x() == 0 &&
+                            clip.height() == 0 && clip.y() == 0);
+
+    const int size = static_cast<int>(m_nodes.size());
+
+    for (int i = 0; i < size;) {
+        const PlacedNode& n = m_nodes[i];
+
+        if (n.right - n.left < min_width) {
+            draw(i, true);
+            i = n.end;
+            continue;
+        }
+
+        draw(i, false);
+
+        const bool clipped = clipping &&
+            (n.left > clip.x() + clip.width() || n.right < clip.x() ||
+             n.y > clip.y() + clip.height() || n.bottom < clip.y());
+
+        i = clipped ? n.end : i + 1;
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#include "layoutworker.hh"
+#include "layoutgeneration.hh"
+#include "nodetree.hh"
+#include "visualnode.hh"
+
+#include <algorithm>
+#include <chrono>
+
+LayoutWorker::LayoutWorker(NodeTree& tree)
+    : m_tree(tree), m_published(std::make_shared<LayoutGeneration>()) {}
+
+LayoutWorker::~LayoutWorker() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopped = true;
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+void LayoutWorker::request(bool hide_failed) {
+    QMutexLocker locker(&m_mutex);
+    m_requested = true;
+    m_hide_failed = m_hide_failed || hide_failed;
+    m_wake.wakeOne();
+}
+
+std::shared_ptr<const LayoutGeneration> LayoutWorker::latest() const {
+    QMutexLocker locker(&m_mutex);
+    return m_published;
+}
+
+void LayoutWorker::run() {
+
+    using clock = std::chrono::steady_clock;
+
+    /// when the previous generation may be followed by the next one
+    clock::time_point next_start = clock::now();
+    /// `NodeAllocator::layoutCount` after the previous layout
+    uint64_t layouts = 0;
+
+    while (true) {
+
+        bool hide_failed;
+        uint64_t number;
+        std::shared_ptr<const LayoutGeneration> previous;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_requested && !m_stopped) m_wake.wait(&m_mutex);
+
+            /// requests made meanwhile are coalesced into this one
+            while (!m_stopped && clock::now() < next_start) {
+                const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_start - clock::now()).count();
+                m_wake.wait(&m_mutex, static_cast<unsigned long>(ms) + 1);
+            }
+            if (m_stopped) return;
+
+            hide_failed = m_hide_failed;
+            m_requested = false;
+            m_hide_failed = false;
+            number = ++m_generations;
+            previous = m_published;
+        }
+
+        const auto started = clock::now();
+
+        std::unique_ptr<LayoutDraft> draft;
+
+        {
+            QMutexLocker tree_locker(&m_tree.getTreeMutex());
+            QMutexLocker layout_locker(&m_tree.getLayoutMutex());
+
+            const auto& na = m_tree.getNA();
+            VisualNode* root = m_tree.getRoot();
+            if (root == nullptr) continue;
+
+            if (hide_failed) root->hideFailed(na, true);
+
+            /// somebody else's layout would have hidden what it changed
+            if (na.layoutCount() != layouts) previous = nullptr;
+
+            const auto dirty = LayoutDraft::dirtyNodes(root, na);
+            root->layout(na);
+            layouts = na.layoutCount();
+
+            draft.reset(new LayoutDraft(root, na, std::move(previous), dirty));
+        }
+
+        auto generation = LayoutGeneration::build(*draft, number);
+        draft.reset();
+
+        const auto took = clock::now() - started;
+        next_start = started + std::max<clock::duration>(took, std::chrono::milliseconds(MIN_INTERVAL_MS));
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_published = std::move(generation);
+        }
+
+        emit published();
+    }
+}
@@ -0,0 +1,86 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef LAYOUTWORKER_HH
+#define LAYOUTWORKER_HH
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include <cstdint>
+
+class NodeTree;
+class LayoutGeneration;
+
+/// Lays out the tree shown by a `TreeCanvas` on a thread of its own.
+/// Requests are coalesced: whatever was requested while a layout was
+/// running is done by one layout afterwards. Every layout is followed by
+/// a new `LayoutGeneration`, which replaces the published one as a whole,
+/// so the canvas always draws a complete layout and never has to wait
+/// for the tree, which the builder keeps changing meanwhile.
+/// The tree is only locked for the layout and for copying what it changed
+/// (see `LayoutDraft`); the rest of the generation is copied from the
+/// previous one after the tree is unlocked.
+class LayoutWorker : public QThread {
+Q_OBJECT
+
+    /// A generation starts no sooner than this after the previous one
+    /// started (or than the previous one took, if longer): while the
+    /// builder keeps requesting layouts, they take a fraction of a core
+    static constexpr int MIN_INTERVAL_MS = 40;
+
+    NodeTree& m_tree;
+
+    /// Guards everything below
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+
+    bool m_requested = false;
+    bool m_hide_failed = false;
+    bool m_stopped = false;
+
+    std::shared_ptr<const LayoutGeneration> m_published;
+    uint64_t m_generations = 0;
+
+protected:
+    void run() override;
+
+public:
+    explicit LayoutWorker(NodeTree& tree);
+    /// Waits for the layout in progress (if any) and stops the thread
+    ~LayoutWorker();
+
+    /// Lay the tree out as soon as possible, hiding failed subtrees of
+    /// its dirty part first if \a hide_failed is set
+    void request(bool hide_failed);
+
+    /// The last generation published (empty before the first layout)
+    std::shared_ptr<const LayoutGeneration> latest() const;
+
+Q_SIGNALS:
+    /// A new generation was published (emitted by the worker thread)
+    void published();
+};
+
+#endif
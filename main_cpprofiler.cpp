@@ -72,5 +72,11 @@ int main(int argc, char *argv[]) {
     conductor.loadExecution(file_name.toStdString());
   }
 
+  if (GlobalParser::isSet(GlobalParser::replay_option)) {
+    auto file_name = GlobalParser::value(GlobalParser::replay_option);
+    qDebug() << "replaying: " << file_name;
+    conductor.replayCapture(file_name, GlobalParser::isSet(GlobalParser::replay_paced));
+  }
+
   return a.exec();
 }
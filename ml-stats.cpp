@@ -1,10 +1,12 @@
 #include "ml-stats.hh"
-#include "nodecursor.hh"
-#include "nodevisitor.hh"
 #include "data.hh"
+#include "nodetree.hh"
+#include "treesnapshot.hh"
 
 #include <unordered_map>
 #include <set>
+#include <vector>
+#include <algorithm>
 
 // **************************************************
 // StatsEntry
@@ -35,7 +37,8 @@ public:
     int backjumpDistance;
     int backjumpDestination;
     unsigned long long timestamp;
-    string solutionString;
+    /// the node's info, owned by the execution's Data (nullptr if none)
+    const string* solution = nullptr;
 };
 
 #define INCLUDE_NOGOOD_STRING 1
@@ -107,182 +110,143 @@ void printStatsEntry(const StatsEntry& se, std::ostream& out = std::cout) {
         << "," << se.backjumpDistance
         << "," << se.backjumpDestination
         << "," << se.timestamp
-        << "," << csvquote(se.solutionString)
+        << "," << csvquote(se.solution ? *se.solution : string())
         << "\n";
 }
 
 // **************************************************
-// StatsCursor
+// StatsEntry construction
 // **************************************************
 
-class StatsCursor : public NodeCursor {
-private:
-    Execution* execution;
-    int depth;
-    std::vector<StatsEntry> stack;
-    std::ostream& out;
-public:
-    StatsCursor(VisualNode* root, const NodeAllocator& na, Execution* execution_,
-                std::ostream& out_)
-        : NodeCursor(root, na)
-        , execution(execution_)
-        , depth(0)
-        , out(out_)
-    {
-        printStatsHeader(out);
-        enter();
-    }
-
-    string getSolutionString(NodeUID uid) {
-        auto maybe_info = execution->getInfo(uid);
-        if (maybe_info != nullptr) {
-            return *maybe_info;
-        } else {
-            return "";
+static int calculateNogoodLength(const string& nogood) {
+    int count = 0;
+    for (unsigned int i = 0 ; i < nogood.size() ; i++) {
+        if (nogood[i] == ' ') {
+            count++;
         }
     }
+    return count;
+}
 
-    int calculateNogoodLength(string nogood) {
-        int count = 0;
-        for (unsigned int i = 0 ; i < nogood.size() ; i++) {
-            if (nogood[i] == ' ') {
-                count++;
+static int calculateNogoodNumberVariables(const string& nogood) {
+    std::set<string> variables;
+    int start = 0;
+    while (true) {
+        size_t space = nogood.find(' ', start);
+        string literalSubstring = nogood.substr(start, space - start);
+        if (literalSubstring.size() > 0) {
+            size_t punctuation = literalSubstring.find_first_of("<>=!");
+            if (punctuation != string::npos) {
+                string variableSubstring = literalSubstring.substr(0, punctuation);
+                variables.insert(variableSubstring);
             }
         }
-        return count;
+        if (space == string::npos)
+            break;
+        start = space+1;
     }
+    return variables.size();
+}
 
-    int calculateNogoodNumberVariables(string nogood) {
-        std::set<string> variables;
-        int start = 0;
-        while (true) {
-            size_t space = nogood.find(' ', start);
-            string literalSubstring = nogood.substr(start, space - start);
-            if (literalSubstring.size() > 0) {
-                size_t punctuation = literalSubstring.find_first_of("<>=!");
-                if (punctuation != string::npos) {
-                    string variableSubstring = literalSubstring.substr(0, punctuation);
-                    variables.insert(variableSubstring);
-                }
-            }
-            if (space == string::npos)
-                break;
-            start = space+1;
-        }
-        return variables.size();
+// Fill in everything that does not depend on the node's subtree.
+static void fillEntry(StatsEntry& se, Execution* execution, int gid) {
+    // Some nodes (e.g. undetermined nodes) do not have entries;
+    // be careful with those.
+    se.gid = gid;
+    DbEntry entry = execution->getEntry(gid);
+    if (entry) {
+        auto nid = entry.nodeUID().nid;
+        se.nodeid = nid;
+        se.parentid = entry.parentUID().nid;
+        se.alternative = entry.alt();
+        // se.restartNumber = entry->restart_id;
+        se.nogoodString = execution->getNogoodByUID(entry.nodeUID(), true, false);
+        se.nogoodStringLength = se.nogoodString.length();
+        se.nogoodLength = calculateNogoodLength(se.nogoodString);
+        se.nogoodNumberVariables = calculateNogoodNumberVariables(se.nogoodString);
+        // se.nogoodBLD = entry->nogood_bld;
+        // se.usesAssumptions = entry->usesAssumptions;
+        // se.backjumpDistance = entry->backjump_distance;
+        // se.decisionLevel = entry->decision_level;
+        se.label = entry.label();
+        se.timestamp = entry.timeStamp();
+        se.solution = execution->getInfo(entry.nodeUID());
+
+        se.backjumpDestination = se.decisionLevel - se.backjumpDistance;
+    } else {
+        se.nodeid = -1;
+        se.parentid = -1;
+        se.alternative = -1;
+        // se.restartNumber = -1;
+        se.nogoodStringLength = 0;
+        se.nogoodString = "";
+        se.nogoodLength = 0;
+        se.nogoodNumberVariables = 0;
+        se.label = "";
+        se.decisionLevel = -1;
+        se.timestamp = 0;
+        se.solution = nullptr;
+        se.backjumpDestination = -1;
+        se.backjumpDistance = -1;
     }
+}
 
-    // What to do when we see a node for the first time: create a
-    // StatsEntry for it and add it to the stack.
-    void enter() {
-        StatsEntry se;
-        se.depth = depth;
-        se.subtreeDepth = 1;
-        se.status = node()->getStatus();
-        switch (se.status) {
-        case SKIPPED:
-        case UNDETERMINED:
-            se.subtreeSize = 0;
-            break;
-        default:
-            se.subtreeSize = 1;
-            break;
-        }
-        se.subtreeSolutions = se.status == SOLVED ? 1 : 0;
-        int gid = node()->getIndex(na);
-        // Some nodes (e.g. undetermined nodes) do not have entries;
-        // be careful with those.
-        se.gid = gid;
-        DbEntry* entry = execution->getEntry(gid);
-        if (entry != nullptr) {
-            auto nid = entry->nodeUID.nid;
-            se.nodeid = nid;
-            se.parentid = entry->parentUID.nid;
-            se.alternative = entry->alt;
-            // se.restartNumber = entry->restart_id;
-            se.nogoodStringLength = execution->getNogoodByUID(entry->nodeUID, true, false).length();
-            se.nogoodString = execution->getNogoodByUID(entry->nodeUID, true, false);
-            se.nogoodLength = calculateNogoodLength(se.nogoodString);
-            se.nogoodNumberVariables = calculateNogoodNumberVariables(se.nogoodString);
-            // se.nogoodBLD = entry->nogood_bld;
-            // se.usesAssumptions = entry->usesAssumptions;
-            // se.backjumpDistance = entry->backjump_distance;
-            // se.decisionLevel = entry->decision_level;
-            se.label = entry->label;
-            se.timestamp = entry->time_stamp;
-            se.solutionString = getSolutionString(entry->nodeUID);
-
-            se.backjumpDestination = se.decisionLevel - se.backjumpDistance;
-        } else {
-            se.nodeid = -1;
-            se.parentid = -1;
-            se.alternative = -1;
-            // se.restartNumber = -1;
-            se.nogoodStringLength = 0;
-            se.nogoodString = "";
-            se.nogoodLength = 0;
-            se.nogoodNumberVariables = 0;
-            se.label = "";
-            se.decisionLevel = -1;
-            se.timestamp = 0;
-            se.solutionString = "";
-            se.backjumpDestination = -1;
-            se.backjumpDistance = -1;
-        }
+// **************************************************
+// Module interface
+// **************************************************
 
-        stack.push_back(se);
-    }
+// Collect the machine-learning statistics for a (sub)tree.  The first
+// argument are the root of the subtree and the node-allocator for the
+// tree.  The third argument is the execution the subtree comes from,
+// which is used to find the solver node id and branching/no-good
+// information.  The tree is read through its (preorder) snapshot:
+// subtree sizes, depths and solution counts are summed up in one
+// backwards scan, then the entries are printed in postorder.
+void collectMLStats(VisualNode* root, const NodeAllocator& na, Execution* execution, std::ostream& out) {
 
+    const auto snapshot = execution->nodeTree().snapshot();
+    const auto& s = *snapshot;
 
-    void moveDownwards() {
-        NodeCursor::moveDownwards();
-        depth++;
+    const int r = s.preorder(root->getIndex(na));
+    const int n = s.subtreeSize(r);
 
-        enter();
-    }
+    /// indexed by `i - r`
+    std::vector<int> subtreeSize(n);
+    std::vector<int> subtreeDepth(n, 1);
+    std::vector<int> subtreeSolutions(n);
 
-    // What to do when we see a node for the second (last) time: pop
-    // its StatsEntry from the stack and update its parent's subtree
-    // information.  This means that a node's subtree information is
-    // correct when its last child is done.
-    void processCurrentNode() {
-        StatsEntry se = stack.back();
-        stack.pop_back();
-        // Undetermined nodes are not real nodes (the solver never
-        // visited them), so we don't do anything with those.
-        // Also let's ignore the "super root".
-        if (se.status != UNDETERMINED && se.depth >= 1) {
-            printStatsEntry(se, out);
-            if (stack.size() > 0) {
-                stack.back().subtreeDepth = std::max(stack.back().subtreeDepth, 1 + se.subtreeDepth);
-                stack.back().subtreeSize += se.subtreeSize;
-                stack.back().subtreeSolutions += se.subtreeSolutions;
-            }
-        }
+    for (int i = r; i < r + n; ++i) {
+        const auto status = s.status(i);
+        subtreeSize[i - r] = (status == SKIPPED || status == UNDETERMINED) ? 0 : 1;
+        subtreeSolutions[i - r] = status == SOLVED ? 1 : 0;
     }
 
-    void moveUpwards() {
-        NodeCursor::moveUpwards();
-        depth--;
+    // Children come after their parents in preorder, so scanning
+    // backwards completes every subtree before its parent is reached.
+    // Undetermined nodes are not real nodes (the solver never
+    // visited them), so we don't do anything with those.
+    for (int i = r + n - 1; i > r; --i) {
+        if (s.status(i) == UNDETERMINED) continue;
+        const int p = s.parent(i) - r;
+        subtreeDepth[p] = std::max(subtreeDepth[p], 1 + subtreeDepth[i - r]);
+        subtreeSize[p] += subtreeSize[i - r];
+        subtreeSolutions[p] += subtreeSolutions[i - r];
     }
 
-    void moveSidewards() {
-        NodeCursor::moveSidewards();
-        enter();
-    }
-};
+    printStatsHeader(out);
 
-// **************************************************
-// Module interface
-// **************************************************
+    s.forEachPostorder(r, [&](int i) {
+        // Also let's ignore the "super root".
+        if (i == r || s.status(i) == UNDETERMINED) return;
 
-// Collect the machine-learning statistics for a (sub)tree.  The first
-// argument are the root of the subtree and the node-allocator for the
-// tree, as are the usual arguments to a NodeCursor.  The third
-// argument is the execution the subtree comes from, which is used to
-// find the solver node id and branching/no-good information.
-void collectMLStats(VisualNode* root, const NodeAllocator& na, Execution* execution, std::ostream& out) {
-    StatsCursor c(root, na, execution, out);
-    PostorderNodeVisitor<StatsCursor> v(c);
-    v.run();
+        StatsEntry se;
+        se.depth = s.depth(i) - s.depth(r);
+        se.status = s.status(i);
+        se.subtreeDepth = subtreeDepth[i - r];
+        se.subtreeSize = subtreeSize[i - r];
+        se.subtreeSolutions = subtreeSolutions[i - r];
+        fillEntry(se, execution, s.gid(i));
+
+        printStatsEntry(se, out);
+    });
 }
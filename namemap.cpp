@@ -1,19 +1,14 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <limits>
+#include <cmath>
 
 #include "namemap.hh"
-#include "third-party/json.hpp"
 
 #include "cpprofiler/utils/string_utils.hh"
 #include "cpprofiler/utils/path_utils.hh"
 
-#define reg_mzn_ident "[A-Za-z][A-Za-z0-9_]*"
-#define reg_number "[0-9]*"
-
-std::regex NameMap::var_name_regex(reg_mzn_ident);
-std::regex NameMap::assignment_regex(reg_mzn_ident "=" reg_number);
-
 using std::string;
 using std::vector;
 using std::unordered_set;
@@ -22,23 +17,6 @@ using utils::join;
 using utils::split;
 using utils::getPathHead;
 
-vector<int> getReasons(const string* maybe_info) {
-
-  if (maybe_info == nullptr) return {};
-
-  vector<int> reason_list;
-
-  auto info_json = nlohmann::json::parse(*maybe_info);
-  auto reasonIt = info_json.find("reasons");
-  if(reasonIt != info_json.end()) {
-    auto reasons = *reasonIt;
-    for(int con_id : reasons) {
-      reason_list.push_back(con_id);
-    }
-  }
-  return reason_list;
-}
-
 static const Location empty_location;
 bool Location::contains(const Location& loc) const {
   return ((sl  < loc.sl) || (sl == loc.sl && sc <= loc.sc)) &&
@@ -181,8 +159,6 @@ NameMap::SymbolRecord::SymbolRecord()
 NameMap::SymbolRecord::SymbolRecord(const std::string& nn, const std::string& p, const Location& l)
     : niceName(nn), path(p), location(l) {};
 
-NameMap::NameMap(const SymbolTable& st) : _nameMap(st) {}
-
 NameMap::NameMap(const std::string& path_filename, const std::string& model_filename) {
   vector<std::string> modelText;
   std::ifstream model_file(model_filename);
@@ -199,32 +175,39 @@ NameMap::NameMap(const std::string& path_filename, const std::string& model_file
     while(getline(pf, line)) {
       vector<string> s = utils::split(line, '\t');
       Location loc(getPathHead(s[2], false, false).back());
-      _nameMap[s[0]] = SymbolRecord(s[1], s[2], loc);
-      if(s[1].substr(0, 12) == "X_INTRODUCED")
+
+      const int32_t existing = _index.find(s[0]);
+      if(existing != -1) {
+        _symbols[existing] = SymbolRecord(s[1], s[2], loc);
+      } else {
+        _index.insert(s[0], static_cast<int32_t>(_symbols.size()));
+        _symbols.emplace_back(s[1], s[2], loc);
+      }
+
+      if(s[1].compare(0, 12, "X_INTRODUCED") == 0)
         addIdExpressionToMap(s[0], modelText);
     }
   }
 }
 
+const NameMap::SymbolRecord* NameMap::findSymbol(const char* ident, size_t length) const {
+  const int32_t id = _index.find(ident, length);
+  return id != -1 ? &_symbols[id] : nullptr;
+}
+
 static const string empty_string;
 const string& NameMap::getNiceName(const string& ident) const {
-  auto it = _nameMap.find(ident);
-  if(it != _nameMap.end()) {
-    return it->second.niceName;
-  }
-  return empty_string;
+  auto sym = findSymbol(ident);
+  return sym ? sym->niceName : empty_string;
 }
 
 bool NameMap::isEmpty() const {
-  return _nameMap.empty();
+  return _symbols.empty();
 }
 
 const string& NameMap::getPath(const string& ident) const {
-  auto it = _nameMap.find(ident);
-  if(it != _nameMap.end()) {
-    return it->second.path;
-  }
-  return empty_string;
+  auto sym = findSymbol(ident);
+  return sym ? sym->path : empty_string;
 }
 
 const Location& NameMap::getLocation(const int cid) const {
@@ -232,61 +215,91 @@ const Location& NameMap::getLocation(const int cid) const {
 }
 
 const Location& NameMap::getLocation(const string& ident) const {
-  auto it = _nameMap.find(ident);
-  if(it != _nameMap.end()) {
-    return it->second.location;
-  }
-  return empty_location;
+  auto sym = findSymbol(ident);
+  return sym ? sym->location : empty_location;
 }
 
 string NameMap::replaceNames(const string& text, bool expand_expressions) const {
-  if (_nameMap.size() == 0) return text;
-
-  std::stringstream ss;
-  size_t pos = 0;
-
-  auto var_names_begin = std::sregex_iterator(text.begin(), text.end(), var_name_regex);
-  auto var_names_end = std::sregex_iterator();
-
-  for(std::sregex_iterator i = var_names_begin; i != var_names_end; i++) {
-    std::smatch match = *i;
-    ss << text.substr(pos, static_cast<size_t>(match.position())-pos);
-    const string& id = match.str();
-    string name = getNiceName(id);
-
-    if(expand_expressions && name.substr(0, 12) == "X_INTRODUCED") {
-      auto eit = _expressionMap.find(name);
-      if(eit != _expressionMap.end()) {
-        std::stringstream ss;
-        ss << "\'" << eit->second << "\'";
-        name = ss.str();
-      } else {
-        name = id;
+  if (_symbols.empty()) return text;
+
+  string res;
+  res.reserve(text.size());
+
+  utils::scanIdentifiers(text,
+    [&res](const char* str, size_t len) { res.append(str, len); },
+    [&](const char* id, size_t len) {
+      auto sym = findSymbol(id, len);
+      if(sym == nullptr || sym->niceName.empty()) {
+        res.append(id, len);
+        return;
       }
-    }
-    ss << (name != "" ? name : id);
-    pos = static_cast<size_t>(match.position() + match.length());
-  }
 
-  ss << text.substr(pos, text.size());
-  return ss.str();
+      const string& name = sym->niceName;
+
+      if(expand_expressions && name.compare(0, 12, "X_INTRODUCED") == 0) {
+        /// NOTE(maxim): expressions are stored under the identifier
+        /// that is spelled like the nice name
+        auto introduced = findSymbol(name);
+        if(introduced && !introduced->expression.empty()) {
+          res.append(introduced->expression);
+        } else {
+          res.append(id, len);
+        }
+        return;
+      }
+
+      res.append(name);
+    });
+
+  return res;
 }
 
+/// Replace the identifiers of `expression` that are assigned a number
+/// in `path` (`ident=number`) by that number
 string NameMap::replaceAssignments(const string& path, const string& expression) const {
-  NameMap::SymbolTable st;
 
-  auto assignment_begin = std::sregex_iterator(path.begin(), path.end(), assignment_regex);
-  auto assignment_end = std::sregex_iterator();
+  /// usually a handful, a linear search is the fastest
+  std::vector<std::pair<string, string>> assigned;
 
-  for(std::sregex_iterator i = assignment_begin; i != assignment_end; i++) {
-      std::smatch match = *i;
-      const string& assign = match.str();
-      const vector<string> leftright = utils::split(assign, '=');
-      st[leftright[0]] = SymbolRecord(leftright[1], "", empty_location);
-  }
+  const char* const path_end = path.data() + path.size();
+
+  utils::scanIdentifiers(path,
+    [](const char*, size_t) {},
+    [&](const char* id, size_t len) {
+      const char* pos = id + len;
+      if(pos == path_end || *pos != '=') return;
+
+      const char* num = ++pos;
+      while(pos != path_end && *pos >= '0' && *pos <= '9') ++pos;
 
-  const NameMap nm(st);
-  return nm.replaceNames(expression);
+      string ident(id, len);
+      string value(num, static_cast<size_t>(pos - num));
+      for(auto& kv : assigned) {
+        if(kv.first == ident) {
+          kv.second = std::move(value);
+          return;
+        }
+      }
+      assigned.emplace_back(std::move(ident), std::move(value));
+    });
+
+  string res;
+  res.reserve(expression.size());
+
+  utils::scanIdentifiers(expression,
+    [&res](const char* str, size_t len) { res.append(str, len); },
+    [&](const char* id, size_t len) {
+      for(auto& kv : assigned) {
+        if(kv.first.size() == len && kv.first.compare(0, len, id, len) == 0 &&
+           !kv.second.empty()) {
+          res.append(kv.second);
+          return;
+        }
+      }
+      res.append(id, len);
+    });
+
+  return res;
 }
 
 void NameMap::addIdExpressionToMap(const string& ident, const vector<string>& modelText) {
@@ -300,7 +313,11 @@ void NameMap::addIdExpressionToMap(const string& ident, const vector<string>& mo
   const vector<string> components = getPathHead(getPath(ident), false, true);
   expression = replaceAssignments(utils::join(components, major_sep), expression);
 
-  _expressionMap.insert(make_pair(ident, expression));
+  /// quoted once here rather than on every use
+  auto& sym = _symbols[_index.find(ident)];
+  if(sym.expression.empty()) {
+    sym.expression = "\'" + expression + "\'";
+  }
 }
 
 
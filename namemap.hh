@@ -4,9 +4,9 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
-#include <regex>
 
 #include "cpprofiler/universal.hh"
+#include "cpprofiler/utils/symbol_index.hh"
 
 struct Location {
   //QString path = "";
@@ -48,24 +48,20 @@ private:
   std::unordered_set<Location> _loc_filters;
 };
 
-// This should go somewhere more sensible
-std::vector<int> getReasons(const std::string* maybe_info);
-
 class NameMap {
 private:
 struct SymbolRecord {
   std::string niceName;
   std::string path;
   Location location;
+  /// for X_INTRODUCED variables: the quoted model expression, if known
+  std::string expression;
 
   SymbolRecord();
   SymbolRecord(const std::string&, const std::string&, const Location&);
 };
 
 public:
-  using SymbolTable = std::unordered_map<std::string, SymbolRecord>;
-  using ExpressionTable = std::unordered_map<std::string, std::string>;
-
   NameMap() {}
   NameMap(const std::string& path_filename, const std::string& model_filename);
 
@@ -80,16 +76,20 @@ public:
   std::string getLocationFilterString(const std::vector<int>& reasons) const;
 
 private:
-  NameMap(const SymbolTable& st);
-
   std::string replaceAssignments(const std::string& path, const std::string& expression) const;
 
   void addIdExpressionToMap(const std::string& ident, const std::vector<std::string>& modelText);
 
-  static std::regex var_name_regex;
-  static std::regex assignment_regex;
-  SymbolTable _nameMap;
-  ExpressionTable _expressionMap;
+  /// nullptr if `ident` is not in the paths file
+  const SymbolRecord* findSymbol(const char* ident, size_t length) const;
+  const SymbolRecord* findSymbol(const std::string& ident) const {
+    return findSymbol(ident.data(), ident.size());
+  }
+
+  /// Read-only once the paths file has been read:
+  /// identifier -> index into `_symbols`
+  utils::SymbolIndex _index;
+  std::vector<SymbolRecord> _symbols;
 };
 
 #endif // NAMEMAP_HH
@@ -0,0 +1,299 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "nodebatch.hh"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "libs/perf_helper.hh"
+
+namespace nodebatch {
+
+/// the payload starts with the type and the node count
+static constexpr size_t HEADER_SIZE = 1 + sizeof(uint32_t);
+
+static uint32_t zigzag(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static bool sameThread(const NodeUID& a, const NodeUID& b) {
+  return a.rid == b.rid && a.tid == b.tid;
+}
+
+/// ********* ENCODER **********
+
+void Encoder::putVarint(uint32_t value) {
+  while (value >= 0x80) {
+    m_data.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  m_data.push_back(static_cast<char>(value));
+}
+
+void Encoder::putSigned(int32_t value) { putVarint(zigzag(value)); }
+
+void Encoder::putString(const std::string& str) {
+  putVarint(static_cast<uint32_t>(str.size()));
+  m_data.insert(m_data.end(), str.begin(), str.end());
+}
+
+void Encoder::add(const NodeRecord& rec) {
+
+  const NodeUID& uid = rec.nodeUID;
+  const NodeUID& p_uid = rec.parentUID;
+
+  uint8_t flags = 0;
+  if (!rec.label.empty()) flags |= HAS_LABEL;
+  if (!rec.nogood.empty()) flags |= HAS_NOGOOD;
+  if (!rec.info.empty()) flags |= HAS_INFO;
+  if (!sameThread(uid, m_prev)) flags |= NEW_THREAD;
+  if (!sameThread(p_uid, uid)) flags |= PARENT_THREAD;
+
+  m_data.push_back(static_cast<char>(flags));
+  m_data.push_back(rec.status);
+
+  /// NOTE(maxim): deltas wrap around on overflow, which decodes fine
+  putSigned(static_cast<int32_t>(static_cast<uint32_t>(uid.nid) -
+                                 static_cast<uint32_t>(m_prev.nid)));
+  if (flags & NEW_THREAD) {
+    putSigned(uid.rid);
+    putSigned(uid.tid);
+  }
+
+  putSigned(static_cast<int32_t>(static_cast<uint32_t>(p_uid.nid) -
+                                 static_cast<uint32_t>(uid.nid)));
+  if (flags & PARENT_THREAD) {
+    putSigned(p_uid.rid);
+    putSigned(p_uid.tid);
+  }
+
+  putSigned(rec.alt);
+  putVarint(static_cast<uint32_t>(rec.numberOfKids));
+
+  if (flags & HAS_LABEL) putString(rec.label);
+  if (flags & HAS_NOGOOD) putString(rec.nogood);
+  if (flags & HAS_INFO) putString(rec.info);
+
+  m_prev = uid;
+  ++m_count;
+}
+
+const std::vector<char>& Encoder::payload() {
+  std::memcpy(m_data.data() + 1, &m_count, sizeof(m_count));
+  return m_data;
+}
+
+void Encoder::clear() {
+  m_data.assign(HEADER_SIZE, 0);
+  m_data[0] = TYPE;
+  m_count = 0;
+  m_prev = NodeUID{0, 0, 0};
+}
+
+/// ********* DECODER **********
+
+Decoder::Decoder(const char* payload, size_t size)
+    : m_pos(payload), m_end(payload + size) {
+
+  if (size < HEADER_SIZE || payload[0] != TYPE) {
+    m_error = true;
+    return;
+  }
+
+  std::memcpy(&m_count, payload + 1, sizeof(m_count));
+  m_left = m_count;
+  m_pos += HEADER_SIZE;
+}
+
+bool Decoder::getVarint(uint32_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (m_pos == m_end) return false;
+    const uint8_t byte = static_cast<uint8_t>(*m_pos++);
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+bool Decoder::getSigned(int32_t& value) {
+  uint32_t raw;
+  if (!getVarint(raw)) return false;
+  value = unzigzag(raw);
+  return true;
+}
+
+bool Decoder::getString(std::string& str) {
+  uint32_t len;
+  if (!getVarint(len) || static_cast<size_t>(m_end - m_pos) < len) return false;
+  str.assign(m_pos, len);
+  m_pos += len;
+  return true;
+}
+
+bool Decoder::next(NodeRecord& rec) {
+
+  if (m_left == 0 || m_error) return false;
+
+  auto fail = [this]() {
+    m_error = true;
+    m_left = 0;
+    return false;
+  };
+
+  if (m_end - m_pos < 2) return fail();
+
+  const uint8_t flags = static_cast<uint8_t>(*m_pos++);
+  rec.status = *m_pos++;
+
+  NodeUID& uid = rec.nodeUID;
+  NodeUID& p_uid = rec.parentUID;
+
+  int32_t delta;
+  if (!getSigned(delta)) return fail();
+  uid.nid = static_cast<int32_t>(static_cast<uint32_t>(m_prev.nid) + static_cast<uint32_t>(delta));
+  uid.rid = m_prev.rid;
+  uid.tid = m_prev.tid;
+  if (flags & NEW_THREAD) {
+    if (!getSigned(uid.rid) || !getSigned(uid.tid)) return fail();
+  }
+
+  if (!getSigned(delta)) return fail();
+  p_uid.nid = static_cast<int32_t>(static_cast<uint32_t>(uid.nid) + static_cast<uint32_t>(delta));
+  p_uid.rid = uid.rid;
+  p_uid.tid = uid.tid;
+  if (flags & PARENT_THREAD) {
+    if (!getSigned(p_uid.rid) || !getSigned(p_uid.tid)) return fail();
+  }
+
+  uint32_t kids;
+  if (!getSigned(rec.alt) || !getVarint(kids)) return fail();
+  rec.numberOfKids = static_cast<int32_t>(kids);
+  rec.thread_id = uid.tid;
+
+  rec.label.clear();
+  rec.nogood.clear();
+  rec.info.clear();
+  rec.label_id = -1;
+
+  if ((flags & HAS_LABEL) && !getString(rec.label)) return fail();
+  if ((flags & HAS_NOGOOD) && !getString(rec.nogood)) return fail();
+  if ((flags & HAS_INFO) && !getString(rec.info)) return fail();
+
+  m_prev = uid;
+  --m_left;
+  return true;
+}
+
+/// ********* TESTS **********
+
+/// A search of `threads` interleaved workers; restarts, roots and
+/// parents far back in the numbering mixed in
+static std::vector<NodeRecord> makeTestNodes(int count, int threads) {
+
+  std::mt19937 rng(7);
+  std::vector<NodeRecord> nodes;
+  std::vector<int32_t> next_nid(threads, 0);
+
+  for (int i = 0; i < count; ++i) {
+    NodeRecord rec;
+    const int32_t tid = static_cast<int32_t>(rng() % threads);
+    const int32_t rid = i / (count / 4 + 1);
+    const int32_t nid = next_nid[tid]++;
+
+    rec.nodeUID = NodeUID{nid, rid, tid};
+    if (nid == 0) {
+      rec.parentUID = NodeUID{-1, -1, -1};
+    } else if (rng() % 16 == 0) {
+      rec.parentUID = NodeUID{static_cast<int32_t>(rng() % nid), rid, tid};
+    } else {
+      rec.parentUID = NodeUID{nid - 1, rid, tid};
+    }
+
+    rec.alt = static_cast<int32_t>(rng() % 2);
+    rec.numberOfKids = static_cast<int32_t>(rng() % 3);
+    rec.status = static_cast<char>(rng() % 4);
+    rec.thread_id = tid;
+    rec.time_stamp = 0;
+    rec.node_time = 0;
+    if (rng() % 2) rec.label = "x" + std::to_string(rng() % 50) + " <= 3";
+    if (rng() % 32 == 0) rec.nogood = "[x1 != 2, x4 >= 7]";
+    if (rng() % 64 == 0) rec.info = "{\"domain\": 3}";
+    nodes.push_back(std::move(rec));
+  }
+
+  return nodes;
+}
+
+static bool sameNode(const NodeRecord& a, const NodeRecord& b) {
+  return a.nodeUID == b.nodeUID && a.parentUID == b.parentUID &&
+         a.alt == b.alt && a.numberOfKids == b.numberOfKids &&
+         a.status == b.status && a.thread_id == b.thread_id &&
+         a.label == b.label && a.nogood == b.nogood && a.info == b.info;
+}
+
+void test_module() {
+
+  constexpr int N = 1000000;
+  const auto nodes = makeTestNodes(N, 4);
+
+  Encoder encoder;
+  for (auto& rec : nodes) encoder.add(rec);
+  const auto& payload = encoder.payload();
+
+  bool passed = true;
+
+  perfHelper.begin("node batch: decode 1M nodes");
+  Decoder decoder(payload.data(), payload.size());
+  NodeRecord rec;
+  int decoded = 0;
+  while (decoder.next(rec)) {
+    if (!sameNode(rec, nodes[decoded])) passed = false;
+    ++decoded;
+  }
+  perfHelper.end();
+
+  if (passed && decoded == N && !decoder.error()) {
+    std::cerr << "test passed! (" << payload.size() / N << " bytes/node)\n";
+  } else {
+    std::cerr << "test did NOT pass! (decoded " << decoded << " of " << N << ")\n";
+  }
+
+  /// cut short: every node before the cut, then an error
+  Decoder truncated(payload.data(), payload.size() / 2);
+  decoded = 0;
+  while (truncated.next(rec)) ++decoded;
+
+  if (truncated.error() && decoded > 0 && decoded < N) {
+    std::cerr << "test passed!\n";
+  } else {
+    std::cerr << "test did NOT pass! (truncated batch not detected)\n";
+  }
+}
+
+}
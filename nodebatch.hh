@@ -0,0 +1,125 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef NODEBATCH_HH
+#define NODEBATCH_HH
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "nodestore.hh"
+
+/// NODE_BATCH frames: many nodes of one connection packed into a single
+/// frame. Like any other frame, the payload starts with its message type
+/// (one byte); NODE_BATCH is a value that cpp-integration's MsgType does
+/// not use, so single NODE messages keep working as before.
+///
+///   payload: u8:type u32:count node*
+///   node:    u8:flags u8:status zz:nid_delta [zz:rid zz:tid]
+///            zz:parent_delta [zz:parent_rid zz:parent_tid]
+///            zz:alt vu:kids [vu:length bytes]{label, nogood, info}
+///
+/// vu is an unsigned LEB128 varint, zz a zigzag-encoded signed one.
+/// `nid_delta` is relative to the previous node's nid (0 before the
+/// first node), `parent_delta` to the node's own nid. Restart/thread ids
+/// are only present if they differ from the previous node's (the node's
+/// own for the parent); the strings only if their flag is set.
+namespace nodebatch {
+
+  void test_module();
+
+  constexpr char TYPE = 16;
+
+  enum Flags : uint8_t {
+    HAS_LABEL = 1,
+    HAS_NOGOOD = 2,
+    HAS_INFO = 4,
+    /// rid/tid differ from the previous node's
+    NEW_THREAD = 8,
+    /// parent's rid/tid differ from the node's
+    PARENT_THREAD = 16
+  };
+
+  /// Whether a frame's payload (after the size prefix) is a NODE_BATCH
+  inline bool isBatch(const char* payload, size_t size) {
+    return size > 0 && payload[0] == TYPE;
+  }
+
+  /// Packs nodes into the payload of one NODE_BATCH frame
+  class Encoder {
+
+    std::vector<char> m_data;
+    uint32_t m_count = 0;
+    NodeUID m_prev{0, 0, 0};
+
+    void putVarint(uint32_t value);
+    void putSigned(int32_t value);
+    void putString(const std::string& str);
+
+  public:
+
+    Encoder() { clear(); }
+
+    void add(const NodeRecord& rec);
+
+    uint32_t count() const { return m_count; }
+
+    /// The payload so far (without the frame's size prefix)
+    const std::vector<char>& payload();
+
+    void clear();
+  };
+
+  /// Reads the nodes of a NODE_BATCH payload in place, one at a time
+  class Decoder {
+
+    const char* m_pos;
+    const char* m_end;
+    uint32_t m_count = 0;
+    uint32_t m_left = 0;
+    NodeUID m_prev{0, 0, 0};
+    bool m_error = false;
+
+    bool getVarint(uint32_t& value);
+    bool getSigned(int32_t& value);
+    bool getString(std::string& str);
+
+  public:
+
+    Decoder(const char* payload, size_t size);
+
+    /// Number of nodes the batch announces
+    uint32_t count() const { return m_count; }
+
+    /// Decode the next node into `rec` (only the fields sent by the
+    /// solver are set); false when done or if the batch is malformed
+    bool next(NodeRecord& rec);
+
+    /// Whether the batch was cut short or inconsistent
+    bool error() const { return m_error; }
+  };
+
+}
+
+#endif // NODEBATCH_HH
@@ -404,7 +404,10 @@ HighlightCursor::HighlightCursor(VisualNode* startNode,
 inline void
 HighlightCursor::processCurrentNode(void) {
   VisualNode* n = node();
-  n->setHighlighted(true);
+  if (!n->isHighlighted()) {
+    n->setHighlighted(true);
+    n->dirtyUp(na);
+  }
 }
 
 inline
@@ -415,7 +418,10 @@ UnhighlightCursor::UnhighlightCursor(VisualNode* root,
 inline void
 UnhighlightCursor::processCurrentNode(void) {
   VisualNode* n = node();
-  n->setHighlighted(false);
+  if (n->isHighlighted()) {
+    n->setHighlighted(false);
+    n->dirtyUp(na);
+  }
 }
 
 inline
@@ -0,0 +1,194 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "nodeinfo.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "third-party/json.hpp"
+#include "libs/perf_helper.hh"
+
+namespace nodeinfo {
+
+static void parseJson(const std::string& info, NodeInfo& result) {
+
+  try {
+    const auto info_json = nlohmann::json::parse(info);
+
+    auto reasons = info_json.find("reasons");
+    if (reasons != info_json.end() && reasons->is_array()) {
+      result.reasons.reserve(reasons->size());
+      for (const auto& con_id : *reasons) {
+        if (con_id.is_number_integer()) result.reasons.push_back(con_id.get<int>());
+      }
+    }
+
+    /// either a number or an array starting with one
+    auto objective = info_json.find("objective");
+    if (objective != info_json.end()) {
+      const auto& value = objective->is_array() && !objective->empty()
+                            ? (*objective)[0] : *objective;
+      if (value.is_number()) {
+        result.objective = value.get<int>();
+        result.has_objective = true;
+      }
+    }
+
+    auto nogoods = info_json.find("nogoods");
+    result.has_nogoods = nogoods != info_json.end() &&
+                         nogoods->is_array() && !nogoods->empty();
+
+  } catch (std::exception&) {
+#ifdef MAXIM_DEBUG
+    std::cerr << "can't parse json in info\n";
+#endif
+  }
+}
+
+/// Number following `key` in `line` (after a ':' or '=')
+static const char* valueAfter(const std::string& line, const char* key) {
+  if (line.compare(0, std::strlen(key), key) != 0) return nullptr;
+  const char* pos = line.c_str() + std::strlen(key);
+  while (*pos == ' ' || *pos == ':' || *pos == '=' || *pos == '\t') ++pos;
+  return pos;
+}
+
+static void parseText(const std::string& info, NodeInfo& result) {
+
+  size_t begin = 0;
+  while (begin < info.size()) {
+    size_t end = info.find('\n', begin);
+    if (end == std::string::npos) end = info.size();
+
+    /// domain lines come first and are the majority; skip them quickly
+    if (info[begin] == 'f' || info[begin] == 'd') {
+      const std::string line = info.substr(begin, end - begin);
+
+      if (auto value = valueAfter(line, "full domain size")) {
+        char* value_end;
+        const long long size = std::strtoll(value, &value_end, 10);
+        if (value_end != value) result.domain_size = size;
+      } else if (auto value = valueAfter(line, "domain reduction")) {
+        char* value_end;
+        const double reduction = std::strtod(value, &value_end);
+        if (value_end != value) result.domain_reduction = reduction;
+      }
+    }
+
+    begin = end + 1;
+  }
+}
+
+NodeInfo parse(const std::string& info) {
+
+  NodeInfo result;
+
+  const size_t first = info.find_first_not_of(" \t\n");
+  if (first == std::string::npos) return result;
+
+  if (info[first] == '{') {
+    parseJson(info, result);
+  } else {
+    parseText(info, result);
+  }
+
+  return result;
+}
+
+static void test_parsing() {
+
+  bool passed = true;
+
+  {
+    auto info = parse("{\"reasons\": [3, 17, 42], \"nogoods\": [1, 2]}");
+    passed &= info.reasons == std::vector<int>{3, 17, 42} && info.has_nogoods &&
+              !info.has_objective && info.domain_size == -1;
+  }
+
+  {
+    auto info = parse("{\"objective\": [12, 0], \"nogoods\": []}");
+    passed &= info.has_objective && info.objective == 12 &&
+              !info.has_nogoods && info.reasons.empty();
+  }
+
+  {
+    auto info = parse("{\"objective\": 7}");
+    passed &= info.has_objective && info.objective == 7;
+  }
+
+  {
+    auto info = parse("x: {1..3}\ny: 2\nfull domain size: 6\ndomain reduction: 0.25\n");
+    passed &= info.domain_size == 6 && info.domain_reduction == 0.25 &&
+              info.reasons.empty() && !info.has_objective;
+  }
+
+  {
+    auto info = parse("{\"reasons\": [1, ");
+    passed &= info.reasons.empty() && !info.has_objective;
+  }
+
+  passed &= parse("").reasons.empty();
+
+  if (passed) {
+    std::cerr << "test passed!\n";
+  } else {
+    std::cerr << "test did NOT pass! (node info parsing)\n";
+  }
+}
+
+/// What a heatmap over N selected nogoods used to cost on every click
+static void test_decode_speed() {
+
+  constexpr int N = 20000;
+
+  std::vector<std::string> infos;
+  for (int i = 0; i < N; ++i) {
+    std::string info = "{\"reasons\": [";
+    for (int j = 0; j < 8; ++j) {
+      if (j > 0) info += ", ";
+      info += std::to_string((i * 31 + j * 7) % 5000);
+    }
+    info += "]}";
+    infos.push_back(std::move(info));
+  }
+
+  size_t total = 0;
+
+  perfHelper.begin("node info: decode 20K infos");
+  for (auto& info : infos) total += parse(info).reasons.size();
+  perfHelper.end();
+
+  if (total == 8u * N) {
+    std::cerr << "test passed!\n";
+  } else {
+    std::cerr << "test did NOT pass! (reasons decoded: " << total << ")\n";
+  }
+}
+
+void test_module() {
+  test_parsing();
+  test_decode_speed();
+}
+
+}
@@ -0,0 +1,56 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef NODEINFO_HH
+#define NODEINFO_HH
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// The fields of a node's info that the analyses use, decoded once.
+/// Info comes either as JSON (Chuffed: "reasons", "objective",
+/// "nogoods") or as text lines (Gecode: domains followed by
+/// "full domain size" and "domain reduction").
+struct NodeInfo {
+  /// ids of the constraints the node's nogood was derived from
+  std::vector<int> reasons;
+  /// whether "nogoods" lists any
+  bool has_nogoods = false;
+  bool has_objective = false;
+  int objective = 0;
+  /// -1 if not reported
+  int64_t domain_size = -1;
+  /// -1 if not reported
+  double domain_reduction = -1;
+};
+
+namespace nodeinfo {
+
+  void test_module();
+
+  /// Never throws; fields that are missing or malformed keep their defaults
+  NodeInfo parse(const std::string& info);
+
+}
+
+#endif // NODEINFO_HH
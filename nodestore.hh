@@ -0,0 +1,149 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef NODESTORE_HH
+#define NODESTORE_HH
+
+#include <string>
+#include <cstdint>
+
+#include "cpprofiler/universal.hh"
+#include "cpprofiler/utils/segmented_vector.hh"
+#include "cpprofiler/utils/label_dictionary.hh"
+
+/// A node as decoded by the receiver; travels to the builder through the
+/// ingest queue and only becomes part of Data once the builder commits it
+struct NodeRecord {
+    NodeUID nodeUID;
+    NodeUID parentUID;
+    int32_t alt;
+    int32_t numberOfKids;
+    int32_t thread_id;
+    char status;
+    uint64_t time_stamp;
+    uint64_t node_time;
+    std::string label;
+    std::string info;
+    std::string nogood;
+    /// set (>= 0) instead of `label` for nodes of a lazily loaded trace:
+    /// the label's id in the trace's label table
+    int32_t label_id = -1;
+};
+
+/// Columnar storage for the nodes received from the solver.
+/// A node is addressed by its array id (`aid`, the order of arrival);
+/// each field lives in its own dense column and labels are interned
+/// (in the dictionary shared by all executions).
+/// Columns never move their elements, so an aid (and a reference obtained
+/// through it) stays valid while the builder keeps appending nodes.
+class NodeStore {
+
+    template <typename T>
+    using Column = utils::SegmentedVector<T>;
+
+    Column<NodeUID> m_uid;
+    Column<NodeUID> m_parent_uid;
+    Column<int32_t> m_alt;
+    Column<int32_t> m_kids;
+    Column<int32_t> m_tid;
+    Column<int32_t> m_gid;
+    Column<int32_t> m_depth;
+    Column<int32_t> m_label;
+    Column<char> m_status;
+    /// microseconds since the search started
+    Column<uint64_t> m_time_stamp;
+    /// microseconds since the previous node
+    Column<uint64_t> m_node_time;
+
+    utils::LabelDictionary& m_labels = utils::LabelDictionary::global();
+
+public:
+
+    /// Append a node, returning its aid
+    int32_t add(NodeUID uid, NodeUID parent_uid, int32_t alt, int32_t kids,
+                int32_t tid, char status, uint64_t time_stamp,
+                uint64_t node_time, const std::string& label) {
+        return addInterned(uid, parent_uid, alt, kids, tid, status,
+                           time_stamp, node_time, m_labels.intern(label));
+    }
+
+    /// Same as `add`, with a label id from `internLabel`; `uid` is written
+    /// last so that `size()` only ever covers complete nodes
+    int32_t addInterned(NodeUID uid, NodeUID parent_uid, int32_t alt, int32_t kids,
+                        int32_t tid, char status, uint64_t time_stamp,
+                        uint64_t node_time, int32_t label_id) {
+        m_parent_uid.push_back(parent_uid);
+        m_alt.push_back(alt);
+        m_kids.push_back(kids);
+        m_tid.push_back(tid);
+        m_gid.push_back(-1); // set to -1 so we don't forget to assign the real value
+        m_depth.push_back(-1);
+        m_label.push_back(label_id);
+        m_status.push_back(status);
+        m_time_stamp.push_back(time_stamp);
+        m_node_time.push_back(node_time);
+        m_uid.push_back(uid);
+        return static_cast<int32_t>(m_uid.size() - 1);
+    }
+
+    size_t size() const { return m_uid.size(); }
+
+    const NodeUID& uid(int32_t aid) const { return m_uid[aid]; }
+    const NodeUID& parentUID(int32_t aid) const { return m_parent_uid[aid]; }
+    int32_t alt(int32_t aid) const { return m_alt[aid]; }
+    int32_t kids(int32_t aid) const { return m_kids[aid]; }
+    int32_t tid(int32_t aid) const { return m_tid[aid]; }
+    int32_t gid(int32_t aid) const { return m_gid[aid]; }
+    int32_t depth(int32_t aid) const { return m_depth[aid]; }
+    char status(int32_t aid) const { return m_status[aid]; }
+    uint64_t timeStamp(int32_t aid) const { return m_time_stamp[aid]; }
+    uint64_t nodeTime(int32_t aid) const { return m_node_time[aid]; }
+
+    const std::string& label(int32_t aid) const {
+        return m_labels.label(m_label[aid]);
+    }
+
+    int32_t labelId(int32_t aid) const { return m_label[aid]; }
+
+    const utils::Decision& decision(int32_t aid) const {
+        return m_labels.decision(m_label[aid]);
+    }
+
+    void setGid(int32_t aid, int32_t gid) { m_gid[aid] = gid; }
+    void setDepth(int32_t aid, int32_t depth) { m_depth[aid] = depth; }
+    void setLabel(int32_t aid, const std::string& label) {
+        m_label[aid] = m_labels.intern(label);
+    }
+
+    int32_t internLabel(const std::string& label) { return m_labels.intern(label); }
+
+    /// Bytes allocated for the columns (not counting label text)
+    size_t columnBytes() const {
+        return m_uid.allocatedBytes() + m_parent_uid.allocatedBytes() +
+               m_alt.allocatedBytes() + m_kids.allocatedBytes() +
+               m_tid.allocatedBytes() + m_gid.allocatedBytes() +
+               m_depth.allocatedBytes() + m_label.allocatedBytes() +
+               m_status.allocatedBytes() + m_time_stamp.allocatedBytes() +
+               m_node_time.allocatedBytes();
+    }
+};
+
+#endif // NODESTORE_HH
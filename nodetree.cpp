@@ -19,6 +19,7 @@
  */
 
 #include "nodetree.hh"
+#include "treesnapshot.hh"
 #include "cpprofiler/utils/tree_utils.hh"
 
 NodeTree::NodeTree() {
@@ -65,4 +66,19 @@ const Statistics& NodeTree::getStatistics() const {
 }
 
 QMutex& NodeTree::getTreeMutex() { return treeMutex; }
-QMutex& NodeTree::getLayoutMutex() { return layoutMutex; }
\ No newline at end of file
+QMutex& NodeTree::getLayoutMutex() { return layoutMutex; }
+
+std::shared_ptr<const TreeSnapshot> NodeTree::snapshot() {
+    QMutexLocker locker(&treeMutex);
+
+    if (!m_snapshot || m_snapshot->allocated() != na.size()) {
+        m_snapshot = std::make_shared<const TreeSnapshot>(*this);
+    }
+
+    return m_snapshot;
+}
+
+void NodeTree::thaw() {
+    QMutexLocker locker(&treeMutex);
+    m_snapshot.reset();
+}
\ No newline at end of file
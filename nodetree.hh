@@ -25,8 +25,11 @@
 
 #include <QMutex>
 #include <QObject>
+#include <memory>
 #include "visualnode.hh"
 
+class TreeSnapshot;
+
 class NodeTree : public QObject {
 Q_OBJECT
 private:
@@ -37,6 +40,8 @@ private:
     QMutex layoutMutex {QMutex::Recursive};
     NodeAllocator na;
     Statistics stats;
+    /// Taken by `snapshot`, dropped when the tree changes
+    std::shared_ptr<const TreeSnapshot> m_snapshot;
 public:
     NodeTree();
     ~NodeTree();
@@ -61,6 +66,13 @@ public:
     QMutex& getTreeMutex();
     QMutex& getLayoutMutex();
 
+    /// Preorder snapshot of the tree for read-only passes over all of
+    /// it; taken again only if nodes were added or `thaw` was called since
+    std::shared_ptr<const TreeSnapshot> snapshot();
+    /// The tree was changed other than by adding nodes (e.g. a node was
+    /// removed): the current snapshot is out of date
+    void thaw();
+
 private:
 signals:
     void treeModified();
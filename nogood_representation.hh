@@ -2,18 +2,21 @@
 #define NOGOOD_REPRESENTATION_H
 
 #include <string>
-#include <unordered_map>
 #include <cpprofiler/universal.hh>
+#include <cpprofiler/utils/uid_map.hh>
 
 struct NogoodViews {
   std::string original;
   std::string renamed;
   std::string simplified;
+  /// whether `renamed` and `simplified` have been made (they are
+  /// produced after the nogood is received, see Data)
+  bool has_views = false;
 
   NogoodViews() {}
   NogoodViews(std::string orig) : original(orig) {}
 };
 
-using Uid2Nogood = std::unordered_map<NodeUID, NogoodViews>;
+using Uid2Nogood = utils::UidMap<NogoodViews>;
 
 #endif // NOGOOD_REPRESENTATION_H
@@ -127,8 +127,7 @@ bool NogoodProxyModel::filterAcceptsRow(int source_row, const QModelIndex&) cons
   bool text_matches = filterAcceptsText(nogood);
 
   const NodeUID node = string_to_NodeUID(sourceModel()->data(sourceModel()->index(source_row, _sid_col)).toString().toStdString());
-  const string* maybe_info = ex.getInfo(node);
-  auto reasons = getReasons(maybe_info);
+  auto reasons = ex.getReasons(node);
   bool loc_matches = true;
   if(_nm) {
     loc_matches = std::all_of(reasons.begin(),
@@ -211,8 +210,7 @@ void NogoodTableView::getHeatmapAndEmit(const TreeCanvas& tc, bool record = fals
   int max_count = 0;
   for(int i=0; i<selection.count(); i++) {
     NodeUID uid = getUidFromRow(selection.at(i).row());
-    const string* maybe_info = _execution.getInfo(uid);
-    for(int con_id : getReasons(maybe_info)) {
+    for(int con_id : _execution.getReasons(uid)) {
       int count = 0;
       if(con_ids.find(con_id) == con_ids.end()) {
         con_ids[con_id] = 1;
@@ -446,7 +444,7 @@ void NogoodTableView::saveNogoods(bool is_comparison) const {
     NodeUID pid = _execution.getParentUID(uid);
 
     QString clause = getNogoodFromRow(row);
-    auto reasons = getReasons(_execution.getInfo(uid));
+    auto reasons = _execution.getReasons(uid);
 
     nogood_stream << uid.nid << sep << uid.rid << sep << uid.tid << sep;
     nogood_stream << pid.nid << sep << pid.rid << sep << pid.tid << sep;
@@ -518,8 +516,7 @@ void NogoodTableView::updateLocationFilter(QLineEdit* location_edit) const {
   const QModelIndexList selection = getSelection();
   for(int i=0; i<selection.count(); i++) {
     NodeUID uid = getUidFromRow(selection.at(i).row());
-    const string* maybe_info = _execution.getInfo(uid);
-    auto reasons = getReasons(maybe_info);
+    auto reasons = _execution.getReasons(uid);
     locationFilterText.push_back(_execution.getNameMap()->getLocationFilterString(reasons));
   }
 
@@ -0,0 +1,374 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "parallellayout.hh"
+#include "visualnode.hh"
+#include "layoutcursor.hh"
+#include "nodevisitor.hh"
+#include "nodetree.hh"
+#include "cpprofiler/utils/tree_utils.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "libs/perf_helper.hh"
+
+namespace {
+
+/// Dirty subtrees with fewer nodes than this are not worth a task
+constexpr int SERIAL_CUTOFF = 2048;
+
+/// Subtrees handed off by a node that are not laid out yet
+struct Join {
+    std::atomic<int> pending{0};
+};
+
+struct Task {
+    VisualNode* root;
+    const NodeAllocator* na;
+    Join* join;
+};
+
+/// Threads that lay out subtrees handed off to them; they sleep while
+/// there is nothing to lay out and are shared by all trees
+class LayoutPool {
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Task> m_tasks;
+    std::vector<std::thread> m_workers;
+
+    /// workers waiting for a task
+    std::atomic<int> m_idle{0};
+    /// tasks not picked up yet
+    std::atomic<int> m_queued{0};
+
+    bool m_stop = false;
+
+    void work();
+
+public:
+
+    LayoutPool();
+    ~LayoutPool();
+
+    LayoutPool(const LayoutPool&) = delete;
+    LayoutPool& operator=(const LayoutPool&) = delete;
+
+    static LayoutPool& instance();
+
+    bool hasWorkers() const { return !m_workers.empty(); }
+
+    /// Whether a task handed off now would be picked up right away
+    bool hungry() const {
+        return m_idle.load(std::memory_order_relaxed) >
+               m_queued.load(std::memory_order_relaxed);
+    }
+
+    void push(const Task& task);
+
+    /// Run a queued task on the calling thread (false if there is none)
+    bool runOne();
+};
+
+/// Layout state of a node on the stack of `layoutSubtree`
+struct Frame {
+    VisualNode* node;
+    /// children to visit (0 if the node is not dirty)
+    int kids;
+    /// next child to visit
+    int next;
+    /// set once the remaining children have been split up (see `split`)
+    bool split;
+    /// after the split, the only child still to be visited from here
+    int keep;
+    /// children handed off to other threads
+    Join* join;
+};
+
+static Frame frameOf(VisualNode* n) {
+    /// as in `LayoutCursor::mayMoveDownwards`
+    const int kids = n->isDirty() ? n->getNumberOfChildren() : 0;
+    return Frame{n, kids, 0, false, -1, nullptr};
+}
+
+/// Number of nodes the layout of `n` would visit, counted up to `limit`
+static int dirtySize(VisualNode* n, const NodeAllocator& na, int limit) {
+
+    static thread_local std::vector<VisualNode*> stack;
+    stack.clear();
+    stack.push_back(n);
+
+    int count = 0;
+    while (!stack.empty() && count < limit) {
+        VisualNode* v = stack.back();
+        stack.pop_back();
+        ++count;
+        if (!v->isDirty()) continue;
+        for (int i = v->getNumberOfChildren(); i--;) {
+            stack.push_back(v->getChild(na, i));
+        }
+    }
+
+    return count;
+}
+
+static void layoutSubtree(VisualNode* root, const NodeAllocator& na, bool may_split);
+
+/// Hand off the large ones among the children of `f` that are left, but
+/// for the first of them (visited from `f` as usual), and lay out the
+/// small ones right away
+static void split(Frame& f, const NodeAllocator& na, LayoutPool& pool) {
+
+    std::vector<VisualNode*> small;
+
+    for (int alt = f.next; alt < f.kids; ++alt) {
+        VisualNode* kid = f.node->getChild(na, alt);
+
+        if (dirtySize(kid, na, SERIAL_CUTOFF) < SERIAL_CUTOFF) {
+            small.push_back(kid);
+        } else if (f.keep < 0) {
+            f.keep = alt;
+        } else {
+            if (!f.join) f.join = new Join;
+            f.join->pending.fetch_add(1, std::memory_order_relaxed);
+            pool.push(Task{kid, &na, f.join});
+        }
+    }
+
+    f.split = true;
+    f.next = f.kids;
+
+    for (auto kid : small) {
+        layoutSubtree(kid, na, false);
+    }
+}
+
+/// Help with other tasks until the children handed off are laid out
+static void waitFor(Join& join, LayoutPool& pool) {
+    while (join.pending.load(std::memory_order_acquire) > 0) {
+        if (!pool.runOne()) std::this_thread::yield();
+    }
+}
+
+/// Postorder over the dirty part of the subtree (as `LayoutCursor` does)
+/// with an explicit stack
+static void layoutSubtree(VisualNode* root, const NodeAllocator& na, bool may_split) {
+
+    auto& pool = LayoutPool::instance();
+    may_split = may_split && pool.hasWorkers();
+
+    std::vector<Frame> stack;
+    stack.push_back(frameOf(root));
+
+    while (!stack.empty()) {
+        Frame& f = stack.back();
+
+        if (may_split && !f.split && f.kids - f.next >= 2 && pool.hungry()) {
+            split(f, na, pool);
+        }
+
+        int alt = -1;
+        if (f.split) {
+            alt = f.keep;
+            f.keep = -1;
+        } else if (f.next < f.kids) {
+            alt = f.next++;
+        }
+
+        if (alt >= 0) {
+            VisualNode* kid = f.node->getChild(na, alt);
+            stack.push_back(frameOf(kid));
+            continue;
+        }
+
+        /// all children are laid out: merge their contours
+        if (f.join) {
+            waitFor(*f.join, pool);
+            delete f.join;
+        }
+
+        LayoutCursor::layoutNode(f.node, na);
+        stack.pop_back();
+    }
+}
+
+static void runTask(const Task& task) {
+    layoutSubtree(task.root, *task.na, true);
+    task.join->pending.fetch_sub(1, std::memory_order_release);
+}
+
+LayoutPool::LayoutPool() {
+    /// the thread that starts a layout takes part in it
+    const unsigned threads = std::thread::hardware_concurrency();
+    for (unsigned i = 1; i < threads; ++i) {
+        m_workers.emplace_back(&LayoutPool::work, this);
+    }
+}
+
+LayoutPool::~LayoutPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers) worker.join();
+}
+
+LayoutPool& LayoutPool::instance() {
+    static LayoutPool pool;
+    return pool;
+}
+
+void LayoutPool::work() {
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        ++m_idle;
+        m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+        --m_idle;
+
+        if (m_stop) return;
+
+        const Task task = m_tasks.back();
+        m_tasks.pop_back();
+        --m_queued;
+
+        lock.unlock();
+        runTask(task);
+        lock.lock();
+    }
+}
+
+void LayoutPool::push(const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(task);
+        ++m_queued;
+    }
+    m_cv.notify_one();
+}
+
+bool LayoutPool::runOne() {
+
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) return false;
+        task = m_tasks.back();
+        m_tasks.pop_back();
+        --m_queued;
+    }
+
+    runTask(task);
+    return true;
+}
+
+}
+
+void parallelLayout(VisualNode* root, const NodeAllocator& na) {
+    layoutSubtree(root, na, true);
+}
+
+namespace parallellayout {
+
+    static bool sameLayout(const NodeTree& a, const NodeTree& b) {
+
+        const auto& na = a.getNA();
+        const auto& nb = b.getNA();
+
+        if (na.size() != nb.size()) return false;
+
+        for (int gid = 0; gid < na.size(); ++gid) {
+            VisualNode* x = na[gid];
+            VisualNode* y = nb[gid];
+
+            if (x->isDirty() || y->isDirty()) return false;
+            if (x->getOffset() != y->getOffset()) return false;
+
+            const Shape& s = *x->getShape();
+            const Shape& t = *y->getShape();
+
+            if (s.depth() != t.depth()) return false;
+            for (int i = 0; i < s.depth(); ++i) {
+                if (s[i].l != t[i].l || s[i].r != t[i].r) return false;
+            }
+        }
+
+        return true;
+    }
+
+    static void serialLayout(NodeTree& nt) {
+        LayoutCursor l(nt.getRoot(), nt.getNA());
+        PostorderNodeVisitor<LayoutCursor>(l).run();
+    }
+
+    /// The parallel layout must agree with the serial one, both for
+    /// a full layout and after hiding some subtrees
+    static bool sameAsSerial(int nodes) {
+
+        NodeTree serial;
+        NodeTree parallel;
+
+        utils::buildRandomTree(serial, nodes, 11);
+        utils::buildRandomTree(parallel, nodes, 11);
+
+        perfHelper.begin("layout: serial, 1M nodes");
+        serialLayout(serial);
+        perfHelper.end();
+
+        perfHelper.begin("layout: parallel, 1M nodes");
+        parallelLayout(parallel.getRoot(), parallel.getNA());
+        perfHelper.end();
+
+        if (!sameLayout(serial, parallel)) return false;
+
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> any_gid(1, nodes - 1);
+
+        for (int i = 0; i < 100; ++i) {
+            const int gid = any_gid(rng);
+            serial.getNA()[gid]->toggleHidden(serial.getNA());
+            parallel.getNA()[gid]->toggleHidden(parallel.getNA());
+        }
+
+        serialLayout(serial);
+        parallelLayout(parallel.getRoot(), parallel.getNA());
+
+        return sameLayout(serial, parallel);
+    }
+
+    void test_module() {
+        if (sameAsSerial(1000000)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (parallel layout differs from serial)\n";
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef PARALLELLAYOUT_HH
+#define PARALLELLAYOUT_HH
+
+class VisualNode;
+class NodeAllocator;
+
+namespace parallellayout { void test_module(); }
+
+/// Compute the layout of the dirty part of the subtree of `root`, giving
+/// the same result as `LayoutCursor`. Sibling subtrees do not depend on
+/// each other, so while some of the layout threads are idle, large dirty
+/// children of the node being laid out are handed off to them; their
+/// contours are merged once all of them are done. Dirty subtrees below
+/// a size cutoff, and everything when no thread is idle, are laid out
+/// serially by the thread that got there.
+void parallelLayout(VisualNode* root, const NodeAllocator& na);
+
+#endif
@@ -9,6 +9,8 @@
 #include "libs/perf_helper.hh"
 #include "treecanvas.hh"
 #include "receiverthread.hh"
+#include "traceloader.hh"
+#include "tracefile.hh"
 
 #include "ml-stats.hh"
 //#include "webscript.hh"
@@ -27,32 +29,6 @@
 
 #include "subtree_comparison.hpp"
 
-// Execution* loadSaved(Execution* e, std::string path) {
-//   std::ifstream inputFile(path, std::ios::in | std::ios::binary);
-//   IstreamInputStream raw_input(&inputFile);
-//   while (true) {
-//     message::Node msg;
-//     bool ok = readDelimitedFrom(&raw_input, &msg);
-//     if (!ok) break;
-//     switch (msg.type()) {
-//       case message::Node::NODE: {
-//           e->handleNewNode(msg);
-//           break;
-//       }
-//       case message::Node::START: {
-//         bool is_restarts = (msg.restart_id() == 0);
-//         e->start("loaded from " + path, is_restarts);
-//         if (msg.has_info()) {
-//             e->setVariableListString(msg.info());
-//         }
-//         break;
-//       }
-//     }
-//   }
-//   e->doneReceiving();
-//   return e;
-// }
-
 ProfilerConductor::ProfilerConductor() : QMainWindow(), listen_port(6565) {
   executionTreeView.setModel(&executionTreeModel);
   executionTreeView.setSelectionMode(QAbstractItemView::MultiSelection);
@@ -177,28 +153,18 @@ ProfilerConductor::ProfilerConductor() : QMainWindow(), listen_port(6565) {
 
   centralWidget->setLayout(layout);
 
-  // Listen for new executions.
-  listener.reset(new ProfilerTcpServer([this](qintptr socketDescriptor) {
-    // auto execution = new Execution();
-
-    if (!latest_execution) {
-      latest_execution = new Execution();
-    }
-
-    /// TODO(maxim): receiver should be destroyed when done?
-    auto receiver = new ReceiverThread(socketDescriptor, latest_execution, this);
+  router.reset(new ExecutionRouter);
+  receivers.reset(new ReceiverPool(*router));
 
-    connect(receiver, &ReceiverThread::executionIdReady,
-      this, &ProfilerConductor::executionIdReady);
+  connect(receivers.get(), &ReceiverPool::executionIdReady,
+    this, &ProfilerConductor::executionIdReady);
 
-    connect(receiver, &ReceiverThread::executionStarted,
-      this, &ProfilerConductor::executionStarted);
-
-    connect(receiver, &ReceiverThread::doneReceiving, [this]() {
-      latest_execution = nullptr;
-    });
+  connect(receivers.get(), &ReceiverPool::executionStarted,
+    this, &ProfilerConductor::executionStarted);
 
-    receiver->start();
+  // Listen for new executions.
+  listener.reset(new ProfilerTcpServer([this](qintptr socketDescriptor) {
+    receivers->addConnection(socketDescriptor);
   }));
 
   if(!listener->listen(QHostAddress::Any, listen_port)) {
@@ -499,53 +465,36 @@ void ProfilerConductor::tellVisualisationsSelectManyNodes(Execution* execution,
 
 void ProfilerConductor::saveExecutionClicked() {
 
-  // QList<QListWidgetItem*> selected = executionList.selectedItems();
-  // if (selected.size() != 1) return;
-  // auto item = static_cast<ExecutionListItem*>(selected[0]);
-
-  // QString filename =
-  //     QFileDialog::getSaveFileName(this, "Save execution", QDir::currentPath());
-
-  // std::ofstream outputFile(filename.toStdString(),
-  //                          std::ios::out | std::ios::binary);
-  // OstreamOutputStream raw_output(&outputFile);
-  // auto& data = item->execution_.getData();
-
-  // message::Node start_node;
-  // start_node.set_type(message::Node::START);
-
-  // if (item->execution_.isRestarts()) {
-  //   start_node.set_restart_id(0);
-  // } else {
-  //   start_node.set_restart_id(-1);
-  // }
-
-  // start_node.set_info("{\"execution_id\": " + std::to_string(item->execution_.getExecutionId()) + "}");
-
-  // start_node.set_info(item->execution_.getVariableListString());
-  // writeDelimitedTo(start_node, &raw_output);
-
-  // for (auto* entry : data.getEntries()) {
-  //   message::Node node;
-  //   node.set_type(message::Node::NODE);
-  //   node.set_sid(entry->s_node_id);
-  //   node.set_pid(entry->parent_sid);
-  //   node.set_alt(entry->alt);
-  //   node.set_kids(entry->numberOfKids);
-  //   node.set_status(static_cast<message::Node::NodeStatus>(entry->status));
-  //   //            node.set_restart_id
-  //   node.set_time(entry->time_stamp);
-  //   node.set_thread_id(entry->thread_id);
-  //   node.set_label(entry->label);
-  //   node.set_domain_size(entry->domain);
-  //   //            node.set_solution(entry->);
-  //   auto ngit = data.getNogoods().find(entry->s_node_id);
-  //   if (ngit != data.getNogoods().end()) node.set_nogood(ngit->second.original);
-  //   auto infoit = data.sid2info.find(entry->s_node_id);
-  //   if (infoit != data.sid2info.end()) node.set_info(*infoit->second);
-  //   writeDelimitedTo(node, &raw_output);
-  // }
+  auto selected_executions = getSelectedExecutions();
+  if (selected_executions.size() != 1) return;
+  auto ex = selected_executions[0];
+
+  QString filename =
+      QFileDialog::getSaveFileName(this, "Save execution", QDir::currentPath());
+  if (filename.isNull()) return;
+
+  tracefile::Writer writer(filename.toStdString());
+  if (!writer.isOpen()) {
+    qDebug() << "could not open the file: " << filename;
+    return;
+  }
+
+  perfHelper.begin("save execution");
+
+  tracefile::Header header;
+  header.title = ex->getTitle();
+  header.variables = ex->getVariableListString();
+  header.has_restarts = ex->isRestarts();
+  header.execution_id = ex->getExecutionId();
+  writer.writeHeader(header);
 
+  ex->getData().saveNodes(writer);
+
+  if (!writer.finish()) {
+    qDebug() << "could not write the execution to: " << filename;
+  }
+
+  perfHelper.end();
 }
 
 void ProfilerConductor::loadExecutionClicked() {
@@ -558,9 +507,45 @@ void ProfilerConductor::loadExecutionClicked() {
 
 
 void ProfilerConductor::loadExecution(std::string filename) {
+
+  auto loader = new TraceLoader(filename, this);
+
+  tracefile::Header header;
+  if (!loader->open(header)) {
+    std::cerr << "can't load execution " << filename << ": " << loader->error() << "\n";
+    delete loader;
+    return;
+  }
+
+  qDebug() << "loading" << header.node_count << "nodes";
+
   auto e = new Execution();
+  e->setVariableListString(header.variables);
+  e->begin(header.title.empty() ? "loaded from " + filename : header.title,
+           header.has_restarts);
   addExecution(*e);
-  // loadSaved(e, filename);
+
+  auto eid = getNextExecId("Loaded Execution", e->getTitle(), NameMap());
+  executionTreeModel.addExecution(&executionTreeView, executionMetadata[eid], e);
+
+  connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+
+  loader->load(e);
+}
+
+void ProfilerConductor::replayCapture(const QString& filename, bool paced) {
+
+  auto replay = new ReplayThread(filename, paced, *router, this);
+
+  connect(replay, &ReplayThread::executionIdReady,
+    this, &ProfilerConductor::executionIdReady);
+
+  connect(replay, &ReplayThread::executionStarted,
+    this, &ProfilerConductor::executionStarted);
+
+  connect(replay, &QThread::finished, replay, &QObject::deleteLater);
+
+  replay->start();
 }
 
 void ProfilerConductor::deleteExecutionClicked() {
@@ -619,7 +604,6 @@ void ProfilerConductor::createExecution(std::unique_ptr<NodeTree> nt,
 }
 
 void ProfilerConductor::executionIdReady(Execution* e) {
-  // latest_execution = e; // TODO(maxim): check if still needed
   int eid = e->getExecutionId();
   auto eit = executionMetadata.find(eid);
   if(eit == executionMetadata.end())
@@ -631,7 +615,7 @@ void ProfilerConductor::executionIdReady(Execution* e) {
   executionTreeView.update();
 
   e->has_exec_id = true;
-  e->has_exec_id_cond.wakeOne();
+  emit e->execIdKnown();
 }
 
 void ProfilerConductor::executionStarted(Execution* e) {
@@ -19,6 +19,8 @@ class Data;
 class CmpTreeDialog;
 
 class ProfilerTcpServer;
+class ExecutionRouter;
+class ReceiverPool;
 
 class ExecutionInfo {
 public:
@@ -43,8 +45,10 @@ class ProfilerConductor : public QMainWindow {
 
   QHash<int, MetaExecution> executionMetadata;
 
-  /// NOTE(maxim): This is a bit hacky
-  Execution* latest_execution = nullptr;
+  /// Sends the nodes of every connection to the right execution
+  std::unique_ptr<ExecutionRouter> router;
+  /// Threads that decode the solvers' messages
+  std::unique_ptr<ReceiverPool> receivers;
 
   std::unique_ptr<ProfilerTcpServer> listener;
 
@@ -84,6 +88,8 @@ class ProfilerConductor : public QMainWindow {
                     const NameMap& nameMap);
   int getListenPort();
   void loadExecution(std::string filename);
+  /// Receive an execution from a file recorded with `--capture`
+  void replayCapture(const QString& filename, bool paced);
   void createExecution(std::unique_ptr<NodeTree> nt, std::unique_ptr<Data>);
 
   void autoCompareTwoExecution();
@@ -19,139 +19,65 @@
  *
  */
 
+
 #include "readingQueue.hh"
 #include "data.hh"
-#include <iostream>
+#include <algorithm>
 
-ReadingQueue::ReadingQueue(const std::vector<DbEntry*>& nodes)
-: nodes_arr(nodes)
+ReadingQueue::ReadingQueue(const NodeStore& nodes)
+: nodes(nodes)
 {
 
 }
 
-DbEntry*
-ReadingQueue::next(bool& delayed) {
-
-  /// if normal read mode && nodes_arr has unread elements
-  if (!read_delayed && nodes_arr.size() > last_read) {
-
-    /// come back to delayed anyway?
-    if (delayed_count > 0 && delayed_cd_count <= 0){
-      read_delayed = true;
-      return next(delayed);
-    }
-
-    delayed = false;
-    return nodes_arr[last_read++];
-  } else {
-    /// continue reading delayed or ran out of normal nodes
-
-    /// option 1: can't read, try new queue
-    if (it->second->size() == 0 || it == delayed_treads.end()) {
-      it = nextNonemptyIt(++it);
-      if (it == delayed_treads.end()) {
-        std::cout << "no more delayed, reading normal nodes\n";
-        read_delayed = false;
-        /// recursion should not happen, because that would mean
-        /// there is no more nodes to read, so next() would not
-        /// be called in the first place
-        return next(delayed);
-      }
-    }
-
-    /// at this point there is nonempty queue at it->second
-    delayed = true;
-    read_delayed = true;
-    return it->second->front();
-  }
-
-}
+DbEntry
+ReadingQueue::next() {
 
-QueueMap::iterator
-ReadingQueue::nextNonemptyIt(QueueMap::iterator it) {
-  while (it != delayed_treads.end()) {
-    if (it->second->size() > 0) {
-      // std::cout << "found delayed on tread: " << it->first << "\n";
-      break;
-    }
+  /// their parent has just been placed
+  if (!ready.empty()) {
+    const int32_t aid = ready.front();
+    ready.pop_front();
+    return DbEntry{&nodes, aid};
   }
-  return it;
-}
-
 
-bool
-ReadingQueue::canRead() {
-  if (nodes_arr.size() != last_read || delayed_count > 0) {
-    return true;
-  }
-  return false;
+  return DbEntry{&nodes, static_cast<int32_t>(last_read++)};
 }
 
 void
-ReadingQueue::update(bool success) {
-  /// if success on array -> continue array
-  // if (!read_delayed && success) {
-  //   std::cout << "successfully read, misses: " << node_misses << "\n";
-  //   node_misses = 0;
-  //   delayed_cd_count--;
-  //   return;
-  // }
-
-  /// if success on delayed -> continue delayed
-  if (read_delayed && success) {
-    it->second->pop();
-    delayed_count--;
-    std::cout << "successfully read from delayed, ";
-    std::cout << delayed_count << " left ";
-    std::cout << " misses: " << node_misses << "\n";
-    return;
-  }
+ReadingQueue::placed(DbEntry entry) {
 
-  /// if failure on array -> switch to first nonempty queue of delayed
-  if (!read_delayed && !success) {
-    node_misses++;
-
-    it = nextNonemptyIt(delayed_treads.begin()); /// start from the beginning
-    /// if found -> read from that queue next
-    if (it != delayed_treads.end()) {
-      read_delayed = true;
-      /// todo: remember the queue
-    } else {
-#ifdef MAXIM_DEBUG
-      std::cerr << "can't read from either queue\n";
-#endif
-    }
-    return;
-  }
+  if (waiting.empty()) return;
+
+  const NodeUID uid = entry.nodeUID();
+
+  auto it = waiting.find(uid);
+  if (it == waiting.end()) return;
 
-  /// if failure on delayed -> try another queue or switch to array
-  if (read_delayed && !success) {
-    node_misses++;
-    it = nextNonemptyIt(++it);  /// start where left last time
-
-    if (it != delayed_treads.end()) {
-      /// todo: remember the queue
-    } else {
-      // std::cerr << "can't read delayed, trying normal nodes\n";
-      delayed_cd_count = DELAYED_CD;
-      read_delayed = false;
-    }
-    return;
+  for (auto aid : it->second) {
+    ready.push_back(aid);
+    parked_depth.erase(DbEntry{&nodes, aid}.nodeUID());
   }
 
+  parked_count -= it->second.size();
+  waiting.erase(it);
 }
 
 void
-ReadingQueue::readLater(DbEntry* delayed) {
-  int tid = delayed->thread_id;
+ReadingQueue::readLater(DbEntry entry) {
 
-  if (delayed_treads.find(tid) == delayed_treads.end()) {
-      std::cout << "create delayed_treads[" << tid << "] queue\n";
-      delayed_treads[tid] = new std::queue<DbEntry*>(); /// TODO: delete queues in the end
+  const NodeUID p_uid = entry.parentUID();
+
+  /// one deeper than the parent if the parent is parked itself
+  int depth = 1;
+  auto parent = parked_depth.find(p_uid);
+  if (parent != parked_depth.end()) {
+    depth = parent->second + 1;
   }
+  parked_depth[entry.nodeUID()] = depth;
+
+  waiting[p_uid].push_back(entry.aid());
 
-  /// delayed_treads[tid] exists at this point
-  delayed_count++;
-  delayed_treads[tid]->push(delayed);
-  // std::cout << "push " << *delayed_treads[tid]->front() << " into delayed_treads[" << tid << "]\n";
-}
\ No newline at end of file
+  parked_count++;
+  max_parked = std::max(max_parked, parked_count);
+  max_parked_depth = std::max(max_parked_depth, depth);
+}
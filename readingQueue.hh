@@ -19,54 +19,70 @@
  *
  */
 
+
 #ifndef READING_QUEUE
 #define READING_QUEUE
 
 #include <vector>
-#include <map>
-#include <queue>
-#include "readingQueue.hh"
-
-class DbEntry;
+#include <deque>
+#include <unordered_map>
 
-typedef std::map<int, std::queue<DbEntry*>*> QueueMap;
+#include "data.hh"
 
+/// Order in which the builder visits nodes: new nodes in arrival
+/// order, interleaved with nodes whose parent has just been placed.
+/// A node that arrives before its parent is parked under the parent's
+/// uid and released exactly once, when that parent is placed.
 class ReadingQueue {
  private:
   /// nodes from Data
-  const std::vector<DbEntry*>& nodes_arr;
+  const NodeStore& nodes;
 
-  /// nodes delayed, map: thread_id -> queue
-  QueueMap delayed_treads;
-  QueueMap::iterator it;
+  /// array id of the next new node to read
+  unsigned last_read = 0;
 
-  unsigned last_read = 0;    /// node id from nodes_arr currently read
-  int delayed_count = 0;     /// how many nodes delayed
-  int delayed_cd_count = 0;  /// if zero, read delayed again
-  const int DELAYED_CD = 1;  /// delayed cooldown
+  /// parked children released by their parents, read before new nodes
+  std::deque<int32_t> ready;
 
-  /// how many nodes tried until success;
-  /// increment if failed
-  /// refresh on success
-  int node_misses = 0;
+  /// missing parent uid -> children waiting for it (array ids)
+  std::unordered_map<NodeUID, std::vector<int32_t>> waiting;
 
-  bool read_delayed = false;
+  /// length of the chain of parked ancestors above each parked node
+  /// (1 if its parent is not parked itself)
+  std::unordered_map<NodeUID, int> parked_depth;
 
-  inline QueueMap::iterator nextNonemptyIt(QueueMap::iterator it);
+  size_t parked_count = 0;
+  size_t max_parked = 0;
+  int max_parked_depth = 0;
 
  public:
-  explicit ReadingQueue(const std::vector<DbEntry*>& nodes);
+  explicit ReadingQueue(const NodeStore& nodes);
+
+  /// next node to try: released children first, then new nodes
+  DbEntry next();
+
+  /// whether there are new or released nodes to read
+  bool canRead() const { return !ready.empty() || hasUnread(); }
+
+  /// whether there are nodes never tried before
+  bool hasUnread() const { return nodes.size() > last_read; }
+
+  /// number of nodes (new and released) waiting to be processed
+  int pending() const { return (nodes.size() - last_read) + ready.size(); }
 
-  DbEntry* next(bool& delayed);
+  /// `entry` has been placed: release the children parked under it
+  void placed(DbEntry entry);
 
-  /// whether nodes_arr is processed and all queues are empty
-  bool canRead();
+  /// park `entry` until its parent is placed
+  void readLater(DbEntry entry);
 
-  /// notify regarding last processed entry
-  void update(bool success);
+  /// nodes parked now / at most at any point
+  size_t parkedCount() const { return parked_count; }
+  size_t maxParked() const { return max_parked; }
 
-  /// put into delayed queue
-  void readLater(DbEntry* delayed);
+  /// longest chain of nodes parked at the same time, each waiting for
+  /// the one above it
+  int maxParkedDepth() const { return max_parked_depth; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -24,78 +24,174 @@
 
 #include <QTcpSocket>
 #include <QMutex>
+#include <QTimer>
+#include <QCoreApplication>
+#include <QEventLoop>
 #include "execution.hh"
+#include "wirecapture.hh"
+#include "nodebatch.hh"
 #include <third-party/json.hpp>
 
-// This is a bit wrong.  We have both a separate thread and
-// asynchronous reading from the socket.  One or the other would
-// suffice.
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <chrono>
 
-ReceiverThread::ReceiverThread(int socketDescriptor, Execution* execution, QObject* parent)
-    : QThread(parent),
-      socketDescriptor(socketDescriptor),
-      execution(execution)
+ExecutionRouter::Attachment ExecutionRouter::findReceiving(int execution_id) {
+    Attachment res;
+    if (execution_id == -1) return res;
+
+    auto it = receiving.find(execution_id);
+    if (it != receiving.end()) {
+        res.execution = it.value();
+        res.source = res.execution->openSource();
+    }
+    return res;
+}
+
+void ExecutionRouter::attach(int execution_id, QObject* context,
+                             std::function<void(const Attachment&)> done) {
+
+    /// NOTE(maxim): executions are used by the GUI, so they must not
+    /// belong to a receiver thread; creating one is queued to the GUI
+    /// thread rather than waited for, with no lock held meanwhile
+    QTimer::singleShot(0, this, [this, execution_id, context, done]() {
+
+        QMutexLocker locker(&mutex);
+
+        /// possibly created by another connection since it was queued
+        Attachment res = findReceiving(execution_id);
+
+        if (!res.execution) {
+            res.execution = new Execution();
+            res.source = res.execution->openSource();
+            res.created = true;
+
+            if (execution_id != -1) {
+                receiving.insert(execution_id, res.execution);
+            }
+        }
+
+        locker.unlock();
+
+        QTimer::singleShot(0, context, [done, res]() { done(res); });
+    });
+}
+
+void ExecutionRouter::detach(const Attachment& attachment) {
+    QMutexLocker locker(&mutex);
+
+    auto ex = attachment.execution;
+
+    /// the last connection of the execution: later ones get a new one
+    if (ex->closeSource(attachment.source)) {
+        auto it = receiving.begin();
+        while (it != receiving.end()) {
+            it = (it.value() == ex) ? receiving.erase(it) : ++it;
+        }
+    }
+}
+
+ReceiverPool::ReceiverPool(ExecutionRouter& router, int thread_count, QObject* parent)
+    : QObject(parent), router(router)
 {
+    qRegisterMetaType<qintptr>("qintptr");
+
+    thread_count = std::max(thread_count, 1);
+
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back(new QThread);
+        threads.back()->start();
+    }
+
+    connections.resize(thread_count, 0);
 }
 
+ReceiverPool::~ReceiverPool() {
+    for (auto& thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
 
-void
-ReceiverThread::run(void) {
-    tcpSocket = new QTcpSocket;
-    if (!tcpSocket->setSocketDescriptor(socketDescriptor)) {
-        std::cerr << "something went wrong setting the socket descriptor\n";
-        abort();
+void ReceiverPool::addConnection(qintptr socketDescriptor) {
+
+    const size_t t = std::min_element(connections.begin(), connections.end()) -
+                     connections.begin();
+
+    auto worker = new ReceiverWorker(router);
+
+    if (GlobalParser::isSet(GlobalParser::capture_option)) {
+        /// one file per connection: <file_name>, <file_name>.1, ...
+        const int n = connection_count++;
+
+        QString capture_path = GlobalParser::value(GlobalParser::capture_option);
+        if (n > 0) capture_path += "." + QString::number(n);
+
+        worker->setCapture(std::unique_ptr<WireCapture>(new WireCapture(capture_path)));
     }
 
-    /// TODO(maxim): memory leak here
-    ReceiverWorker* worker = new ReceiverWorker(tcpSocket, execution);
-    connect(tcpSocket, &QTcpSocket::readyRead, worker, &ReceiverWorker::doRead);
+    worker->moveToThread(threads[t].get());
+    ++connections[t];
 
-    auto conn_1 = std::make_shared<QMetaObject::Connection>();
+    connect(worker, &ReceiverWorker::executionIdReady, this, &ReceiverPool::executionIdReady);
+    connect(worker, &ReceiverWorker::executionStarted, this, &ReceiverPool::executionStarted);
 
-    *conn_1 = connect(worker, &ReceiverWorker::doneReceiving, [this, conn_1]() {
+    connect(worker, &ReceiverWorker::doneReceiving, this, [this, t, worker]() {
         qDebug() << "worker::doneReceiving";
-        QObject::disconnect(*conn_1);
-        emit doneReceiving();
-        quit();
+        --connections[t];
+        worker->deleteLater();
     });
 
-    connect(worker, &ReceiverWorker::executionIdReady, [this](Execution* ex) {
-        emit executionIdReady(ex);
-    });
+    QMetaObject::invokeMethod(worker, "start", Qt::QueuedConnection,
+                              Q_ARG(qintptr, socketDescriptor));
+}
 
-    auto conn_2 = std::make_shared<QMetaObject::Connection>();
+using cpprofiler::Message;
 
-    *conn_2 = connect(worker, &ReceiverWorker::executionStarted, [this, conn_2](Execution* ex) {
+ReceiverWorker::ReceiverWorker(ExecutionRouter& router)
+    : router(router) {}
 
-        /// NOTE(maxim): this can be triggered more than once...
-        connect(this, SIGNAL(doneReceiving()), ex, SIGNAL(doneReceiving()));
-        QObject::disconnect(*conn_2);
-        emit executionStarted(ex);
-    });
+ReceiverWorker::~ReceiverWorker() {
+    if (attached.execution) router.detach(attached);
+}
 
-    // connect(tcpSocket, &QTcpSocket::disconnected, this, &ReceiverThread::doneReceiving);
-    connect(tcpSocket, &QTcpSocket::disconnected, [this]() {
-        qDebug() << "tcpSocket->disconnected";
-        this->doneReceiving();
-    });
+void ReceiverWorker::setCapture(std::unique_ptr<WireCapture> c) {
+    capture = std::move(c);
+}
+
+void ReceiverWorker::start(qintptr socketDescriptor) {
+    tcpSocket = new QTcpSocket(this);
+    if (!tcpSocket->setSocketDescriptor(socketDescriptor)) {
+        std::cerr << "something went wrong setting the socket descriptor\n";
+        finish();
+        return;
+    }
 
+    tcpSocket->setReadBufferSize(SOCKET_BUFFER);
 
-    // connect(tcpSocket, QTcpSocket::disconnected, this, ReceiverThread::quit);
-    connect(tcpSocket, &QTcpSocket::disconnected, [this]() {
-        this->quit();
+    connect(tcpSocket, &QTcpSocket::readyRead, this, &ReceiverWorker::doRead);
+    connect(tcpSocket, &QTcpSocket::disconnected, this, [this]() {
+        qDebug() << "tcpSocket->disconnected";
+        /// reading may have been paused with data still buffered
+        draining = true;
+        doRead();
+        /// otherwise once resumed
+        if (!parked) finish();
     });
-
-    exec();
 }
 
-static int32_t ArrayToInt(const QByteArray& ba) {
+void ReceiverWorker::finish() {
+    if (done) return;
+    done = true;
 
-  const char* p = ba.data();
-  return *(reinterpret_cast<const quint32*>(p));
-}
+    if (attached.execution) {
+        router.detach(attached);
+        attached = ExecutionRouter::Attachment{};
+    }
 
-using cpprofiler::Message;
+    emit doneReceiving();
+}
 
 void ReceiverWorker::handleStartMessage(const Message& msg) {
 
@@ -133,8 +229,36 @@ void ReceiverWorker::handleStartMessage(const Message& msg) {
 
     }
 
-    if (execution_id == -1) {
-        wait_for_name_map = false;
+    if (attached.execution || parked) {
+        std::cerr << "second START on the same connection, ignored\n";
+        return;
+    }
+
+    parked = true;
+
+    router.attach(execution_id, this,
+                  [this, execution_id, execution_name, has_restarts](
+                      const ExecutionRouter::Attachment& attachment) {
+        handleAttached(attachment, execution_id, execution_name, has_restarts);
+    });
+}
+
+void ReceiverWorker::handleAttached(const ExecutionRouter::Attachment& attachment,
+                                    int execution_id, const std::string& execution_name,
+                                    bool has_restarts) {
+    attached = attachment;
+
+    auto execution = attached.execution;
+
+    /// another connection of the same execution has set it up
+    if (!attached.created) {
+        resume();
+        return;
+    }
+
+    /// resumed once the name map is available
+    if (execution_id != -1) {
+        connect(execution, &Execution::execIdKnown, this, &ReceiverWorker::resume);
     }
 
     execution->setExecutionId(execution_id);
@@ -143,30 +267,40 @@ void ReceiverWorker::handleStartMessage(const Message& msg) {
     execution->begin(execution_name, has_restarts);
     emit executionStarted(execution);
 
-    /// Wait for condition variable
-    if (!execution_id_communicated && wait_for_name_map) {
-        QMutex m;
-        m.lock();
-        while (!execution->has_exec_id) {
-            execution->has_exec_id_cond.wait(&m);
-        }
-        execution_id_communicated = true;
-        m.unlock();
-    }
+    /// (has_exec_id may have been set before the connection was made)
+    if (execution_id == -1 || execution->has_exec_id) resume();
+}
+
+void ReceiverWorker::resume() {
+    if (!parked) return;
+    parked = false;
+
+    processBuffer();
+
+    if (!tcpSocket) return;
+
+    doRead();
+
+    /// the solver disconnected while the worker was parked
+    if (draining) finish();
 }
 
 void ReceiverWorker::handleMessage(const Message& msg) {
 
     switch (msg.type()) {
         case cpprofiler::MsgType::NODE:
-            execution->handleNewNode(msg);
+            if (attached.execution) {
+                attached.execution->handleNewNode(attached.source, msg);
+            } else {
+                std::cerr << "node before START, ignored\n";
+            }
         break;
         case cpprofiler::MsgType::START:
             handleStartMessage(msg);
         break;
         case cpprofiler::MsgType::DONE:
-            emit doneReceiving();
             std::cerr << "DONE\n";
+            finish();
         break;
         case cpprofiler::MsgType::RESTART:
             std::cerr << "RESTART\n";
@@ -177,59 +311,118 @@ void ReceiverWorker::handleMessage(const Message& msg) {
 
 }
 
+void ReceiverWorker::handleNodeBatch(const char* payload, size_t size) {
+    if (attached.execution) {
+        attached.execution->handleNodeBatch(attached.source, payload, size);
+    } else {
+        std::cerr << "node batch before START, ignored\n";
+    }
+}
+
 // This function is called whenever there is new data available to be
 // read on the socket.
 void
 ReceiverWorker::doRead()
 {
-    bool can_read_more = true;
+    resume_pending = false;
+    if (done || parked) return;
 
-    while (tcpSocket->bytesAvailable() > 0 || can_read_more) {
+    /// (START parks the worker part way through)
+    while (!parked && tcpSocket->bytesAvailable() > 0) {
 
-        if (tcpSocket->bytesAvailable() > 0) can_read_more = true;
+        if (isBackedUp()) {
+            /// buffered data doesn't trigger `readyRead` again
+            if (!resume_pending) {
+                resume_pending = true;
+                QTimer::singleShot(RESUME_MS, this, &ReceiverWorker::doRead);
+            }
+            return;
+        }
 
-        buffer.append(tcpSocket->readAll());
+        /// read straight into the free space of `buffer`
+        char* dst = buffer.prepare(READ_CHUNK);
+        const qint64 n = tcpSocket->read(dst, READ_CHUNK);
+        if (n <= 0) break;
 
-        if (!size_read) {
+        if (capture) capture->append(dst, static_cast<size_t>(n));
 
-            if (buffer.size() < bytes_read + 4) {
-                can_read_more = false;
-                continue;
-            }
+        buffer.commit(static_cast<size_t>(n));
+        processBuffer();
+    }
+}
 
-            msg_size = ArrayToInt(buffer.mid(bytes_read, 4));
+bool ReceiverWorker::isBackedUp() const {
+    if (draining || !attached.execution) return false;
+    return attached.execution->isBackedUp(attached.source);
+}
 
-            bytes_read += 4;
-            size_read = true;
-            // qDebug() << "size read";
+void ReceiverWorker::feed(const char* data, size_t size) {
+    buffer.append(data, size);
+    processBuffer();
+}
 
-        } else {
+void ReceiverWorker::processBuffer() {
 
-            if (buffer.size() < bytes_read + msg_size) {
-                can_read_more = false;
-                continue;
-            }
+    /// each message is prefixed with its size (4 bytes)
+    while (!parked && buffer.size() >= sizeof(int32_t)) {
+
+        int32_t msg_size;
+        std::memcpy(&msg_size, buffer.data(), sizeof(msg_size));
 
+        if (buffer.size() < sizeof(msg_size) + msg_size) break;
 
-            marshalling.deserialize(buffer.data() + bytes_read, msg_size);
+        char* payload = buffer.data() + sizeof(msg_size);
+
+        if (nodebatch::isBatch(payload, msg_size)) {
+            handleNodeBatch(payload, msg_size);
+        } else {
+            marshalling.deserialize(payload, msg_size);
 
             auto msg = marshalling.get_msg();
 
             handleMessage(msg);
+        }
 
-            bytes_read += msg_size;
-            size_read = false;
-            msg_processed++;
+        buffer.consume(sizeof(msg_size) + msg_size);
+    }
 
-            /// reset the buffer every MSG_PER_BUFFER messages
-            if (msg_processed == MSG_PER_BUFFER) {
-                msg_processed = 0;
-                buffer.remove(0, bytes_read);
-                bytes_read = 0;
-            }
+}
+
+ReplayThread::ReplayThread(const QString& path, bool paced,
+                           ExecutionRouter& router, QObject* parent)
+    : QThread(parent), path(path), paced(paced), router(router) {}
+
+void ReplayThread::run(void) {
+
+    WireCaptureReader reader(path);
+    if (!reader.isValid()) return;
 
-            // qDebug() << "message read";
+    ReceiverWorker worker(router);
+
+    connect(&worker, &ReceiverWorker::executionIdReady, this, &ReplayThread::executionIdReady);
+    connect(&worker, &ReceiverWorker::executionStarted, this, &ReplayThread::executionStarted);
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    QByteArray data;
+    std::chrono::microseconds time;
+    uint64_t total_bytes = 0;
+
+    while (reader.next(data, time)) {
+        if (paced) std::this_thread::sleep_until(begin + time);
+        worker.feed(data.constData(), static_cast<size_t>(data.size()));
+        total_bytes += data.size();
+
+        /// the worker is resumed by events queued to this thread
+        while (worker.isParked()) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
         }
     }
 
+    /// same as the solver disconnecting
+    worker.finish();
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    std::cerr << "Replayed " << total_bytes << " bytes in " << ms << " ms\n";
 }
@@ -25,79 +25,183 @@
 #include <QThread>
 #include <QObject>
 #include <QTcpSocket>
+#include <QMutex>
+#include <QHash>
 
 #include <QDebug>
 #include <iostream>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "submodules/cpp-integration/message.hpp"
+#include "cpprofiler/utils/receive_buffer.hh"
 
 class Execution;
+class IngestSource;
+class WireCapture;
+
+/// Decides which Execution the nodes of a connection go to: connections
+/// announcing the same execution id while it is still receiving share
+/// one, every other connection gets an Execution (and builder) of its own.
+/// Executions are created on the thread the router lives in (GUI).
+class ExecutionRouter : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Attachment {
+    Execution* execution = nullptr;
+    IngestSource* source = nullptr;
+    /// whether the execution was created for this connection
+    bool created = false;
+  };
+
+  /// Any thread; `execution_id` is -1 if the solver didn't send one.
+  /// Never blocks: `done` is called later, on the thread of `context`
+  void attach(int execution_id, QObject* context,
+              std::function<void(const Attachment&)> done);
+
+  /// The connection is done sending
+  void detach(const Attachment& attachment);
+
+ private:
+  QMutex mutex;
 
-class ReceiverThread : public QThread {
+  /// executions still receiving, by the id their solvers announced
+  QHash<int, Execution*> receiving;
+
+  /// Existing execution for `execution_id` if there is one
+  /// (requires `mutex`)
+  Attachment findReceiving(int execution_id);
+};
+
+class ReceiverWorker;
+
+/// Serves solver connections on a fixed pool of threads, each running
+/// an event loop shared by the connections assigned to it
+class ReceiverPool : public QObject {
   Q_OBJECT
 
  public:
-  ReceiverThread(int socketDescriptor, Execution* execution,
-                 QObject* parent = 0);
+  explicit ReceiverPool(ExecutionRouter& router,
+                        int thread_count = QThread::idealThreadCount(),
+                        QObject* parent = 0);
+  ~ReceiverPool();
+
+  /// Start receiving from a new connection on the least busy thread
+  void addConnection(qintptr socketDescriptor);
+
+ signals:
+  void executionIdReady(Execution*);
+  void executionStarted(Execution*);
 
+ private:
+  ExecutionRouter& router;
 
-  int socketDescriptor;
+  std::vector<std::unique_ptr<QThread>> threads;
+  /// open connections per thread
+  std::vector<int> connections;
+  /// for naming capture files
+  int connection_count = 0;
+};
 
-  ~ReceiverThread() = default;
+/// Feeds a stream recorded with `--capture` through ReceiverWorker,
+/// as fast as possible or at the pace it was recorded
+class ReplayThread : public QThread {
+  Q_OBJECT
+
+ public:
+  ReplayThread(const QString& path, bool paced, ExecutionRouter& router,
+               QObject* parent = 0);
 
  signals:
-  void doneReceiving(void);
   void executionIdReady(Execution*);
   void executionStarted(Execution*);
 
  private:
   void run(void) override;
 
-  QByteArray* buffer;
-  QTcpSocket* tcpSocket;
-  int size;
-  Execution* execution = nullptr;
+  QString path;
+  bool paced;
+  ExecutionRouter& router;
 };
 
+/// Decodes the messages of one connection and passes the nodes on to
+/// the builder of the Execution the router attached the connection to
 class ReceiverWorker : public QObject {
   Q_OBJECT
  public:
-  ReceiverWorker(QTcpSocket* socket, Execution* execution)
-      : execution(execution), tcpSocket(socket) {
-  }
+  explicit ReceiverWorker(ExecutionRouter& router);
+  ~ReceiverWorker();
+
+  /// Tee everything read from the socket into `capture`
+  void setCapture(std::unique_ptr<WireCapture> capture);
+
+  /// Process bytes as if they were read from the socket
+  void feed(const char* data, size_t size);
+
+  /// Whether processing is on hold after START (see `parked`)
+  bool isParked() const { return parked; }
 
  signals:
+  /// emitted once, on DONE or when the connection is closed
   void doneReceiving(void);
   void executionIdReady(Execution*);
   void executionStarted(Execution*);
 
  private:
-  Execution* execution;
-  QByteArray buffer;
-  bool size_read = false;
-
-  // size of the following message in bytes
-  int msg_size = 0;
-  /// messages processed since last buffer reset
-  int msg_processed = 0;
-  /// where to read next from
-  int bytes_read = 0;
+  ExecutionRouter& router;
+  ExecutionRouter::Attachment attached;
+  bool done = false;
+
+  /// NOTE(maxim): after START nothing else is processed until the
+  /// connection has an execution and (if it sent an id) the GUI has
+  /// set up its name map; the thread meanwhile serves other connections
+  bool parked = false;
+
+  /// how much to read from the socket at once
+  static constexpr size_t READ_CHUNK = 1 << 20;
+
+  /// NOTE(maxim): the protocol has no way of asking the solver to slow
+  /// down, so backpressure is plain TCP flow control: while the builder
+  /// is behind, the socket is not read from; with a bounded read buffer
+  /// Qt stops reading too and eventually the solver blocks on send
+  static constexpr qint64 SOCKET_BUFFER = 4 * READ_CHUNK;
+  /// how long to wait before trying again while backed up
+  static constexpr int RESUME_MS = 20;
+  bool resume_pending = false;
+  /// the solver has disconnected: read what is left regardless
+  bool draining = false;
+
+  /// Whether reading should pause for the builder to catch up
+  bool isBackedUp() const;
+
+  /// frames are parsed where they were read to
+  utils::ReceiveBuffer buffer{2 * READ_CHUNK};
 
   cpprofiler::MessageMarshalling marshalling;
 
-  /// if false -> next to read is size, otherwise -- message itself
-  /// number of messages per buffer reset
-  static constexpr int MSG_PER_BUFFER = 10000;
+  QTcpSocket* tcpSocket = nullptr;
 
-  QTcpSocket* tcpSocket;
+  std::unique_ptr<WireCapture> capture;
 
-  bool execution_id_communicated = false;
-  /// initialised shortly after execution id is available
-  bool wait_for_name_map = true;
   void handleStartMessage(const cpprofiler::Message& msg);
+  /// The router has found/created the execution for START
+  void handleAttached(const ExecutionRouter::Attachment& attachment, int execution_id,
+                      const std::string& execution_name, bool has_restarts);
+  /// Nodes packed into one frame (see nodebatch.hh)
+  void handleNodeBatch(const char* payload, size_t size);
+  /// Handle every complete message in `buffer`
+  void processBuffer();
  public slots:
+  /// Take over the connection (on the thread the worker lives in)
+  void start(qintptr socketDescriptor);
   void doRead();
   void handleMessage(const cpprofiler::Message& msg);
+  /// No more messages will come: detach from the execution
+  void finish();
+  /// Carry on with the messages received while parked
+  void resume();
 };
 
 #endif
@@ -0,0 +1,535 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+
+#include "tilecache.hh"
+#include "layoutgeneration.hh"
+#include "drawingcursor.hh"
+#include "nodetree.hh"
+#include "cpprofiler/utils/tree_utils.hh"
+
+#include <QPainter>
+#include <QMutex>
+#include <QWaitCondition>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <thread>
+
+#include "libs/perf_helper.hh"
+
+/// The least margin around a tile (tree coordinates): labels reach
+/// further if they are wider (see `LayoutGeneration::labelReach`)
+constexpr int LABEL_MARGIN = 100;
+/// At most this many tiles are kept (64MB), besides those on the screen
+constexpr size_t MAX_TILES = 256;
+
+/// Threads that render tiles; they sleep while there is nothing to
+/// render and are shared by all canvases
+class RenderPool {
+
+    using Job = TileCache::Job;
+
+    std::vector<std::thread> m_workers;
+
+    void work();
+
+public:
+
+    /// Guards everything below, as well as `TileCache::m_done` and
+    /// `TileCache::m_unfinished` of every cache
+    QMutex mutex;
+    QWaitCondition wake;
+    QWaitCondition finished;
+
+    /// urgent jobs first
+    std::deque<std::shared_ptr<Job>> queue;
+    bool stopped = false;
+
+    explicit RenderPool(unsigned threads);
+    ~RenderPool();
+
+    RenderPool(const RenderPool&) = delete;
+    RenderPool& operator=(const RenderPool&) = delete;
+
+    static RenderPool& instance();
+};
+
+RenderPool::RenderPool(unsigned threads) {
+    threads = std::max(1u, threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        m_workers.emplace_back(&RenderPool::work, this);
+    }
+}
+
+RenderPool::~RenderPool() {
+    {
+        QMutexLocker locker(&mutex);
+        stopped = true;
+        wake.wakeAll();
+    }
+    for (auto& worker : m_workers) worker.join();
+}
+
+RenderPool& RenderPool::instance() {
+    static RenderPool pool(std::thread::hardware_concurrency() / 2);
+    return pool;
+}
+
+void RenderPool::work() {
+
+    while (true) {
+
+        std::shared_ptr<Job> job;
+
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.empty() && !stopped) wake.wait(&mutex);
+            if (stopped) return;
+
+            job = queue.front();
+            queue.pop_front();
+        }
+
+        TileCache::render(*job);
+
+        TileCache* cache = job->cache;
+        bool background;
+
+        {
+            QMutexLocker locker(&mutex);
+            job->done = true;
+            background = !job->urgent;
+            if (background) {
+                cache->m_done.push_back(job);
+            } else {
+                --cache->m_unfinished;
+            }
+            finished.wakeAll();
+        }
+
+        if (background) {
+            emit cache->rendered();
+
+            /// only now may the cache be destroyed
+            QMutexLocker locker(&mutex);
+            --cache->m_unfinished;
+            finished.wakeAll();
+        }
+    }
+}
+
+TileCache::TileCache()
+    : m_generation(std::make_shared<LayoutGeneration>()),
+      m_pool(RenderPool::instance()) {}
+
+TileCache::~TileCache() {
+
+    QMutexLocker locker(&m_pool.mutex);
+
+    auto& queue = m_pool.queue;
+    const auto mine = [this](const std::shared_ptr<Job>& job) { return job->cache == this; };
+    m_unfinished -= std::count_if(queue.begin(), queue.end(), mine);
+    queue.erase(std::remove_if(queue.begin(), queue.end(), mine), queue.end());
+
+    while (m_unfinished > 0) m_pool.finished.wait(&m_pool.mutex);
+}
+
+double TileCache::scaleOf(const Key& key) {
+    return key.zoom / 1000.0;
+}
+
+int TileCache::marginOf(const LayoutGeneration& gen) {
+    return std::max(LABEL_MARGIN, gen.labelReach());
+}
+
+QRect TileCache::treeArea(const Key& key, int margin) {
+    const double scale = scaleOf(key);
+    const int left = static_cast<int>(std::floor(key.column * TILE_SIZE / scale));
+    const int top = static_cast<int>(std::floor(key.row * TILE_SIZE / scale));
+    const int side = static_cast<int>(std::ceil(TILE_SIZE / scale)) + 1;
+    return QRect(left - margin, top - margin, side + 2 * margin, side + 2 * margin);
+}
+
+void TileCache::render(Job& job) {
+
+    const double scale = scaleOf(job.key);
+
+    job.image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+    job.image.fill(Qt::white);
+
+    QPainter painter(&job.image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-job.key.column * TILE_SIZE, -job.key.row * TILE_SIZE);
+    painter.scale(scale, scale);
+
+    const QRect area = treeArea(job.key, marginOf(*job.generation));
+    drawGeneration(painter, *job.generation, area, scale, &job.live);
+}
+
+std::shared_ptr<TileCache::Job> TileCache::makeJob(const Key& key, NodeAllocator* na) {
+
+    auto job = std::make_shared<Job>();
+    job->cache = this;
+    job->key = key;
+    job->generation = m_generation;
+
+    const LayoutGeneration& gen = *m_generation;
+
+    /// the nodes `drawGeneration` will draw on the tile
+    gen.visit(treeArea(key, marginOf(gen)), lodMinWidth(scaleOf(key)), [&](int i, bool) {
+        const PlacedNode& n = gen[i];
+        uint16_t flags = n.flags & PlacedNode::INTERACTIVE;
+        if (na != nullptr) {
+            const uint16_t now = PlacedNode::flagsOf(*(*na)[n.gid]) & PlacedNode::INTERACTIVE;
+            if (now != flags) job->live[i] = now;
+            flags = now;
+        }
+        job->drawn.emplace_back(n.gid, flags);
+    });
+
+    return job;
+}
+
+bool TileCache::flagsChanged(const Tile& tile, NodeAllocator& na) {
+    for (const auto& node : tile.drawn) {
+        const uint16_t now = PlacedNode::flagsOf(*na[node.first]) & PlacedNode::INTERACTIVE;
+        if (now != node.second) return true;
+    }
+    return false;
+}
+
+void TileCache::wait() {
+    QMutexLocker locker(&m_pool.mutex);
+    while (m_unfinished > 0) m_pool.finished.wait(&m_pool.mutex);
+}
+
+size_t TileCache::staleCount() const {
+    return std::count_if(m_tiles.begin(), m_tiles.end(),
+                         [](const std::pair<const Key, Tile>& tile) { return tile.second.stale; });
+}
+
+void TileCache::takeRendered() {
+
+    std::vector<std::shared_ptr<Job>> done;
+
+    {
+        QMutexLocker locker(&m_pool.mutex);
+        done.swap(m_done);
+    }
+
+    for (auto& job : done) {
+        auto it = m_tiles.find(job->key);
+        if (it == m_tiles.end()) continue;
+
+        Tile& tile = it->second;
+        tile.pending = false;
+
+        /// the tree changed again meanwhile: still outdated
+        if (job->generation != m_generation) continue;
+
+        tile.image = std::move(job->image);
+        tile.drawn = std::move(job->drawn);
+        tile.stale = false;
+    }
+}
+
+void TileCache::evict() {
+
+    if (m_tiles.size() <= MAX_TILES) return;
+
+    std::vector<std::pair<uint64_t, Key>> unused;
+    for (const auto& tile : m_tiles) {
+        if (tile.second.used != m_repaints) unused.emplace_back(tile.second.used, tile.first);
+    }
+
+    std::sort(unused.begin(), unused.end(),
+              [](const std::pair<uint64_t, Key>& lhs, const std::pair<uint64_t, Key>& rhs) {
+                  return lhs.first < rhs.first;
+              });
+
+    for (size_t i = 0; i < unused.size() && m_tiles.size() > MAX_TILES; ++i) {
+        m_tiles.erase(unused[i].second);
+    }
+}
+
+void TileCache::setGeneration(std::shared_ptr<const LayoutGeneration> generation) {
+
+    const auto before = std::move(m_generation);
+    m_generation = std::move(generation);
+
+    if (m_generation->empty()) {
+        m_tiles.clear();
+        return;
+    }
+
+    const auto areas = m_generation->changedAreas(*before);
+    /// a label may have been removed as well as added
+    const int margin = std::max(marginOf(*before), marginOf(*m_generation));
+
+    for (auto& tile : m_tiles) {
+        if (tile.second.stale) continue;
+        const QRect covered = treeArea(tile.first, margin);
+        for (const auto& area : areas) {
+            if (covered.intersects(area)) {
+                tile.second.stale = true;
+                break;
+            }
+        }
+    }
+}
+
+/// Index of the tile with pixel `pixel` (which may be negative)
+static int tileOf(int pixel) {
+    return pixel >= 0 ? pixel / TileCache::TILE_SIZE
+                      : (pixel + 1) / TileCache::TILE_SIZE - 1;
+}
+
+void TileCache::paint(QPainter& painter, const QPoint& origin, const QRect& area,
+                      double scale, NodeAllocator* na) {
+
+    takeRendered();
+
+    if (m_generation->empty()) return;
+
+    ++m_repaints;
+
+    const int zoom = static_cast<int>(std::lround(scale * 1000));
+    const PlacedNode& root = (*m_generation)[0];
+    const int margin = marginOf(*m_generation);
+
+    /// the part of `area` the tree takes, in pixels from the root
+    const int left = std::max(area.left() - origin.x(),
+        static_cast<int>(std::floor((root.left - margin) * scale)));
+    const int right = std::min(area.right() - origin.x(),
+        static_cast<int>(std::ceil((root.right + margin) * scale)));
+    const int top = std::max(area.top() - origin.y(),
+        static_cast<int>(std::floor(-margin * scale)));
+    const int bottom = std::min(area.bottom() - origin.y(),
+        static_cast<int>(std::ceil(root.bottom * scale)));
+
+    if (left > right || top > bottom) return;
+
+    std::vector<Key> shown;
+    /// never rendered: waited for
+    std::vector<std::shared_ptr<Job>> missing;
+    /// shown as they are meanwhile
+    std::vector<std::shared_ptr<Job>> outdated;
+
+    for (int row = tileOf(top); row <= tileOf(bottom); ++row) {
+        for (int column = tileOf(left); column <= tileOf(right); ++column) {
+            const Key key{zoom, column, row};
+            shown.push_back(key);
+
+            auto it = m_tiles.find(key);
+            if (it == m_tiles.end()) {
+                missing.push_back(makeJob(key, na));
+                missing.back()->urgent = true;
+                continue;
+            }
+
+            Tile& tile = it->second;
+            tile.used = m_repaints;
+            if (tile.pending) continue;
+
+            if (tile.stale || (na != nullptr && flagsChanged(tile, *na))) {
+                tile.pending = true;
+                outdated.push_back(makeJob(key, na));
+            }
+        }
+    }
+
+    {
+        auto& queue = m_pool.queue;
+
+        QMutexLocker locker(&m_pool.mutex);
+        for (auto& job : missing) queue.push_front(job);
+        for (auto& job : outdated) queue.push_back(job);
+        m_unfinished += static_cast<int>(missing.size() + outdated.size());
+        m_pool.wake.wakeAll();
+
+        auto unfinished = [&missing]() {
+            return std::any_of(missing.begin(), missing.end(),
+                               [](const std::shared_ptr<Job>& job) { return !job->done; });
+        };
+
+        /// render along with the threads rather than only wait for them
+        while (unfinished()) {
+            if (!queue.empty() && queue.front()->urgent) {
+                auto job = queue.front();
+                queue.pop_front();
+                locker.unlock();
+                render(*job);
+                locker.relock();
+                job->done = true;
+                --job->cache->m_unfinished;
+                m_pool.finished.wakeAll();
+            } else {
+                m_pool.finished.wait(&m_pool.mutex);
+            }
+        }
+    }
+
+    for (auto& job : missing) {
+        Tile& tile = m_tiles[job->key];
+        tile.image = std::move(job->image);
+        tile.drawn = std::move(job->drawn);
+        tile.used = m_repaints;
+    }
+
+    for (const Key& key : shown) {
+        painter.drawImage(origin + QPoint(key.column * TILE_SIZE, key.row * TILE_SIZE),
+                          m_tiles[key].image);
+    }
+
+    evict();
+}
+
+namespace tilecache {
+
+    constexpr int WIDTH = 1280;
+    constexpr int HEIGHT = 800;
+    constexpr double SCALE = 0.5;
+
+    /// The screen drawn directly (without tiles)
+    static QImage drawn(const LayoutGeneration& gen, const QPoint& origin) {
+
+        QImage image(WIDTH, HEIGHT, QImage::Format_RGB32);
+        image.fill(Qt::white);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(origin);
+        painter.scale(SCALE, SCALE);
+
+        const QRect clip(static_cast<int>(-origin.x() / SCALE), static_cast<int>(-origin.y() / SCALE),
+                         static_cast<int>(WIDTH / SCALE), static_cast<int>(HEIGHT / SCALE));
+        drawGeneration(painter, gen, clip, SCALE, nullptr);
+
+        return image;
+    }
+
+    static QImage painted(TileCache& cache, const QPoint& origin, NodeAllocator* na) {
+
+        QImage image(WIDTH, HEIGHT, QImage::Format_RGB32);
+        image.fill(Qt::white);
+
+        QPainter painter(&image);
+        cache.paint(painter, origin, QRect(0, 0, WIDTH, HEIGHT), SCALE, na);
+
+        return image;
+    }
+
+    static int differentPixels(const QImage& lhs, const QImage& rhs) {
+        int different = 0;
+        for (int y = 0; y < lhs.height(); ++y) {
+            for (int x = 0; x < lhs.width(); ++x) {
+                if (lhs.pixel(x, y) != rhs.pixel(x, y)) ++different;
+            }
+        }
+        return different;
+    }
+
+    /// Tiles must look like the tree drawn directly; after a change only
+    /// the tiles over it may be rendered again, and so must the tiles
+    /// with a node whose flags changed
+    static bool tilesMatch() {
+
+        constexpr int TOLERANCE = WIDTH * HEIGHT / 100;
+
+        NodeTree nt;
+        utils::buildCompleteTree(nt, 100000, {SOLVED, FAILED, FAILED});
+
+        auto& na = nt.getNA();
+        auto* root = nt.getRoot();
+        root->layout(na);
+
+        const auto before = LayoutGeneration::build(root, na, 1);
+
+        /// the bottom rows, in the middle
+        const QPoint origin(WIDTH / 2, HEIGHT - static_cast<int>((*before)[0].bottom * SCALE));
+
+        TileCache cache;
+        cache.setGeneration(before);
+
+        perfHelper.begin("tile cache: first paint (renders all tiles)");
+        QImage image = painted(cache, origin, nullptr);
+        perfHelper.end();
+
+        perfHelper.begin("tile cache: repaint x10 (copies all tiles)");
+        for (int i = 0; i < 10; ++i) image = painted(cache, origin, nullptr);
+        perfHelper.end();
+
+        perfHelper.begin("tile cache: the same drawn directly x10");
+        QImage expected;
+        for (int i = 0; i < 10; ++i) expected = drawn(*before, origin);
+        perfHelper.end();
+
+        if (differentPixels(image, expected) > TOLERANCE) return false;
+
+        /// a leaf of the bottom row in the middle of the screen gets children
+        int leaf = -1;
+        const QRect middle(static_cast<int>(-origin.x() / SCALE) + WIDTH / 4, 0,
+                           static_cast<int>(WIDTH / SCALE) / 2, (*before)[0].bottom);
+        before->visit(middle, 0, [&](int i, bool) {
+            const PlacedNode& n = (*before)[i];
+            if (n.end != i + 1 || !middle.contains(n.x, n.y)) return;
+            if (leaf == -1 || n.y > (*before)[leaf].y) leaf = i;
+        });
+        if (leaf == -1) return false;
+
+        VisualNode* node = na[(*before)[leaf].gid];
+        node->setStatus(BRANCH);
+        utils::addChildren(node, nt, 2);
+        root->layout(na);
+
+        const auto after = LayoutGeneration::build(root, na, 2);
+        cache.setGeneration(after);
+
+        const size_t stale = cache.staleCount();
+        if (stale == 0 || stale == cache.size()) return false;
+
+        painted(cache, origin, &na);
+        cache.wait();
+        image = painted(cache, origin, &na);
+
+        if (cache.staleCount() != 0) return false;
+        if (differentPixels(image, drawn(*after, origin)) > TOLERANCE) return false;
+
+        /// selecting a node shows on the tiles without a new layout
+        node->setMarked(true);
+        painted(cache, origin, &na);
+        cache.wait();
+
+        return differentPixels(painted(cache, origin, &na), image) > 0;
+    }
+
+    void test_module() {
+        if (tilesMatch()) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (tiles differ from the tree drawn directly)\n";
+        }
+    }
+}
@@ -0,0 +1,166 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+
+#ifndef TILECACHE_HH
+#define TILECACHE_HH
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class QPainter;
+class LayoutGeneration;
+class NodeAllocator;
+class RenderPool;
+
+namespace tilecache { void test_module(); }
+
+/// Pictures of a `LayoutGeneration` cut into square tiles, rendered by
+/// threads shared by all canvases (see `RenderPool`) and kept for as long
+/// as they show what the canvas would draw there: panning over the tree only copies images.
+/// A tile is kept across generations unless the tree changed under it
+/// (see `LayoutGeneration::changedAreas`), and across repaints unless the
+/// user changed the flags of a node on it (selection, path etc.). An
+/// outdated tile is shown until it is rendered again in the background;
+/// tiles that were never rendered are rendered (in parallel) before the
+/// repaint completes. Everything but rendering happens on the GUI thread.
+class TileCache : public QObject {
+Q_OBJECT
+
+    friend class RenderPool;
+
+public:
+    /// Side of a tile in pixels
+    static constexpr int TILE_SIZE = 256;
+
+private:
+    struct Key {
+        /// the scale in thousandths
+        int zoom;
+        int column;
+        int row;
+
+        bool operator==(const Key& other) const {
+            return zoom == other.zoom && column == other.column && row == other.row;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return (static_cast<size_t>(key.zoom) * 1000003u +
+                    static_cast<size_t>(key.column)) * 1000003u +
+                   static_cast<size_t>(key.row);
+        }
+    };
+
+    /// A tile to be rendered
+    struct Job {
+        TileCache* cache;
+        Key key;
+        std::shared_ptr<const LayoutGeneration> generation;
+        /// `PlacedNode::INTERACTIVE` flags (by node index) that differ
+        /// from those of the generation
+        std::unordered_map<int, uint16_t> live;
+        /// (gid, interactive flags) of the nodes drawn on the tile
+        std::vector<std::pair<int, uint16_t>> drawn;
+        QImage image;
+        /// the repaint waits for it (rendered first)
+        bool urgent = false;
+        bool done = false;
+    };
+
+    struct Tile {
+        QImage image;
+        std::vector<std::pair<int, uint16_t>> drawn;
+        /// the tree changed under it since it was rendered
+        bool stale = false;
+        /// being rendered again
+        bool pending = false;
+        /// the last repaint that showed it
+        uint64_t used = 0;
+    };
+
+    std::shared_ptr<const LayoutGeneration> m_generation;
+
+    std::unordered_map<Key, Tile, KeyHash> m_tiles;
+    uint64_t m_repaints = 0;
+
+    RenderPool& m_pool;
+
+    /// Guarded by the mutex of the pool:
+    /// rendered in the background, yet to be taken in
+    std::vector<std::shared_ptr<Job>> m_done;
+    /// jobs queued or being rendered
+    int m_unfinished = 0;
+
+    /// Tree coordinates shown by tile `key`, with `margin` around them
+    /// for what is drawn outside of the subtrees (labels)
+    static QRect treeArea(const Key& key, int margin);
+    /// The margin for the tiles of `gen`
+    static int marginOf(const LayoutGeneration& gen);
+    static double scaleOf(const Key& key);
+    static void render(Job& job);
+
+    std::shared_ptr<Job> makeJob(const Key& key, NodeAllocator* na);
+    /// Whether the flags of the nodes on `tile` changed since it was rendered
+    static bool flagsChanged(const Tile& tile, NodeAllocator& na);
+    void takeRendered();
+    void evict();
+
+public:
+    TileCache();
+    /// Drops the tiles queued and waits for those being rendered
+    ~TileCache();
+
+    /// Show \a generation from now on; tiles over the parts of the tree
+    /// that changed since the previous generation become outdated
+    void setGeneration(std::shared_ptr<const LayoutGeneration> generation);
+
+    /// Paint the part \a area (in pixels) of the tree at \a scale, with
+    /// the root (tree coordinates (0, 0)) at \a origin. If \a na
+    /// is given (the caller holds the tree mutex), tiles showing flags
+    /// that have been changed since they were rendered are replaced.
+    void paint(QPainter& painter, const QPoint& origin, const QRect& area,
+               double scale, NodeAllocator* na);
+
+    /// Wait for the tiles being rendered in the background (they are
+    /// taken in by the next `paint`)
+    void wait();
+
+    /// Number of tiles kept
+    size_t size() const { return m_tiles.size(); }
+    /// Number of tiles kept that are outdated
+    size_t staleCount() const;
+
+Q_SIGNALS:
+    /// A tile rendered in the background is ready (emitted by a
+    /// rendering thread)
+    void rendered();
+};
+
+#endif
@@ -0,0 +1,665 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "tracefile.hh"
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include <QTemporaryDir>
+
+#include "libs/perf_helper.hh"
+
+namespace tracefile {
+
+/// NOTE(maxim): columns are written as they are in memory, so this
+/// assumes a little-endian host (x86 and ARM as we build them)
+static_assert(sizeof(NodeUID) == 12, "NodeUID must have no padding");
+
+static const char FILE_MAGIC[8] = {'C', 'P', 'P', 'T', 'R', 'A', 'C', 'E'};
+static const char INDEX_MAGIC[8] = {'C', 'P', 'P', 'T', 'R', 'I', 'D', 'X'};
+
+static constexpr uint32_t makeTag(char a, char b, char c, char d) {
+  return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 |
+         static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+static constexpr uint32_t TAG_STRS = makeTag('S', 'T', 'R', 'S');
+static constexpr uint32_t TAG_NODE = makeTag('N', 'O', 'D', 'E');
+static constexpr uint32_t TAG_INDX = makeTag('I', 'N', 'D', 'X');
+
+static constexpr uint32_t FLAG_RESTARTS = 1;
+
+/// u32:tag u32:items u64:bytes
+static constexpr uint64_t CHUNK_HEADER_BYTES = 16;
+/// u32 tag u32 items u64 offset u64 bytes
+static constexpr uint64_t INDEX_ENTRY_BYTES = 24;
+/// u64:offset "CPPTRIDX"
+static constexpr uint64_t TRAILER_BYTES = 16;
+
+/// bytes per node in the fixed-size columns of a NODE chunk
+static constexpr uint64_t NODE_FIXED_BYTES =
+    2 * sizeof(NodeUID) + 3 * sizeof(int32_t) + sizeof(char) +
+    2 * sizeof(uint64_t) + 3 * sizeof(uint32_t);
+
+template <typename T>
+static void writeValue(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static void writeColumn(std::ostream& out, const std::vector<T>& column) {
+  out.write(reinterpret_cast<const char*>(column.data()),
+            static_cast<std::streamsize>(column.size() * sizeof(T)));
+}
+
+static void writeString(std::ostream& out, const std::string& str) {
+  writeValue(out, static_cast<uint32_t>(str.size()));
+  out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+/// Element `i` of a column starting at `column` (which may be unaligned)
+template <typename T>
+static void loadValue(const char* column, size_t i, T& value) {
+  std::memcpy(&value, column + i * sizeof(T), sizeof(T));
+}
+
+/// Bounds-checked reading from the mapped file
+class PayloadCursor {
+  const char* m_begin;
+  const char* m_pos;
+  const char* m_end;
+  bool m_ok = true;
+
+public:
+  PayloadCursor(const char* data, uint64_t size)
+      : m_begin(data), m_pos(data), m_end(data + size) {}
+
+  bool ok() const { return m_ok; }
+
+  uint64_t offset() const { return static_cast<uint64_t>(m_pos - m_begin); }
+
+  /// pointer to the next `bytes` bytes, nullptr if there are not as many
+  const char* take(uint64_t bytes) {
+    if (!m_ok || static_cast<uint64_t>(m_end - m_pos) < bytes) {
+      m_ok = false;
+      return nullptr;
+    }
+    const char* res = m_pos;
+    m_pos += bytes;
+    return res;
+  }
+
+  template <typename T>
+  void value(T& out) {
+    const char* src = take(sizeof(T));
+    if (src) std::memcpy(&out, src, sizeof(T));
+  }
+
+  void string(std::string& out) {
+    uint32_t len = 0;
+    value(len);
+    const char* src = take(len);
+    if (src) out.assign(src, len);
+  }
+};
+
+/// ********* WRITER **********
+
+Writer::Writer(const std::string& path)
+    : m_out(path, std::ios::out | std::ios::binary | std::ios::trunc) {}
+
+void Writer::writeHeader(const Header& header) {
+  m_out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+  writeValue(m_out, VERSION);
+  writeValue(m_out, header.has_restarts ? FLAG_RESTARTS : uint32_t{0});
+  writeValue(m_out, header.execution_id);
+  writeString(m_out, header.title);
+  writeString(m_out, header.variables);
+  m_header_written = true;
+}
+
+void Writer::beginChunk(uint32_t tag, uint32_t items, uint64_t bytes) {
+  const auto offset = static_cast<uint64_t>(m_out.tellp());
+  writeValue(m_out, tag);
+  writeValue(m_out, items);
+  writeValue(m_out, bytes);
+  m_index.push_back(ChunkInfo{tag, items, offset, bytes});
+}
+
+void Writer::addNode(const NodeRecord& rec) {
+  m_uid.push_back(rec.nodeUID);
+  m_parent_uid.push_back(rec.parentUID);
+  m_alt.push_back(rec.alt);
+  m_kids.push_back(rec.numberOfKids);
+  m_tid.push_back(rec.thread_id);
+  m_status.push_back(rec.status);
+  m_time_stamp.push_back(rec.time_stamp);
+  m_node_time.push_back(rec.node_time);
+  m_label.push_back(static_cast<uint32_t>(m_labels.intern(rec.label)));
+  m_nogood_len.push_back(static_cast<uint32_t>(rec.nogood.size()));
+  m_nogood_bytes += rec.nogood;
+  m_info_len.push_back(static_cast<uint32_t>(rec.info.size()));
+  m_info_bytes += rec.info;
+
+  if (m_uid.size() == CHUNK_NODES) flushNodes();
+}
+
+void Writer::flushNodes() {
+
+  /// labels first seen in this chunk
+  const size_t label_count = m_labels.size();
+  if (label_count > m_labels_written) {
+    uint64_t bytes = 0;
+    for (auto id = m_labels_written; id < label_count; ++id) {
+      bytes += sizeof(uint32_t) + m_labels.get(static_cast<int32_t>(id)).size();
+    }
+    beginChunk(TAG_STRS, static_cast<uint32_t>(label_count - m_labels_written), bytes);
+    for (auto id = m_labels_written; id < label_count; ++id) {
+      writeString(m_out, m_labels.get(static_cast<int32_t>(id)));
+    }
+    m_labels_written = label_count;
+  }
+
+  const size_t n = m_uid.size();
+  if (n == 0) return;
+
+  const uint64_t bytes = n * NODE_FIXED_BYTES + m_nogood_bytes.size() + m_info_bytes.size();
+  beginChunk(TAG_NODE, static_cast<uint32_t>(n), bytes);
+
+  writeColumn(m_out, m_uid);
+  writeColumn(m_out, m_parent_uid);
+  writeColumn(m_out, m_alt);
+  writeColumn(m_out, m_kids);
+  writeColumn(m_out, m_tid);
+  writeColumn(m_out, m_status);
+  writeColumn(m_out, m_time_stamp);
+  writeColumn(m_out, m_node_time);
+  writeColumn(m_out, m_label);
+  writeColumn(m_out, m_nogood_len);
+  writeColumn(m_out, m_info_len);
+  m_out.write(m_nogood_bytes.data(), static_cast<std::streamsize>(m_nogood_bytes.size()));
+  m_out.write(m_info_bytes.data(), static_cast<std::streamsize>(m_info_bytes.size()));
+
+  m_uid.clear();
+  m_parent_uid.clear();
+  m_alt.clear();
+  m_kids.clear();
+  m_tid.clear();
+  m_status.clear();
+  m_time_stamp.clear();
+  m_node_time.clear();
+  m_label.clear();
+  m_nogood_len.clear();
+  m_info_len.clear();
+  m_nogood_bytes.clear();
+  m_info_bytes.clear();
+}
+
+bool Writer::finish() {
+  if (!m_header_written) writeHeader(Header{});
+
+  flushNodes();
+
+  /// the index does not list itself
+  auto entries = m_index;
+  beginChunk(TAG_INDX, static_cast<uint32_t>(entries.size()),
+             entries.size() * INDEX_ENTRY_BYTES);
+  for (const auto& chunk : entries) {
+    writeValue(m_out, chunk.tag);
+    writeValue(m_out, chunk.items);
+    writeValue(m_out, chunk.offset);
+    writeValue(m_out, chunk.bytes);
+  }
+
+  writeValue(m_out, m_index.back().offset);
+  m_out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+  m_out.flush();
+  const bool ok = static_cast<bool>(m_out);
+  m_out.close();
+  return ok;
+}
+
+/// ********* READER **********
+
+Reader::Reader(const std::string& path)
+    : m_file(QString::fromStdString(path)) {}
+
+bool Reader::open(Header& header) {
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    m_error = "can't open the file";
+    return false;
+  }
+
+  m_size = static_cast<uint64_t>(m_file.size());
+  m_data = m_size > 0 ? reinterpret_cast<const char*>(m_file.map(0, m_file.size())) : nullptr;
+  if (!m_data) {
+    m_error = "can't map the file";
+    return false;
+  }
+
+  PayloadCursor cursor(m_data, m_size);
+
+  const char* magic = cursor.take(sizeof(FILE_MAGIC));
+  if (!magic || std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    m_error = "not an execution trace";
+    return false;
+  }
+
+  uint32_t version = 0, flags = 0;
+  cursor.value(version);
+  cursor.value(flags);
+
+  if (cursor.ok() && version > VERSION) {
+    m_error = "trace version " + std::to_string(version) +
+              " is newer than supported (" + std::to_string(VERSION) + ")";
+    return false;
+  }
+
+  cursor.value(header.execution_id);
+  cursor.string(header.title);
+  cursor.string(header.variables);
+
+  if (!cursor.ok()) {
+    m_error = "truncated header";
+    return false;
+  }
+  header.has_restarts = (flags & FLAG_RESTARTS) != 0;
+
+  const uint64_t data_begin = cursor.offset();
+
+  /// a file that was not finished (e.g. the profiler crashed while
+  /// saving) has no index: recover what can be found chunk by chunk
+  if (!readIndex(data_begin)) {
+    std::cerr << "trace has no index, scanning chunks\n";
+    scanChunks(data_begin);
+  }
+
+  m_labels.assign(1, std::string{});
+  m_chunks.clear();
+  m_node_count = 0;
+
+  for (const auto& chunk : m_index) {
+    if (chunk.tag == TAG_STRS) {
+      if (!decodeLabels(chunk)) return false;
+    } else if (chunk.tag == TAG_NODE) {
+      if (!addNodeChunk(chunk)) return false;
+    }
+    /// unknown chunks are skipped so that newer writers can add them
+  }
+
+  if (m_chunks.empty() && m_index.empty()) {
+    m_error = "no readable chunks";
+    return false;
+  }
+
+  header.node_count = m_node_count;
+  return true;
+}
+
+bool Reader::readIndex(uint64_t data_begin) {
+
+  if (m_size < data_begin + CHUNK_HEADER_BYTES + TRAILER_BYTES) return false;
+
+  PayloadCursor trailer(m_data + m_size - TRAILER_BYTES, TRAILER_BYTES);
+  uint64_t index_offset = 0;
+  trailer.value(index_offset);
+  const char* magic = trailer.take(sizeof(INDEX_MAGIC));
+  if (!magic || std::memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+    return false;
+  }
+
+  const uint64_t index_end = m_size - TRAILER_BYTES;
+  if (index_offset < data_begin || index_offset + CHUNK_HEADER_BYTES > index_end) {
+    return false;
+  }
+
+  PayloadCursor cursor(m_data + index_offset, index_end - index_offset);
+
+  uint32_t tag = 0, items = 0;
+  uint64_t bytes = 0;
+  cursor.value(tag);
+  cursor.value(items);
+  cursor.value(bytes);
+  if (!cursor.ok() || tag != TAG_INDX || bytes != items * INDEX_ENTRY_BYTES) {
+    return false;
+  }
+
+  m_index.resize(items);
+  for (auto& chunk : m_index) {
+    cursor.value(chunk.tag);
+    cursor.value(chunk.items);
+    cursor.value(chunk.offset);
+    cursor.value(chunk.bytes);
+    if (!cursor.ok() || chunk.offset < data_begin ||
+        chunk.offset + CHUNK_HEADER_BYTES + chunk.bytes > index_offset) {
+      m_index.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Reader::scanChunks(uint64_t data_begin) {
+
+  m_index.clear();
+
+  uint64_t offset = data_begin;
+  while (offset + CHUNK_HEADER_BYTES <= m_size) {
+    PayloadCursor cursor(m_data + offset, CHUNK_HEADER_BYTES);
+
+    ChunkInfo chunk;
+    chunk.offset = offset;
+    cursor.value(chunk.tag);
+    cursor.value(chunk.items);
+    cursor.value(chunk.bytes);
+
+    if (offset + CHUNK_HEADER_BYTES + chunk.bytes > m_size) break;
+    if (chunk.tag != TAG_NODE && chunk.tag != TAG_STRS) break;
+
+    m_index.push_back(chunk);
+    offset += CHUNK_HEADER_BYTES + chunk.bytes;
+  }
+}
+
+bool Reader::decodeLabels(const ChunkInfo& chunk) {
+  PayloadCursor cursor(m_data + chunk.offset + CHUNK_HEADER_BYTES, chunk.bytes);
+
+  std::string label;
+  for (uint32_t i = 0; i < chunk.items && cursor.ok(); ++i) {
+    cursor.string(label);
+    m_labels.push_back(label);
+  }
+
+  if (!cursor.ok()) {
+    m_error = "corrupt string chunk at " + std::to_string(chunk.offset);
+    return false;
+  }
+  return true;
+}
+
+/// Only checks that the chunk is consistent; nothing is decoded yet
+bool Reader::addNodeChunk(const ChunkInfo& chunk) {
+
+  const uint64_t n = chunk.items;
+  const char* payload = m_data + chunk.offset + CHUNK_HEADER_BYTES;
+  const uint64_t fixed = n * NODE_FIXED_BYTES;
+
+  if (chunk.bytes < fixed) {
+    m_error = "corrupt node chunk at " + std::to_string(chunk.offset);
+    return false;
+  }
+
+  /// the length columns are the last two fixed-size ones
+  PayloadCursor lengths(payload + fixed - 2 * n * sizeof(uint32_t), 2 * n * sizeof(uint32_t));
+  uint64_t nogood_total = 0, info_total = 0;
+  uint32_t len = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    lengths.value(len);
+    nogood_total += len;
+  }
+  for (uint64_t i = 0; i < n; ++i) {
+    lengths.value(len);
+    info_total += len;
+  }
+
+  if (fixed + nogood_total + info_total != chunk.bytes) {
+    m_error = "corrupt node chunk at " + std::to_string(chunk.offset);
+    return false;
+  }
+
+  NodeChunk node_chunk;
+  node_chunk.first = m_node_count;
+  node_chunk.count = chunk.items;
+  node_chunk.columns = payload;
+  node_chunk.nogood_bytes = payload + fixed;
+  node_chunk.info_bytes = payload + fixed + nogood_total;
+  m_chunks.push_back(std::move(node_chunk));
+
+  m_node_count += n;
+  return true;
+}
+
+void Reader::readChunk(size_t c, std::vector<NodeRecord>& out, bool lazy) const {
+
+  const NodeChunk& chunk = m_chunks[c];
+  const size_t n = chunk.count;
+
+  /// column starts, in the order they are written
+  const char* uid = chunk.columns;
+  const char* parent_uid = uid + n * sizeof(NodeUID);
+  const char* alt = parent_uid + n * sizeof(NodeUID);
+  const char* kids = alt + n * sizeof(int32_t);
+  const char* tid = kids + n * sizeof(int32_t);
+  const char* status = tid + n * sizeof(int32_t);
+  const char* time_stamp = status + n * sizeof(char);
+  const char* node_time = time_stamp + n * sizeof(uint64_t);
+  const char* label = node_time + n * sizeof(uint64_t);
+  const char* nogood_len = label + n * sizeof(uint32_t);
+  const char* info_len = nogood_len + n * sizeof(uint32_t);
+
+  const char* nogood_bytes = chunk.nogood_bytes;
+  const char* info_bytes = chunk.info_bytes;
+
+  out.reserve(out.size() + n);
+
+  for (size_t i = 0; i < n; ++i) {
+    NodeRecord rec;
+    loadValue(uid, i, rec.nodeUID);
+    loadValue(parent_uid, i, rec.parentUID);
+    loadValue(alt, i, rec.alt);
+    loadValue(kids, i, rec.numberOfKids);
+    loadValue(tid, i, rec.thread_id);
+    loadValue(status, i, rec.status);
+    loadValue(time_stamp, i, rec.time_stamp);
+    loadValue(node_time, i, rec.node_time);
+
+    uint32_t label_id;
+    loadValue(label, i, label_id);
+    if (label_id >= m_labels.size()) label_id = 0;
+
+    if (lazy) {
+      rec.label_id = static_cast<int32_t>(label_id);
+    } else {
+      uint32_t ng_len, info_size;
+      loadValue(nogood_len, i, ng_len);
+      loadValue(info_len, i, info_size);
+
+      rec.label = m_labels[label_id];
+      rec.nogood.assign(nogood_bytes, ng_len);
+      rec.info.assign(info_bytes, info_size);
+      nogood_bytes += ng_len;
+      info_bytes += info_size;
+    }
+
+    out.push_back(std::move(rec));
+  }
+}
+
+const Reader::NodeChunk& Reader::chunkOf(uint64_t node) const {
+  auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), node,
+      [](uint64_t n, const NodeChunk& chunk) { return n < chunk.first; });
+  return *(it - 1);
+}
+
+std::string Reader::nodeString(uint64_t node, bool nogood) const {
+
+  if (node >= m_node_count) return {};
+
+  const NodeChunk& chunk = chunkOf(node);
+  const size_t n = chunk.count;
+  const size_t i = node - chunk.first;
+
+  const char* lengths = chunk.columns + n * (NODE_FIXED_BYTES - 2 * sizeof(uint32_t));
+  if (!nogood) lengths += n * sizeof(uint32_t);
+
+  uint32_t len;
+  loadValue(lengths, i, len);
+  if (len == 0) return {};
+
+  auto& offsets = nogood ? chunk.nogood_offsets : chunk.info_offsets;
+
+  uint32_t offset;
+  {
+    std::lock_guard<std::mutex> lock(m_offsets_mutex);
+    if (offsets.empty()) {
+      offsets.resize(n);
+      uint32_t sum = 0;
+      for (size_t j = 0; j < n; ++j) {
+        offsets[j] = sum;
+        uint32_t l;
+        loadValue(lengths, j, l);
+        sum += l;
+      }
+    }
+    offset = offsets[i];
+  }
+
+  const char* bytes = nogood ? chunk.nogood_bytes : chunk.info_bytes;
+  return std::string(bytes + offset, len);
+}
+
+/// ********* TESTS **********
+
+static NodeRecord makeTestNode(int32_t i) {
+  NodeRecord rec;
+  rec.nodeUID = NodeUID{i, i % 3, i % 5 - 1};
+  rec.parentUID = NodeUID{i / 2, i % 3, i % 5 - 1};
+  rec.alt = i % 2;
+  rec.numberOfKids = i % 3 == 0 ? 0 : 2;
+  rec.thread_id = i % 5 - 1;
+  rec.status = static_cast<char>(i % 7);
+  rec.time_stamp = static_cast<uint64_t>(i) * 3;
+  rec.node_time = 3;
+  rec.label = "x" + std::to_string(i % 100) + "=" + std::to_string(i % 7);
+  if (i % 11 == 0) rec.nogood = "x1<=" + std::to_string(i) + " y>2";
+  if (i % 13 == 0) rec.info = "{\"objective\": " + std::to_string(i) + "}";
+  return rec;
+}
+
+static bool sameNode(const NodeRecord& a, const NodeRecord& b) {
+  return a.nodeUID == b.nodeUID && a.parentUID == b.parentUID && a.alt == b.alt &&
+         a.numberOfKids == b.numberOfKids && a.thread_id == b.thread_id &&
+         a.status == b.status && a.time_stamp == b.time_stamp &&
+         a.node_time == b.node_time && a.label == b.label &&
+         a.nogood == b.nogood && a.info == b.info;
+}
+
+/// Write `n` nodes, read them back and compare
+static bool roundTrip(const std::string& path, int32_t n, bool truncate) {
+
+  Header header;
+  header.title = "round trip";
+  header.variables = "x y z";
+  header.has_restarts = true;
+  header.execution_id = 42;
+
+  {
+    Writer writer(path);
+    writer.writeHeader(header);
+    for (int32_t i = 0; i < n; ++i) writer.addNode(makeTestNode(i));
+    if (!writer.finish()) return false;
+  }
+
+  if (truncate) {
+    /// chop off the index, as if the writer never finished
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size() - 40));
+  }
+
+  Reader reader(path);
+  Header loaded;
+  if (!reader.open(loaded)) {
+    std::cerr << reader.error() << "\n";
+    return false;
+  }
+
+  if (loaded.title != header.title || loaded.variables != header.variables ||
+      loaded.has_restarts != header.has_restarts ||
+      loaded.execution_id != header.execution_id ||
+      loaded.node_count != static_cast<uint64_t>(n)) {
+    return false;
+  }
+
+  std::vector<NodeRecord> nodes;
+  int32_t next = 0;
+  for (size_t c = 0; c < reader.chunkCount(); ++c) {
+    nodes.clear();
+    reader.readChunk(c, nodes, false);
+    for (auto& rec : nodes) {
+      if (!sameNode(rec, makeTestNode(next++))) return false;
+    }
+  }
+
+  if (next != n) return false;
+
+  /// lazily: strings come from the label table and by ordinal
+  next = 0;
+  for (size_t c = 0; c < reader.chunkCount(); ++c) {
+    nodes.clear();
+    reader.readChunk(c, nodes, true);
+    for (auto& rec : nodes) {
+      if (rec.label_id < 0 || !rec.label.empty()) return false;
+      rec.label = reader.labels()[rec.label_id];
+      rec.nogood = reader.nogood(next);
+      rec.info = reader.info(next);
+      if (!sameNode(rec, makeTestNode(next++))) return false;
+    }
+  }
+
+  return next == n;
+}
+
+void test_module() {
+
+  /// removed along with the trace when the test is done
+  QTemporaryDir dir;
+  if (!dir.isValid()) {
+    std::cerr << "test did NOT pass! (no temporary directory for the trace)\n";
+    return;
+  }
+
+  const std::string path = (dir.path() + "/test.cpptrace").toStdString();
+
+  perfHelper.begin("trace file: write and read 300K nodes twice");
+  const bool passed = roundTrip(path, 300000, false);
+  perfHelper.end();
+
+  if (passed) {
+    std::cerr << "test passed!\n";
+  } else {
+    std::cerr << "test did NOT pass! (trace round trip)\n";
+  }
+
+  if (roundTrip(path, 1000, true)) {
+    std::cerr << "test passed!\n";
+  } else {
+    std::cerr << "test did NOT pass! (trace without index)\n";
+  }
+}
+
+}
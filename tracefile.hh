@@ -0,0 +1,187 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef TRACEFILE_HH
+#define TRACEFILE_HH
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+
+#include <QFile>
+
+#include "nodestore.hh"
+
+/// On-disk format of a saved execution (all integers little-endian):
+///
+///   header:  "CPPTRACE" u32:version u32:flags i32:execution_id
+///            str:title str:variables            (str = u32:length bytes)
+///   chunks:  u32:tag u32:items u64:payload_bytes payload
+///            STRS -- label strings, appended to the file's string table
+///            NODE -- `items` nodes, one column after another:
+///                    uid[] parent_uid[] alt[] kids[] tid[] status[]
+///                    time_stamp[] node_time[] label_id[] nogood_len[]
+///                    info_len[] nogood_bytes info_bytes
+///            INDX -- footer: per chunk u32:tag u32:items u64:offset u64:bytes
+///   trailer: u64:offset_of_INDX "CPPTRIDX"
+///
+/// Labels repeat a lot and are interned; nogoods and info are mostly
+/// unique and stored inline with their chunk.
+namespace tracefile {
+
+  void test_module();
+
+  constexpr uint32_t VERSION = 1;
+
+  struct Header {
+    std::string title;
+    std::string variables;
+    bool has_restarts = false;
+    int32_t execution_id = -1;
+    /// filled in by the reader
+    uint64_t node_count = 0;
+  };
+
+  /// Entry of the index footer
+  struct ChunkInfo {
+    uint32_t tag;
+    uint32_t items;
+    /// where the chunk header starts
+    uint64_t offset;
+    /// payload size (excluding the header)
+    uint64_t bytes;
+  };
+
+  /// Streams nodes into a file, one chunk per `CHUNK_NODES` nodes
+  class Writer {
+
+    static constexpr size_t CHUNK_NODES = 1 << 16;
+
+    std::ofstream m_out;
+    bool m_header_written = false;
+
+    /// ids of labels written so far (0 is the empty string)
+    utils::StringPool m_labels;
+    size_t m_labels_written = 1;
+
+    /// columns of the chunk being filled
+    std::vector<NodeUID> m_uid;
+    std::vector<NodeUID> m_parent_uid;
+    std::vector<int32_t> m_alt;
+    std::vector<int32_t> m_kids;
+    std::vector<int32_t> m_tid;
+    std::vector<char> m_status;
+    std::vector<uint64_t> m_time_stamp;
+    std::vector<uint64_t> m_node_time;
+    std::vector<uint32_t> m_label;
+    std::vector<uint32_t> m_nogood_len;
+    std::vector<uint32_t> m_info_len;
+    std::string m_nogood_bytes;
+    std::string m_info_bytes;
+
+    std::vector<ChunkInfo> m_index;
+
+    void beginChunk(uint32_t tag, uint32_t items, uint64_t bytes);
+    void flushNodes();
+
+  public:
+
+    explicit Writer(const std::string& path);
+
+    bool isOpen() const { return m_out.is_open(); }
+
+    void writeHeader(const Header& header);
+
+    void addNode(const NodeRecord& rec);
+
+    /// Write the remaining nodes and the index; false on I/O error
+    bool finish();
+  };
+
+  /// Read-only view of a file produced by `Writer`, mapped into memory.
+  /// Node columns are decoded straight from the mapping; nogoods and
+  /// info stay in the file until asked for by the node's ordinal
+  /// (its position in the file). Safe to share between threads.
+  class Reader {
+
+    struct NodeChunk {
+      uint64_t first;     /// ordinal of the first node
+      uint32_t count;
+      const char* columns;
+      const char* nogood_bytes;
+      const char* info_bytes;
+      /// where each node's nogood/info starts; built on first use
+      mutable std::vector<uint32_t> nogood_offsets;
+      mutable std::vector<uint32_t> info_offsets;
+    };
+
+    QFile m_file;
+    const char* m_data = nullptr;
+    uint64_t m_size = 0;
+
+    std::string m_error;
+
+    std::vector<ChunkInfo> m_index;
+    std::vector<NodeChunk> m_chunks;
+    std::vector<std::string> m_labels;
+    uint64_t m_node_count = 0;
+
+    mutable std::mutex m_offsets_mutex;
+
+    bool readIndex(uint64_t data_begin);
+    void scanChunks(uint64_t data_begin);
+    bool decodeLabels(const ChunkInfo& chunk);
+    bool addNodeChunk(const ChunkInfo& chunk);
+
+    const NodeChunk& chunkOf(uint64_t node) const;
+    std::string nodeString(uint64_t node, bool nogood) const;
+
+  public:
+
+    explicit Reader(const std::string& path);
+
+    /// Map the file, read the header, the index and the label table;
+    /// false (see `error()`) if this is not a trace this version understands
+    bool open(Header& header);
+
+    const std::string& error() const { return m_error; }
+
+    uint64_t nodeCount() const { return m_node_count; }
+
+    size_t chunkCount() const { return m_chunks.size(); }
+
+    /// All labels of the trace, indexed by `NodeRecord::label_id`
+    const std::vector<std::string>& labels() const { return m_labels; }
+
+    /// Append the nodes of chunk `c` to `out`; if `lazy`, only fixed-size
+    /// fields are decoded and labels are given by id (see `labels()`)
+    void readChunk(size_t c, std::vector<NodeRecord>& out, bool lazy) const;
+
+    /// Nogood/info of the node at `ordinal` (empty if none)
+    std::string nogood(uint64_t ordinal) const { return nodeString(ordinal, true); }
+    std::string info(uint64_t ordinal) const { return nodeString(ordinal, false); }
+  };
+
+}
+
+#endif // TRACEFILE_HH
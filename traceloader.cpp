@@ -0,0 +1,67 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "traceloader.hh"
+#include "execution.hh"
+#include "data.hh"
+
+#include <iostream>
+#include <chrono>
+
+TraceLoader::TraceLoader(const std::string& path, QObject* parent)
+    : QThread(parent), reader(std::make_shared<tracefile::Reader>(path)) {}
+
+bool TraceLoader::open(tracefile::Header& header) {
+  return reader->open(header);
+}
+
+void TraceLoader::load(Execution* ex) {
+  execution = ex;
+  execution->getData().attachTrace(reader);
+  source = execution->openSource();
+  start();
+}
+
+void TraceLoader::run(void) {
+
+  auto& data = execution->getData();
+
+  auto begin = std::chrono::system_clock::now();
+  uint64_t count = 0;
+
+  /// NOTE(maxim): the ingest queue blocks us whenever the builder
+  /// falls behind, so this never holds more than one chunk
+  std::vector<NodeRecord> chunk;
+  for (size_t c = 0; c < reader->chunkCount(); ++c) {
+    chunk.clear();
+    reader->readChunk(c, chunk, true);
+    for (auto& rec : chunk) {
+      data.handleNodeRecord(source, std::move(rec));
+    }
+    count += chunk.size();
+  }
+
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now() - begin).count();
+  std::cerr << "Nodes loaded: " << count << " in " << ms << " ms\n";
+
+  execution->closeSource(source);
+}
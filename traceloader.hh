@@ -0,0 +1,60 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef TRACE_LOADER_HH
+#define TRACE_LOADER_HH
+
+#include <QThread>
+#include <string>
+#include <memory>
+
+#include "tracefile.hh"
+
+class Execution;
+class IngestSource;
+
+/// Feeds the nodes of a saved execution to its Data from a separate
+/// thread, the same way ReceiverWorker does for a live solver.
+/// Only the node columns are decoded; Data reads nogoods and info
+/// from the mapped file when they are asked for
+class TraceLoader : public QThread {
+  Q_OBJECT
+
+ public:
+  TraceLoader(const std::string& path, QObject* parent = 0);
+
+  /// Map the file and read the header; false if it can't be loaded
+  bool open(tracefile::Header& header);
+
+  const std::string& error() const { return reader->error(); }
+
+  /// Start feeding the nodes to `execution` (must have begun)
+  void load(Execution* execution);
+
+ private:
+  void run(void) override;
+
+  std::shared_ptr<tracefile::Reader> reader;
+  Execution* execution = nullptr;
+  IngestSource* source = nullptr;
+};
+
+#endif
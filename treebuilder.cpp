@@ -25,6 +25,15 @@
 #include "readingQueue.hh"
 #include "nodetree.hh"
 #include <cassert>
+#include <chrono>
+
+/// Maximum number of decoded nodes committed to Data in one go
+static constexpr size_t INGEST_BATCH = 4096;
+
+/// A batch of placements holds the tree/layout locks for at most
+/// this many nodes or this long, whichever comes first
+static constexpr int BUILD_BATCH = 4096;
+static constexpr auto BUILD_BATCH_TIME = std::chrono::milliseconds(20);
 
 TreeBuilder::TreeBuilder(Execution* exec, QObject* parent)
     : QThread(parent),
@@ -37,14 +46,18 @@ TreeBuilder::TreeBuilder(Execution* exec, QObject* parent)
 
 TreeBuilder::~TreeBuilder() {}
 
-bool TreeBuilder::processRoot(DbEntry& dbEntry) {
-  QMutexLocker locker(&execution.getTreeMutex());
-  QMutexLocker layoutLocker(&execution.getLayoutMutex());
+void TreeBuilder::markDirty(VisualNode& node) {
+  node.setDirty(true);
+  if (!node.isRoot()) {
+    dirty_parents.push_back(node.getParent(_na));
+  }
+}
 
+bool TreeBuilder::processRoot(DbEntry dbEntry) {
   Statistics& stats = execution.getStatistics();
 
   stats.choices++;
-  stats.undetermined += dbEntry.numberOfKids;
+  stats.undetermined += dbEntry.numberOfKids();
 
   // can be a real root, or one of initial nodes in restarts
   VisualNode* root = nullptr;
@@ -65,68 +78,50 @@ bool TreeBuilder::processRoot(DbEntry& dbEntry) {
     // The "super root" is effectively a branch node.
     (_na)[0]->setStatus(BRANCH);
 
-    dbEntry.gid = restart_root;
-    dbEntry.depth = 2;
+    _data.assignGid(dbEntry.aid(), restart_root, 2);
   } else {
     root = (_na)[0];  // use the root that is already there
     if (root->getStatus() != UNDETERMINED) {
       std::cout << dbEntry << std::endl;
       return true;
     }
-    dbEntry.gid = 0;
-    dbEntry.depth = 1;
+    _data.assignGid(dbEntry.aid(), 0, 1);
   }
 
-  auto& gid2entry = _data.gid2entry;
-  gid2entry[dbEntry.gid] = &dbEntry;
-
   /// setNumberOfChildren
-  root->setNumberOfChildren(dbEntry.numberOfKids, _na);
+  root->setNumberOfChildren(dbEntry.numberOfKids(), _na);
   root->setStatus(BRANCH);
   root->setHasSolvedChildren(false);
   root->setHasOpenChildren(true);
 
-  root->dirtyUp(_na);
+  markDirty(*root);
 
-  emit addedRoot();
-  emit addedNode();
+  root_added = true;
 
   return true;
 }
 
-bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
-  QMutexLocker locker(&execution.getTreeMutex());
-  QMutexLocker layoutLocker(&execution.getLayoutMutex());
-
-  NodeUID p_uid = dbEntry.parentUID;  /// parent ID as it comes from Solver
-  int alt = dbEntry.alt;             /// which alternative the current node is
-  int nalt = dbEntry.numberOfKids;   /// number of kids in current node
-  char status = dbEntry.status;
+bool TreeBuilder::processNode(DbEntry dbEntry) {
+  NodeUID p_uid = dbEntry.parentUID();  /// parent ID as it comes from Solver
+  int alt = dbEntry.alt();             /// which alternative the current node is
+  int nalt = dbEntry.numberOfKids();   /// number of kids in current node
+  char status = dbEntry.status();
 
   /// find out if node exists
-  auto pid_it = _data.uid2aid.find(p_uid);
-
-  if (pid_it == _data.uid2aid.end()) {
-    if (!is_delayed) {
-      read_queue->readLater(&dbEntry);
-    }
+  const int32_t parent_aid = _data.uid2aid.get(p_uid);
 
+  if (parent_aid == -1) {
+    read_queue->readLater(dbEntry);
     return false;
   }
 
-  const DbEntry& parentEntry = *_data.getEntries().at(pid_it->second);
+  const DbEntry parentEntry{&_data.getEntries(), parent_aid};
   /// parent ID as it is in Node Allocator (Gist)
-  int parent_gid = parentEntry.gid;
+  int parent_gid = parentEntry.gid();
 
   /// put delayed also if parent node hasn't been processed yet:
   if (parent_gid == -1) {
-
-    if (!is_delayed)
-      read_queue->readLater(&dbEntry);
-    else {
-      // qDebug() << "node already in the queue";
-    }
-
+    read_queue->readLater(dbEntry);
     return false;
   }
 
@@ -136,7 +131,7 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
 #ifdef MAXIM_DEBUG
     std::cerr << "can't parse node" << dbEntry;
 #endif
-    ignored_entries.push_back(&dbEntry);
+    ignored_entries.push_back(dbEntry);
     return false;
   }
 
@@ -156,8 +151,8 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
     int gid = node.getIndex(_na);  // node ID as it is in Gist
 
     /// fill in empty fields of dbEntry
-    dbEntry.gid = gid;
-    dbEntry.depth = parentEntry.depth + 1;  /// parent's depth + 1
+    const int depth = parentEntry.depth() + 1;  /// parent's depth + 1
+    _data.assignGid(dbEntry.aid(), gid, depth);
 
     // For now, assume that the solver sends the decision level.
 
@@ -169,15 +164,9 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
     // dbEntry.decisionLevel =
     //     parentEntry.decisionLevel + (thisIsRightmost ? 0 : 1);
 
-    _data.gid2entry[gid] = &dbEntry;
-
-    stats.maxDepth = std::max(stats.maxDepth, static_cast<int>(dbEntry.depth));
+    stats.maxDepth = std::max(stats.maxDepth, depth);
 
-    /// NOTE: don't distinguish between -1 and 0
-    /// -1 is the default for Chuffed and 0 -- for Gecode
-    if (dbEntry.thread_id == -1) { dbEntry.thread_id = 0; }
-
-    node._tid = dbEntry.thread_id;  /// TODO: tid should be in node's flags
+    node._tid = dbEntry.threadId();  /// TODO: tid should be in node's flags
 
     node.setNumberOfChildren(nalt, _na);
 
@@ -220,8 +209,7 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
         break;
     }
 
-    node.dirtyUp(_na);
-    emit addedNode();
+    markDirty(node);
     // std::cerr << "TreeBuilder::processNode, normal case\n";
   } else {
     /// Not normal cases:
@@ -249,12 +237,11 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
           assert(status != SOLVED);
           break;
       }
-      node.dirtyUp(_na);
-      emit addedNode();
+      markDirty(node);
       // std::cerr << "TreeBuilder::processNode, not-normal case\n";
     } else {
       // assert(status == SKIPPED);
-      ignored_entries.push_back(&dbEntry);
+      ignored_entries.push_back(dbEntry);
       /// sometimes branch wants to override branch
     }
   }
@@ -262,6 +249,48 @@ bool TreeBuilder::processNode(DbEntry& dbEntry, bool is_delayed) {
   return true;
 }
 
+int TreeBuilder::placeBatch(int& budget) {
+
+  QMutexLocker locker(&execution.getTreeMutex());
+  QMutexLocker layoutLocker(&execution.getLayoutMutex());
+
+  const auto deadline = std::chrono::steady_clock::now() + BUILD_BATCH_TIME;
+
+  int placed = 0;
+
+  for (int count = 0; budget > 0 && count < BUILD_BATCH && read_queue->canRead(); ++count) {
+
+    /// reading the clock for every node would cost more than the node
+    if ((count & 255) == 255 && std::chrono::steady_clock::now() > deadline) break;
+
+    --budget;
+
+    DbEntry entry = read_queue->next();
+
+    bool isRoot = (entry.parentUID().nid == -1) ? true : false;
+
+    /// try to put node into the tree (or have it wait for its parent)
+    bool success = isRoot ? processRoot(entry) : processNode(entry);
+
+    if (success) {
+      read_queue->placed(entry);
+      ++placed;
+    }
+  }
+
+  /// siblings share ancestors: dirtyUp stops at the first one that
+  /// is already dirty, so each path is walked about once per batch
+  for (auto parent : dirty_parents) {
+    parent->dirtyUp(_na);
+  }
+  dirty_parents.clear();
+
+  /// statuses of existing (undetermined) nodes have changed
+  if (placed > 0) execution.nodeTree().thaw();
+
+  return placed;
+}
+
 void TreeBuilder::run() {
 
   perf_helper::Timer timer;
@@ -269,39 +298,58 @@ void TreeBuilder::run() {
 
   QMutex& dataMutex = _data.dataMutex;
 
-  bool is_delayed;
-
   while (true) {
 
-    dataMutex.lock();
-    /// check if done
-    if (!read_queue->canRead()) {
-      dataMutex.unlock();
+    _data.commitPendingNodes(INGEST_BATCH);
 
-      if (_data.isDone()) {
+    if (!read_queue->canRead()) {
+      /// check if done (any pending nodes must be committed first)
+      if (_data.isDone() && !_data.hasPendingNodes()) {
         break;
       }
-      /// can't read, but receiving not done, waiting...
-      msleep(1);
+      /// nothing new to read, but receiving not done: wait for the receiver
+      if (!_data.hasPendingNodes()) {
+        _data.waitForNodes();
+      }
       continue;
     }
 
-    /// ask queue for an entry, note: is_delayed gets assigned here
-    DbEntry* entry = read_queue->next(is_delayed);
+    /// process what is readable now, then go back to the receiver:
+    /// children released during the round wait for the next one
+    int budget = read_queue->pending();
+    while (budget > 0 && read_queue->canRead()) {
 
-    bool isRoot = (entry->parentUID.nid == -1) ? true : false;
+      dataMutex.lock();
+      const int batch_placed = placeBatch(budget);
+      dataMutex.unlock();
 
-    /// try to put node into the tree
-    bool success = isRoot ? processRoot(*entry) : processNode(*entry, is_delayed);
-    read_queue->update(success);
+      if (batch_placed > 0) {
+        const quint64 first = _data.nodesPlaced();
+        _data.notifyPlaced(batch_placed);
+        emit addedNodes(first, first + batch_placed);
+      }
 
-    dataMutex.unlock();
+      if (root_added) {
+        root_added = false;
+        emit addedRoot();
+      }
+    }
   }
 
   emit doneBuilding(true);
 
   auto elapsed_ms = timer.end();
   std::cout << "Time elapsed: " << elapsed_ms << "ms\n";
+
+  if (elapsed_ms > 0) {
+    std::cout << "Nodes placed: " << _data.nodesPlaced() << " ("
+              << _data.nodesPlaced() * 1000 / elapsed_ms << " nodes/s)\n";
+  }
+
+  std::cout << "Nodes waiting for parent: at most " << read_queue->maxParked()
+            << " (chains up to " << read_queue->maxParkedDepth() << " deep), "
+            << read_queue->parkedCount() << " never placed\n";
+
   if (GlobalParser::isSet(GlobalParser::test_option)) {
     qDebug() << "test mode, terminate";
     qApp->exit();
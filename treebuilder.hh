@@ -35,6 +35,7 @@ class Execution;
 class ReadingQueue;
 class TreeCanvas;
 class NodeAllocator;
+class VisualNode;
 
 enum NodeStatus : char;
 
@@ -46,12 +47,27 @@ class TreeBuilder : public QThread {
   Data& _data; /// Note: mutable as builder changes dbEntries
   NodeAllocator& _na;
 
-  std::vector<DbEntry*> ignored_entries;
+  std::vector<DbEntry> ignored_entries;
 
   std::unique_ptr<ReadingQueue> read_queue;
 
-  bool processRoot(DbEntry& dbEntry);
-  bool processNode(DbEntry& dbEntry, bool is_delayed);
+  /// Parents of nodes changed in the current batch, whose ancestors
+  /// are marked dirty once at the end of the batch
+  std::vector<VisualNode*> dirty_parents;
+
+  /// Whether a root was added in the current batch
+  bool root_added = false;
+
+  /// Place up to `budget` nodes from `read_queue` under a single
+  /// acquisition of the tree/layout locks; returns the number placed
+  int placeBatch(int& budget);
+
+  /// Mark `node` dirty now and its ancestors at the end of the batch
+  void markDirty(VisualNode& node);
+
+  /// Caller must hold the tree and layout mutexes
+  bool processRoot(DbEntry dbEntry);
+  bool processNode(DbEntry dbEntry);
 
   void run() override;
 
@@ -61,7 +77,8 @@ class TreeBuilder : public QThread {
 
 Q_SIGNALS:
   void doneBuilding(bool finished);
-  void addedNode(void);
+  /// Nodes [first, last) in placement order were added to the tree
+  void addedNodes(quint64 first, quint64 last);
   void addedRoot(void);
 };
 
@@ -38,13 +38,15 @@
 #include "node_info_dialog.hh"
 #include "libs/perf_helper.hh"
 
-#include "third-party/json.hpp"
 
 #include "data.hh"
 
 #include "nodevisitor.hh"
 #include "visualnode.hh"
 #include "drawingcursor.hh"
+#include "layoutgeneration.hh"
+#include "layoutworker.hh"
+#include "tilecache.hh"
 #include "cpprofiler/analysis/backjumps.hh"
 
 #include "ml-stats.hh"
@@ -64,6 +66,9 @@
 
 using namespace cpprofiler::analysis;
 
+/// How soon a selection is tried again if the builder holds the tree
+constexpr int RUBBER_RETRY_MS = 20;
+
 static QAbstractScrollArea* makeScrollArea(TreeCanvas* tc) {
 
   auto sa = new QAbstractScrollArea;
@@ -101,6 +106,17 @@ TreeCanvas::TreeCanvas(Execution* e)
 
   root = execution.nodeTree().getRoot();
 
+  m_layoutWorker.reset(new LayoutWorker(execution.nodeTree()));
+  m_layout = m_layoutWorker->latest();
+  connect(m_layoutWorker.get(), &LayoutWorker::published, this, &TreeCanvas::layoutPublished);
+  m_layoutWorker->start();
+
+  m_tiles.reset(new TileCache());
+  m_tiles->setGeneration(m_layout);
+  connect(m_tiles.get(), &TileCache::rendered, this, [this]() {
+    QWidget::update();
+  });
+
   setAutoFillBackground(true);
 
   m_scrollArea = makeScrollArea(this);
@@ -112,7 +128,7 @@ TreeCanvas::TreeCanvas(Execution* e)
     QWidget::update();
   });
 
-  connect(&execution, &Execution::newNode, this, &TreeCanvas::maybeUpdateCanvas);
+  connect(&execution, &Execution::newNodes, this, &TreeCanvas::maybeUpdateCanvas);
   connect(&execution, &Execution::newRoot, [this]() {
     updateCanvas(true);
   });
@@ -158,7 +174,6 @@ TreeCanvas::~TreeCanvas() {
 ///***********************
 
 void TreeCanvas::scaleTree(int scale0, int zoomx, int zoomy) {
-  layoutMutex.lock();
 
   QSize viewport_size = size();
   auto* sa = static_cast<QAbstractScrollArea*>(parentWidget()->parentWidget());
@@ -172,10 +187,10 @@ void TreeCanvas::scaleTree(int scale0, int zoomx, int zoomy) {
   scale0 = std::min(std::max(scale0, LayoutConfig::minScale),
                     LayoutConfig::maxScale);
   m_options.scale = (static_cast<double>(scale0)) / 100.0;
-  BoundingBox bb = root->getBoundingBox();
+  BoundingBox bb = m_layout->boundingBox();
   int w = static_cast<int>((bb.right - bb.left + Layout::extent) * m_options.scale);
   int h = static_cast<int>(2 * Layout::extent +
-                           root->getShape()->depth() * Layout::dist_y * m_options.scale);
+                           m_layout->depth() * Layout::dist_y * m_options.scale);
 
   sa->horizontalScrollBar()->setRange(0, w - viewport_size.width());
   sa->verticalScrollBar()->setRange(0, h - viewport_size.height());
@@ -191,7 +206,6 @@ void TreeCanvas::scaleTree(int scale0, int zoomx, int zoomy) {
   sa->verticalScrollBar()->setValue(yoff - zoomy);
 
   emit scaleChanged(scale0);
-  layoutMutex.unlock();
   QWidget::update();
 }
 
@@ -378,8 +392,8 @@ void TreeCanvas::showNodeInfo(void) {
       extra_info = nm != nullptr ? nm->replaceNames(*info) : *info;
   extra_info += "\n";
 
-  DbEntry* entry = execution.getEntry(*currentNode);
-  int32_t nid = entry ? entry->nodeUID.nid : INT32_MIN;
+  DbEntry entry = execution.getEntry(*currentNode);
+  int32_t nid = entry ? entry.nodeUID().nid : INT32_MIN;
 
   auto depth = utils::calculateDepth(execution.nodeTree(), *currentNode);
   auto gid = currentNode->getIndex(na);
@@ -604,17 +618,16 @@ void TreeCanvas::timerEvent(QTimerEvent* e) {
 }
 
 void TreeCanvas::zoomToFit(void) {
-  QMutexLocker locker(&layoutMutex);
-  if (root && root->getShape()) {
+  if (!m_layout->empty()) {
     BoundingBox bb;
-    bb = root->getBoundingBox();
+    bb = m_layout->boundingBox();
     QWidget* p = parentWidget();
     if (p) {
       double newXScale = static_cast<double>(p->width()) /
                          (bb.right - bb.left + Layout::extent);
       double newYScale =
           static_cast<double>(p->height()) /
-          (root->getShape()->depth() * Layout::dist_y + 2 * Layout::extent);
+          (m_layout->depth() * Layout::dist_y + 2 * Layout::extent);
       int scale0 = static_cast<int>(std::min(newXScale, newYScale) * 100);
       if (scale0 < LayoutConfig::minScale) scale0 = LayoutConfig::minScale;
       if (scale0 > LayoutConfig::maxAutoZoomScale)
@@ -647,6 +660,10 @@ void TreeCanvas::centerCurrentNode(void) {
     c = c->getParent(execution.nodeTree().getNA());
   }
 
+  centerOn(x, y);
+}
+
+void TreeCanvas::centerOn(int x, int y) {
   x = static_cast<int>((m_view.xtrans + x) * m_options.scale);
   y = static_cast<int>(y * m_options.scale);
 
@@ -981,19 +998,25 @@ VisualNode* TreeCanvas::eventNode(QEvent* event) {
     default:
       return nullptr;
   }
+  /// the node under the mouse on the screen, which is that of the
+  /// layout drawn (the tree may have grown since)
+  const QPoint pos = treePosition(QPoint(x, y));
+  const int i = m_layout->nodeAt(pos.x(), pos.y());
+  return i == -1 ? nullptr : execution.nodeTree().getNA()[(*m_layout)[i].gid];
+}
+
+QPoint TreeCanvas::treePosition(const QPoint& pos) {
   QAbstractScrollArea* sa =
       static_cast<QAbstractScrollArea*>(parentWidget()->parentWidget());
   int xoff = sa->horizontalScrollBar()->value() / m_options.scale;
   int yoff = sa->verticalScrollBar()->value() / m_options.scale;
 
-  BoundingBox bb = root->getBoundingBox();
+  BoundingBox bb = m_layout->boundingBox();
   int w = static_cast<int>((bb.right - bb.left + Layout::extent) * m_options.scale);
   if (w < sa->viewport()->width()) xoff -= (sa->viewport()->width() - w) / 2;
 
-  VisualNode* n;
-  n = root->findNode(execution.nodeTree().getNA(), static_cast<int>(x / m_options.scale - m_view.xtrans + xoff),
-                     static_cast<int>((y - 30) / m_options.scale + yoff));
-  return n;
+  return QPoint(static_cast<int>(pos.x() / m_options.scale - m_view.xtrans + xoff),
+                static_cast<int>((pos.y() - 30) / m_options.scale + yoff));
 }
 
 bool TreeCanvas::event(QEvent* event) {
@@ -1017,33 +1040,29 @@ void TreeCanvas::resizeToOuter(void) {
 }
 
 void TreeCanvas::paintEvent(QPaintEvent* event) {
-    if (root==NULL || root->getShape()==NULL)
-        return;
-  QMutexLocker locker(&layoutMutex);
+  /// this draws the last layout published (see `layoutPublished`),
+  /// which needs neither the tree nor the layout mutex
+  if (m_layout->empty()) return;
   QPainter painter(this);
-  painter.setRenderHint(QPainter::Antialiasing);
 
   QAbstractScrollArea* sa =
       static_cast<QAbstractScrollArea*>(parentWidget()->parentWidget());
   int xoff = sa->horizontalScrollBar()->value() / m_options.scale;
   int yoff = sa->verticalScrollBar()->value() / m_options.scale;
 
-  BoundingBox bb = root->getBoundingBox();
+  BoundingBox bb = m_layout->boundingBox();
   int w = static_cast<int>((bb.right - bb.left + Layout::extent) * m_options.scale);
   if (w < sa->viewport()->width()) xoff -= (sa->viewport()->width() - w) / 2;
 
-  QRect origClip = event->rect();
-  painter.translate(0, 30);
-  painter.scale(m_options.scale, m_options.scale);
-  painter.translate(m_view.xtrans - xoff, -yoff);
-  QRect clip(static_cast<int>(origClip.x() / m_options.scale - m_view.xtrans + xoff),
-             static_cast<int>(origClip.y() / m_options.scale + yoff),
-             static_cast<int>(origClip.width() / m_options.scale),
-             static_cast<int>(origClip.height() / m_options.scale));
+  /// where the root goes; the tiles are copied to whole pixels
+  const QPoint origin(qRound((m_view.xtrans - xoff) * m_options.scale),
+                      30 - qRound(yoff * m_options.scale));
 
-
-  DrawingCursor dc(root, execution.nodeTree().getNA(), painter, clip);
-  PreorderNodeVisitor<DrawingCursor>(dc).run();
+  /// the selection etc. may have changed since the tiles were drawn; if
+  /// the builder holds the tree, they are shown as they were then
+  const bool live = treeMutex.tryLock();
+  m_tiles->paint(painter, origin, event->rect(), m_options.scale, live ? &na : nullptr);
+  if (live) treeMutex.unlock();
 }
 
 void TreeCanvas::mouseDoubleClickEvent(QMouseEvent* event) {
@@ -1143,6 +1162,14 @@ void TreeCanvas::navigateToNodeById(int gid) {
 }
 
 void TreeCanvas::mousePressEvent(QMouseEvent* event) {
+  if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ShiftModifier)) {
+    if (m_rubberBand == nullptr) m_rubberBand = new QRubberBand(QRubberBand::Rectangle, this);
+    m_rubberOrigin = event->pos();
+    m_rubberBand->setGeometry(QRect(m_rubberOrigin, QSize()));
+    m_rubberBand->show();
+    event->accept();
+    return;
+  }
   if (treeMutex.tryLock()) {
     if (event->button() == Qt::LeftButton) {
       VisualNode* n = eventNode(event);
@@ -1159,6 +1186,53 @@ void TreeCanvas::mousePressEvent(QMouseEvent* event) {
   event->ignore();
 }
 
+void TreeCanvas::mouseMoveEvent(QMouseEvent* event) {
+  if (m_rubberBand == nullptr || !m_rubberBand->isVisible()) {
+    event->ignore();
+    return;
+  }
+  m_rubberBand->setGeometry(QRect(m_rubberOrigin, event->pos()).normalized());
+  event->accept();
+}
+
+void TreeCanvas::mouseReleaseEvent(QMouseEvent* event) {
+  if (m_rubberBand == nullptr || !m_rubberBand->isVisible()) {
+    event->ignore();
+    return;
+  }
+  m_rubberBand->hide();
+  event->accept();
+
+  const QRect area = m_rubberBand->geometry();
+  m_rubberArea = QRect(treePosition(area.topLeft()),
+                       treePosition(area.bottomRight())).normalized();
+
+  selectRubberArea();
+}
+
+void TreeCanvas::selectRubberArea() {
+  /// as with the other mouse events, the GUI never waits for the builder
+  if (!treeMutex.tryLock()) {
+    QTimer::singleShot(RUBBER_RETRY_MS, this, &TreeCanvas::selectRubberArea);
+    return;
+  }
+
+  auto& na = execution.nodeTree().getNA();
+
+  for (int gid : m_rubberSelection) na[gid]->setSelected(false);
+  m_rubberSelection.clear();
+
+  for (int i : m_layout->nodesIn(m_rubberArea)) {
+    const int gid = (*m_layout)[i].gid;
+    na[gid]->setSelected(true);
+    m_rubberSelection.push_back(gid);
+  }
+
+  treeMutex.unlock();
+
+  QWidget::update();
+}
+
 void TreeCanvas::setAutoHideFailed(bool b) { m_options.autoHideFailed = b; }
 
 void TreeCanvas::setAutoZoom(bool b) {
@@ -1189,10 +1263,10 @@ bool TreeCanvas::getMoveDuringSearch(void) { return m_options.moveDuringSearch;
 
 void TreeCanvas::setMoveDuringSearch(bool b) { m_options.moveDuringSearch = b; }
 
-// Call this when there is a new node, and the canvas will update if
+// Call this when there are new nodes, and the canvas will update if
 // the refresh rate says that it should.
-void TreeCanvas::maybeUpdateCanvas(void) {
-  nodeCount++;
+void TreeCanvas::maybeUpdateCanvas(quint64 first, quint64 last) {
+  nodeCount += static_cast<int>(last - first);
   if (nodeCount >= m_options.refreshRate) {
     nodeCount = 0;
     updateCanvas(true);
@@ -1211,38 +1285,37 @@ void TreeCanvas::updateViaTimer(void) {
 }
 
 void TreeCanvas::updateCanvas(bool hide_failed) {
+  m_layoutWorker->request(m_options.autoHideFailed && hide_failed);
+}
 
-  QMutexLocker locker1(&treeMutex);
-  QMutexLocker locker2(&layoutMutex);
-
+void TreeCanvas::layoutPublished() {
 
-  if (root == nullptr) return;
+  m_layout = m_layoutWorker->latest();
+  m_tiles->setGeneration(m_layout);
 
-  const auto& na = execution.nodeTree().getNA();
+  if (m_layout->empty()) return;
 
-  if (m_options.autoHideFailed && hide_failed) {
-    root->hideFailed(na, true);
-  }
-
-  /// what does this do?
-  /// find first unhidden node and mark it
-  for (VisualNode* n = currentNode; n != nullptr; n = n->getParent(na)) {
-    if (n->isHidden()) {
+  /// the selected node is not drawn if an ancestor is hidden (e.g. failed
+  /// subtrees were hidden): select the first hidden ancestor instead
+  if (currentNode != nullptr) {
+    QMutexLocker locker(&treeMutex);
+    const auto& na = execution.nodeTree().getNA();
+    VisualNode* drawn = currentNode;
+    for (VisualNode* n = currentNode->getParent(na); n != nullptr; n = n->getParent(na)) {
+      if (n->isHidden()) drawn = n;
+    }
+    if (drawn != currentNode) {
       currentNode->setMarked(false);
-      currentNode = n;
+      currentNode = drawn;
       currentNode->setMarked(true);
-      break;
     }
   }
 
-
-  root->layout(na);
-
-  BoundingBox bb = root->getBoundingBox();
+  BoundingBox bb = m_layout->boundingBox();
 
   int w = static_cast<int>((bb.right - bb.left + Layout::extent) * m_options.scale);
   int h = static_cast<int>(2 * Layout::extent +
-                           root->getShape()->depth() * Layout::dist_y * m_options.scale);
+                           m_layout->depth() * Layout::dist_y * m_options.scale);
   m_view.xtrans = -bb.left + (Layout::extent / 2);
 
   int scale0 = static_cast<int>(m_options.scale * 100);
@@ -1253,7 +1326,7 @@ void TreeCanvas::updateCanvas(bool hide_failed) {
                          (bb.right - bb.left + Layout::extent);
       double newYScale =
           static_cast<double>(p->height()) /
-          (root->getShape()->depth() * Layout::dist_y + 2 * Layout::extent);
+          (m_layout->depth() * Layout::dist_y + 2 * Layout::extent);
 
       scale0 = static_cast<int>(std::min(newXScale, newYScale) * 100);
       if (scale0 < LayoutConfig::minScale) scale0 = LayoutConfig::minScale;
@@ -1262,12 +1335,12 @@ void TreeCanvas::updateCanvas(bool hide_failed) {
 
       w = static_cast<int>((bb.right - bb.left + Layout::extent) * m_options.scale);
       h = static_cast<int>(2 * Layout::extent +
-                           root->getShape()->depth() * Layout::dist_y * m_options.scale);
+                           m_layout->depth() * Layout::dist_y * m_options.scale);
     }
   }
 
-
-  centerCurrentNode(); /// TODO(maxim): is this one needed?
+  /// TODO(maxim): is this one needed?
+  centerCurrentNode();
 
   /// layout done
   {
@@ -1378,24 +1451,7 @@ void TreeCanvas::highlightFailedByNogoods() {
   auto action = [](VisualNode* node) { node->setHovered(true); };
 
   auto predicate = [this](VisualNode* node) {
-    auto info = execution.getInfo(*node);
-
-    if (!info) return false;
-
-    try {
-      auto info_json = nlohmann::json::parse(*info);
-
-      auto nogoods = info_json["nogoods"];
-
-      if (nogoods.is_array() && nogoods.size() > 0) return true;
-    } catch (std::exception&) {
-#ifdef MAXIM_DEBUG
-      std::cerr << "can't parse json\n";
-#endif
-    }
-
-    return false;
-
+    return execution.getNodeInfo(*node).has_nogoods;
   };
 
   applyToEachNodeIf(action, predicate);
@@ -1412,6 +1468,7 @@ void TreeCanvas::deleteNode(VisualNode* n) {
   parent->removeChild(n->getIndex(na));
 
   parent->dirtyUp(na);
+  execution.nodeTree().thaw();
 }
 
 /// What does it mean to remove a node:
@@ -1443,6 +1500,7 @@ void TreeCanvas::deleteMiddleNode(Node* to_del_node, int alt_grand) {
   }
 
   parent->dirtyUp(na);
+  execution.nodeTree().thaw();
 
 }
 
@@ -1606,7 +1664,7 @@ void TreeCanvas::findSelectedShape() {
 
 void TreeCanvas::analyseBackjumps() {
 
-  std::vector<BackjumpItem2> bjs = Backjumps::findBackjumps2(root, na);
+  std::vector<BackjumpItem2> bjs = Backjumps::findBackjumps2(execution.nodeTree());
 
   std::vector<std::string> labels_to;
 
@@ -1682,6 +1740,8 @@ void TreeCanvas::highlightSubtree() {
 
     auto state = currentNode->isHighlighted();
     currentNode->setHighlighted(!state);
+    /// for its outline to be placed again
+    currentNode->dirtyUp(execution.nodeTree().getNA());
 
     updateCanvas();
 }
@@ -1717,6 +1777,7 @@ void TreeCanvas::nextStatus() {
     currentNode->setStatus(UNDETERMINED);
   }
   currentNode->dirtyUp(na);
+  execution.nodeTree().thaw();
   updateCanvas();
 }
 
@@ -1724,6 +1785,7 @@ void TreeCanvas::addChildren() {
   if (currentNode->getNumberOfChildren() == 0) {
     _addChildren(currentNode);
     currentNode->setStatus(BRANCH);
+    execution.nodeTree().thaw();
   }
   
   updateCanvas();
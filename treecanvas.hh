@@ -27,6 +27,7 @@
 #include <QtGui>
 #include <QtWidgets>
 #include <memory>
+#include <vector>
 #include <sstream>
 #include <functional>
 #include <unordered_map>
@@ -48,6 +49,9 @@ class NodeTree;
 class NodeAllocator;
 class VisualNode;
 class Node;
+class LayoutWorker;
+class LayoutGeneration;
+class TileCache;
 
 namespace cpprofiler { namespace analysis {
   class SimilarShapesWindow;
@@ -142,9 +146,33 @@ class TreeCanvas : public QWidget {
   /// Timer id for delaying the update
   int layoutDoneTimerId = 0;
 
+  /// Lays the tree out off the GUI thread (see `updateCanvas`)
+  std::unique_ptr<LayoutWorker> m_layoutWorker;
+  /// The layout that is drawn: the last one published by the worker
+  std::shared_ptr<const LayoutGeneration> m_layout;
+  /// Pictures of `m_layout`, which repaints copy rather than draw
+  std::unique_ptr<TileCache> m_tiles;
+
+  /// Shown while selecting nodes by dragging with Shift held
+  QRubberBand* m_rubberBand = nullptr;
+  /// Where the drag started
+  QPoint m_rubberOrigin;
+  /// Nodes selected by the last drag (by gid)
+  std::vector<int> m_rubberSelection;
+  /// Tree coordinates of the last drag, to be selected
+  QRect m_rubberArea;
+
   /// Store mapping from id to path
   std::unordered_map<std::string, std::string> pathmap;
 
+  /// Take the layout just published by the worker: update the
+  /// scroll bars, zoom and centering, and repaint
+  void layoutPublished();
+  /// Scroll so that (\a x, \a y) in tree coordinates is centered
+  void centerOn(int x, int y);
+
+  /// Tree coordinates of \a pos (in the widget)
+  QPoint treePosition(const QPoint& pos);
     /// Return the node corresponding to the \a event position
   VisualNode* eventNode(QEvent *event);
   /// General event handler, used for displaying tool tips
@@ -153,6 +181,13 @@ class TreeCanvas : public QWidget {
   void paintEvent(QPaintEvent* event) override;
   /// Handle mouse press event
   void mousePressEvent(QMouseEvent* event) override;
+  /// Handle mouse move event (while selecting with the rubber band)
+  void mouseMoveEvent(QMouseEvent* event) override;
+  /// Handle mouse release event (selects the nodes under the rubber band)
+  void mouseReleaseEvent(QMouseEvent* event) override;
+  /// Select the nodes in `m_rubberArea`; tried again later while the
+  /// builder holds the tree
+  void selectRubberArea();
   /// Handle mouse double click event
   void mouseDoubleClickEvent(QMouseEvent* event) override;
   /// Handle context menu event
@@ -227,7 +262,9 @@ Q_SIGNALS:
 public Q_SLOTS:
   void reset();
 
-  void maybeUpdateCanvas();
+  void maybeUpdateCanvas(quint64 first, quint64 last);
+  /// Have the tree laid out again; this returns right away, the canvas
+  /// is updated once the layout is published (see `layoutPublished`)
   void updateCanvas(bool hide_failed = false);
   /// Set the selected node to \a n
   void setCurrentNode(VisualNode* n, bool finished=true, bool update=true);
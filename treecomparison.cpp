@@ -69,7 +69,7 @@ static int copyTree(VisualNode* target_node, Execution& ex_target,
             auto& source_data = ex_source.getData();
 
             int source_gid = source_tree.getIndex(n);
-            DbEntry* entry = source_data.getEntry(source_gid);
+            DbEntry entry = source_data.getEntry(source_gid);
 
             auto& this_data = ex_target.getData();
             int target_index = target_tree.getIndex(next);
@@ -78,13 +78,13 @@ static int copyTree(VisualNode* target_node, Execution& ex_target,
             /// TODO(maxim): connect nogoods as well
 
             if (entry) {
-              auto uid = entry->nodeUID;
-              auto info = source_data.uid2info.find(uid);
+              auto uid = entry.nodeUID();
+              auto info = source_data.getInfo(uid);
   
               /// note(maxim): should have to maintain another map
               /// (even though info is only a pointer)
-              if (info != source_data.uid2info.end()) {
-                  this_data.uid2info[uid] = info->second;
+              if (info) {
+                  this_data.uid2info[uid] = info;
               }
             }
 
@@ -0,0 +1,218 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "treesnapshot.hh"
+#include "nodetree.hh"
+#include "cpprofiler/utils/tree_utils.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "libs/perf_helper.hh"
+
+TreeSnapshot::TreeSnapshot(const NodeTree& nt) {
+
+    const auto& na = nt.getNA();
+
+    m_allocated = na.size();
+    m_pre.assign(m_allocated, -1);
+
+    m_gid.reserve(m_allocated);
+    m_parent.reserve(m_allocated);
+    m_depth.reserve(m_allocated);
+    m_status.reserve(m_allocated);
+
+    /// (gid, preorder index of the parent)
+    std::vector<std::pair<int32_t, int32_t>> stack;
+    stack.emplace_back(0, -1);
+
+    while (!stack.empty()) {
+        const auto top = stack.back();
+        stack.pop_back();
+
+        const int32_t i = static_cast<int32_t>(m_gid.size());
+        const VisualNode* node = na[top.first];
+
+        m_pre[top.first] = i;
+        m_gid.push_back(top.first);
+        m_parent.push_back(top.second);
+
+        const int depth = top.second == -1 ? 1 : m_depth[top.second] + 1;
+        m_depth.push_back(depth);
+        m_max_depth = std::max(m_max_depth, depth);
+
+        m_status.push_back(node->getStatus());
+
+        /// reversed, so that the first child is visited first
+        for (int alt = node->getNumberOfChildren(); alt--;) {
+            stack.emplace_back(node->getChild(alt), i);
+        }
+    }
+
+    const int n = size();
+
+    m_end.resize(n);
+    m_flags.resize(n);
+    m_child_offset.assign(n + 1, 0);
+
+    for (int i = 0; i < n; ++i) {
+        m_end[i] = i + 1;
+        m_flags[i] = m_status[i] == SOLVED ? HAS_SOLUTION : 0;
+    }
+
+    /// descendants come after their ancestors
+    for (int i = n - 1; i > 0; --i) {
+        const int p = m_parent[i];
+        m_end[p] = std::max(m_end[p], m_end[i]);
+        m_flags[p] |= m_flags[i] & HAS_SOLUTION;
+        ++m_child_offset[p + 1];
+    }
+
+    for (int i = 0; i < n; ++i) {
+        m_child_offset[i + 1] += m_child_offset[i];
+    }
+
+    /// children in the order of their alternatives (their preorder)
+    m_children.resize(n > 0 ? n - 1 : 0);
+    std::vector<int32_t> next(m_child_offset.begin(), m_child_offset.end() - 1);
+    for (int i = 1; i < n; ++i) {
+        m_children[next[m_parent[i]]++] = i;
+    }
+}
+
+uint64_t TreeSnapshot::allocatedBytes() const {
+    return (m_gid.capacity() + m_pre.capacity() + m_parent.capacity() + m_end.capacity() +
+            m_child_offset.capacity() + m_children.capacity() + m_depth.capacity()) *
+               sizeof(int32_t) +
+           m_status.capacity() + m_flags.capacity();
+}
+
+namespace treesnapshot {
+
+    /// root (branch)
+    ///  |- 1 (branch)
+    ///  |   |- 3 (failed)
+    ///  |   '- 4 (solved)
+    ///  '- 2 (failed)
+    static bool smallTree() {
+
+        NodeTree nt;
+        auto& na = nt.getNA();
+
+        utils::addChildren(nt.getRoot(), nt, 2);
+        utils::addChildren(nt.getChild(*nt.getRoot(), 0), nt, 2);
+
+        const NodeStatus statuses[] = {BRANCH, BRANCH, FAILED, FAILED, SOLVED};
+        for (int gid = 0; gid < na.size(); ++gid) na[gid]->setStatus(statuses[gid]);
+
+        const int gid_of_kid0 = nt.getRoot()->getChild(0);
+        const int gid_of_kid1 = nt.getRoot()->getChild(1);
+
+        TreeSnapshot snapshot(nt);
+
+        if (snapshot.size() != 5 || snapshot.maxDepth() != 3) return false;
+
+        /// preorder: root, kid0, its two kids, kid1
+        if (snapshot.gid(0) != 0 || snapshot.gid(1) != gid_of_kid0 ||
+            snapshot.gid(4) != gid_of_kid1) {
+            return false;
+        }
+
+        if (snapshot.end(0) != 5 || snapshot.end(1) != 4 || snapshot.end(4) != 5) return false;
+        if (snapshot.childCount(0) != 2 || snapshot.child(0, 1) != 4) return false;
+        if (snapshot.parent(3) != 1 || snapshot.depth(3) != 3) return false;
+        if (!snapshot.hasSolution(0) || !snapshot.hasSolution(1) || snapshot.hasSolution(4)) {
+            return false;
+        }
+
+        std::vector<int> post;
+        snapshot.forEachPostorder(0, [&post](int i) { post.push_back(i); });
+
+        return post == std::vector<int>{2, 3, 1, 4, 0};
+    }
+
+    /// A random tree: preorder, subtree ranges and children must
+    /// agree with a traversal of the tree itself
+    static bool randomTree(int nodes) {
+
+        NodeTree nt;
+        auto& na = nt.getNA();
+
+        utils::buildRandomTree(nt, nodes, 7);
+
+        perfHelper.begin("tree snapshot: freeze 1M nodes");
+        TreeSnapshot snapshot(nt);
+        perfHelper.end();
+
+        if (snapshot.size() != na.size()) return false;
+
+        std::vector<int> expected;
+        utils::applyToEachNode(nt, nt.getRoot(), [&nt, &expected](VisualNode* n) {
+            expected.push_back(nt.getIndex(n));
+        });
+
+        /// `applyToEachNode` visits the last child first
+        std::vector<int> mirrored;
+        for (int i = 0; i < snapshot.size(); ++i) {
+            const int gid = snapshot.gid(i);
+            if (snapshot.preorder(gid) != i) return false;
+
+            const auto* node = na[gid];
+            if (snapshot.childCount(i) != static_cast<int>(node->getNumberOfChildren())) {
+                return false;
+            }
+            for (int alt = 0; alt < snapshot.childCount(i); ++alt) {
+                const int kid = snapshot.child(i, alt);
+                if (snapshot.gid(kid) != node->getChild(alt) || snapshot.parent(kid) != i) {
+                    return false;
+                }
+            }
+            if (snapshot.childCount(i) > 0 &&
+                snapshot.end(i) != snapshot.end(snapshot.child(i, snapshot.childCount(i) - 1))) {
+                return false;
+            }
+        }
+
+        std::sort(expected.begin(), expected.end());
+        std::vector<int> all(snapshot.size());
+        for (int i = 0; i < snapshot.size(); ++i) all[i] = snapshot.gid(i);
+        std::sort(all.begin(), all.end());
+
+        return all == expected;
+    }
+
+    void test_module() {
+
+        if (smallTree()) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (small tree snapshot)\n";
+        }
+
+        if (randomTree(1000000)) {
+            std::cerr << "test passed!\n";
+        } else {
+            std::cerr << "test did NOT pass! (random tree snapshot)\n";
+        }
+    }
+}
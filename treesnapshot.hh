@@ -0,0 +1,145 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef TREESNAPSHOT_HH
+#define TREESNAPSHOT_HH
+
+#include <vector>
+#include <cstdint>
+
+#include "spacenode.hh"
+
+class NodeTree;
+
+namespace treesnapshot { void test_module(); }
+
+/// Read-only copy of the structure of a tree, laid out in preorder:
+/// the subtree of node `i` (a preorder index) is the range [i, end(i)),
+/// children are stored contiguously (CSR) and everything else a full-tree
+/// pass needs is in flat arrays, so such passes are sequential scans
+/// rather than pointer chasing. See `NodeTree::snapshot`.
+class TreeSnapshot {
+
+    /// preorder index -> gid
+    std::vector<int32_t> m_gid;
+    /// gid -> preorder index (-1 for nodes no longer in the tree)
+    std::vector<int32_t> m_pre;
+    /// preorder index of the parent (-1 for the root)
+    std::vector<int32_t> m_parent;
+    /// one past the last node of the subtree
+    std::vector<int32_t> m_end;
+    /// children of `i` are m_children[m_child_offset[i], m_child_offset[i+1])
+    std::vector<int32_t> m_child_offset;
+    std::vector<int32_t> m_children;
+    std::vector<int32_t> m_depth;
+    std::vector<uint8_t> m_status;
+    std::vector<uint8_t> m_flags;
+
+    int m_max_depth = 0;
+    /// `NodeAllocator::size` when taken
+    int m_allocated = 0;
+
+public:
+
+    enum Flags : uint8_t {
+        /// there is a solution in the subtree (including the node)
+        HAS_SOLUTION = 1
+    };
+
+    explicit TreeSnapshot(const NodeTree& nt);
+
+    TreeSnapshot(const TreeSnapshot&) = delete;
+    TreeSnapshot& operator=(const TreeSnapshot&) = delete;
+
+    /// number of nodes in the tree (the root is 0)
+    int size() const { return static_cast<int>(m_gid.size()); }
+
+    int allocated() const { return m_allocated; }
+
+    int gid(int i) const { return m_gid[i]; }
+
+    /// preorder index of `gid`, -1 if it is not in the tree
+    int preorder(int gid) const {
+        return gid >= 0 && gid < static_cast<int>(m_pre.size()) ? m_pre[gid] : -1;
+    }
+
+    int parent(int i) const { return m_parent[i]; }
+
+    int end(int i) const { return m_end[i]; }
+
+    int subtreeSize(int i) const { return m_end[i] - i; }
+
+    int childCount(int i) const { return m_child_offset[i + 1] - m_child_offset[i]; }
+
+    int child(int i, int alt) const { return m_children[m_child_offset[i] + alt]; }
+
+    const int32_t* childrenBegin(int i) const { return m_children.data() + m_child_offset[i]; }
+    const int32_t* childrenEnd(int i) const { return m_children.data() + m_child_offset[i + 1]; }
+
+    /// the root is at depth 1 (as in `Statistics::maxDepth`)
+    int depth(int i) const { return m_depth[i]; }
+
+    int maxDepth() const { return m_max_depth; }
+
+    NodeStatus status(int i) const { return static_cast<NodeStatus>(m_status[i]); }
+
+    bool hasSolution(int i) const { return m_flags[i] & HAS_SOLUTION; }
+
+    /// Call `enter(i)` for every node of the subtree of `root` in preorder
+    /// and `leave(i)` once its subtree is done (i.e. in postorder)
+    template <typename Enter, typename Leave>
+    void traverse(int root, Enter&& enter, Leave&& leave) const;
+
+    /// Call `action(i)` for every node of the subtree of `root` in postorder
+    template <typename Action>
+    void forEachPostorder(int root, Action&& action) const {
+        traverse(root, [](int) {}, action);
+    }
+
+    uint64_t allocatedBytes() const;
+};
+
+template <typename Enter, typename Leave>
+void TreeSnapshot::traverse(int root, Enter&& enter, Leave&& leave) const {
+
+    /// nodes entered, but not left
+    std::vector<int32_t> open;
+
+    const int last = m_end[root];
+
+    for (int i = root; i < last; ++i) {
+        /// subtrees that end before `i`
+        while (!open.empty() && m_end[open.back()] <= i) {
+            leave(open.back());
+            open.pop_back();
+        }
+        enter(i);
+        open.push_back(i);
+    }
+
+    while (!open.empty()) {
+        leave(open.back());
+        open.pop_back();
+    }
+}
+
+#endif
@@ -38,10 +38,12 @@
 #include "visualnode.hh"
 
 #include "layoutcursor.hh"
+#include "parallellayout.hh"
 #include "nodevisitor.hh"
 
  #include "libs/perf_helper.hh"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -56,6 +58,116 @@ Shape* Shape::copy(const Shape* s) {
   return ret;
 }
 
+Shape* Shape::scratch(int d) {
+
+  struct Scratch {
+    Shape* shape = nullptr;
+    int capacity = 0;
+    ~Scratch() { if (shape) heap.rfree(shape); }
+  };
+
+  static thread_local Scratch s;
+
+  if (d > s.capacity) {
+    if (s.shape) heap.rfree(s.shape);
+    s.capacity = std::max(d, 2 * s.capacity);
+    s.shape = allocate(s.capacity);
+  }
+
+  s.shape->_depth = d;
+  return s.shape;
+}
+
+static size_t shapeBytes(const Shape* s) {
+  return sizeof(Shape) + (s->depth() - 1) * sizeof(Extent);
+}
+
+bool ShapeStore::Equal::operator()(const Shape* a, const Shape* b) const {
+  if (a->depth() != b->depth()) return false;
+  for (int i = 0; i < a->depth(); ++i) {
+    if ((*a)[i].l != (*b)[i].l || (*a)[i].r != (*b)[i].r) return false;
+  }
+  return true;
+}
+
+ShapeStore::~ShapeStore() {
+  for (auto& stripe : m_stripes) {
+    for (auto s : stripe.shapes) {
+      heap.rfree(s);
+    }
+  }
+}
+
+ShapeStore::Stripe& ShapeStore::stripeOf(size_t hash) {
+  /// the top bits of a multiplicative hash of the hash
+  const uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+  return m_stripes[mixed >> (64 - STRIPE_BITS)];
+}
+
+Shape* ShapeStore::intern(Shape* s) {
+
+  size_t hash = static_cast<size_t>(s->depth());
+  for (int i = 0; i < s->depth(); ++i) {
+    const auto& e = (*s)[i];
+    hash = hash * 1000003u ^ static_cast<size_t>(static_cast<unsigned>(e.l));
+    hash = hash * 1000003u ^ static_cast<size_t>(static_cast<unsigned>(e.r));
+  }
+  s->_hash = hash;
+
+  auto& stripe = stripeOf(hash);
+
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+
+  auto it = stripe.shapes.find(s);
+
+  Shape* res;
+  if (it != stripe.shapes.end()) {
+    res = *it;
+  } else {
+    res = Shape::copy(s);
+    res->computeBoundingBox();
+    res->_hash = hash;
+    res->_refs = 0;
+    stripe.shapes.insert(res);
+    stripe.bytes += shapeBytes(res);
+  }
+
+  ++res->_refs;
+  ++stripe.references;
+  stripe.referenced_bytes += shapeBytes(res);
+
+  return res;
+}
+
+void ShapeStore::release(Shape* s) {
+  if (s == nullptr || s == Shape::leaf || s == Shape::hidden) return;
+
+  auto& stripe = stripeOf(s->_hash);
+
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+
+  --stripe.references;
+  stripe.referenced_bytes -= shapeBytes(s);
+
+  if (--s->_refs == 0) {
+    stripe.shapes.erase(s);
+    stripe.bytes -= shapeBytes(s);
+    heap.rfree(s);
+  }
+}
+
+ShapeStore::Stats ShapeStore::stats() const {
+  Stats stats{0, 0, 0, 0};
+  for (const auto& stripe : m_stripes) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stats.distinct += stripe.shapes.size();
+    stats.references += stripe.references;
+    stats.bytes += stripe.bytes;
+    stats.unshared_bytes += stripe.referenced_bytes;
+  }
+  return stats;
+}
+
 int shapeSize(const Shape& s) {
   int total_size = 0;
 
@@ -124,7 +236,9 @@ VisualNode::VisualNode()
 
 void
 VisualNode::dispose(void) {
-    Shape::deallocate(shape);
+    /// NOTE(maxim): the shape belongs to the allocator's ShapeStore,
+    /// which frees all shapes at once
+    shape = nullptr;
     SpaceNode::dispose();
 }
 
@@ -143,8 +257,8 @@ void
 VisualNode::layout(const NodeAllocator& na) {
 
     perfHelper.begin("layout");
-    LayoutCursor l(this,na);
-    PostorderNodeVisitor<LayoutCursor>(l).run();
+    na.countLayout();
+    parallelLayout(this, na);
 
     perfHelper.end();
     // int nodesLayouted = 1;
@@ -416,12 +530,9 @@ Layouter::merge(Extent* result,
 }
 
 void
-VisualNode::setShape(Shape* s) {
-    if (shape != s) {
-        Shape::deallocate(shape);
-    }
+VisualNode::setShape(Shape* s, const NodeAllocator& na) {
+    na.shapes().release(shape);
     shape = s;
-    shape->computeBoundingBox();
 }
 
 void
@@ -450,7 +561,7 @@ VisualNode::computeShape(const NodeAllocator& na) {
     } else {
         if (num_of_kids == 0) {
             /// leaf nodes share the same layout
-            setShape(Shape::leaf);
+            setShape(Shape::leaf, na);
             return;
         } else {
             extent = Extent(Layout::extent);
@@ -461,18 +572,13 @@ VisualNode::computeShape(const NodeAllocator& na) {
     for (int i = num_of_kids; i--;)
         maxDepth = std::max(maxDepth, getChild(na,i)->getShape()->depth());
 
-    Shape* mergedShape;
-    if (getShape() && getShape() != Shape::leaf && getShape()->depth() >= maxDepth+1) {
-        mergedShape = getShape();
-        mergedShape->setDepth(maxDepth+1);
-    } else {
-        mergedShape = Shape::allocate(maxDepth+1);
-    }
+    /// built in scratch space, then interned (shared shapes are never modified)
+    Shape* mergedShape = Shape::scratch(maxDepth+1);
     (*mergedShape)[0] = extent;
 
     /// A node has a label, but no children
     if (num_of_kids < 1) {
-        setShape(mergedShape);
+        setShape(na.shapes().intern(mergedShape), na);
 
     /// A node has one child
     } else if (num_of_kids == 1) {
@@ -481,7 +587,7 @@ VisualNode::computeShape(const NodeAllocator& na) {
         for (int i = childShape->depth(); i--;)
             (*mergedShape)[i+1] = (*childShape)[i];
         (*mergedShape)[1].extend(-extent.l, -extent.r);
-        setShape(mergedShape);
+        setShape(na.shapes().intern(mergedShape), na);
 
     /// More than one child
     } else {
@@ -567,7 +673,7 @@ VisualNode::computeShape(const NodeAllocator& na) {
             offset += (alpha[i].first + alpha[i].second) / 2;
             getChild(na,i)->setOffset(offset);
         }
-        setShape(mergedShape);
+        setShape(na.shapes().intern(mergedShape), na);
         heap.free<std::pair<int,int> >(alpha,num_of_kids);
         heap.free<Extent>(currentShapeL,maxDepth);
     }
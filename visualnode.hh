@@ -41,6 +41,9 @@
 #include "spacenode.hh"
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
 
 class Data;
 //class TreeCanvas;
@@ -86,11 +89,15 @@ public:
 
 /// \brief The shape of a subtree
 class Shape {
+  friend class ShapeStore;
 private:
   /// The depth of this shape
   int _depth;
   /// The bounding box of this shape
   BoundingBox bb;
+  /// Set when interned (see ShapeStore)
+  size_t _hash;
+  int _refs;
   /// The shape is an array of extents, one for each depth level
   Extent shape[1];
   /// Copy construtor
@@ -106,6 +113,9 @@ public:
   static void deallocate(Shape*);
   /// Copy \a s
   static Shape* copy(const Shape* s);
+  /// Reusable shape of depth \a d to build a shape in before interning
+  /// it (one per thread, overwritten by the next call)
+  static Shape* scratch(int d);
 
   /// Static shape for leaf nodes
   static Shape* leaf;
@@ -145,6 +155,65 @@ operator <<(std::basic_ostream<Char,Traits>& os, const Shape& s) {
 
 int shapeSize(const Shape& s);
 
+/// Every distinct shape of a tree, stored once: identical subtrees
+/// (failed chains, repeated refutations...) share their shape, which is
+/// reference counted by the nodes using it. Shapes are immutable once
+/// interned. Any thread may intern and release; the store is split into
+/// stripes by hash, each with its own lock, so that the threads of a
+/// parallel layout (see `parallelLayout`) rarely wait for each other.
+class ShapeStore {
+
+  struct Hash {
+    size_t operator()(const Shape* s) const { return s->_hash; }
+  };
+  struct Equal {
+    bool operator()(const Shape* a, const Shape* b) const;
+  };
+
+  static constexpr int STRIPE_BITS = 4;
+  static constexpr int STRIPES = 1 << STRIPE_BITS;
+
+  struct Stripe {
+    mutable std::mutex mutex;
+    std::unordered_set<Shape*, Hash, Equal> shapes;
+
+    /// bytes of all stored shapes
+    uint64_t bytes = 0;
+    /// bytes the shapes would take if every node had its own copy
+    uint64_t referenced_bytes = 0;
+    uint64_t references = 0;
+  };
+
+  Stripe m_stripes[STRIPES];
+
+  Stripe& stripeOf(size_t hash);
+
+public:
+
+  struct Stats {
+    size_t distinct;
+    uint64_t references;
+    uint64_t bytes;
+    uint64_t unshared_bytes;
+  };
+
+  ShapeStore() = default;
+  ~ShapeStore();
+
+  ShapeStore(const ShapeStore&) = delete;
+  ShapeStore& operator=(const ShapeStore&) = delete;
+
+  /// The stored shape equal to \a s, with a reference taken for the
+  /// caller; \a s is copied only if there is no such shape yet
+  Shape* intern(Shape* s);
+
+  /// Drop a reference taken by `intern` (`Shape::leaf`/`hidden`
+  /// and nullptr are ignored)
+  void release(Shape* s);
+
+  Stats stats() const;
+};
+
 
 /// \brief %Node class that supports visual layout
 class VisualNode : public SpaceNode {
@@ -190,7 +259,7 @@ public:
   void setHidden(bool h);
   /// Mark all nodes up the path to the parent as dirty
   void dirtyUp(const NodeAllocator& na);
-  /// Compute layout for the subtree of this node
+  /// Compute layout for the subtree of this node (see `parallelLayout`)
   void layout(const NodeAllocator& na);
   /// Return offset off this node from its parent
   int getOffset(void);
@@ -260,8 +329,9 @@ public:
 
   /// Return the shape of this node
   Shape* getShape(void) const;
-  /// Set the shape of this node
-  void setShape(Shape* s);
+  /// Set the shape of this node to \a s (a reference to it from
+  /// `ShapeStore::intern` or a static shape) and release the old one
+  void setShape(Shape* s, const NodeAllocator& na);
   /// Compute the shape according to the shapes of the children
   void computeShape(const NodeAllocator& na);
   /// Return the bounding box
@@ -285,18 +355,41 @@ public:
 
 
 
+/// Nodes are constructed in place in blocks that never move (block `k`
+/// holds `FIRST_BLOCK << k` nodes), so there is no allocation per node,
+/// pointers to nodes stay valid, nodes with close gids are close in memory
+/// and releasing the tree is a handful of frees. Nodes that were published
+/// (see `size`) can be read while the builder keeps allocating.
 class NodeAllocator {
 private:
 
-  std::vector<VisualNode*> nodes;
+  static constexpr unsigned FIRST_BLOCK_BITS = 12;
+  static constexpr unsigned FIRST_BLOCK = 1u << FIRST_BLOCK_BITS;
+  /// enough for any `int` gid
+  static constexpr unsigned MAX_BLOCKS = 32 - FIRST_BLOCK_BITS;
+
+  VisualNode* blocks[MAX_BLOCKS] = {};
+  std::atomic<int> m_size{0};
+  size_t m_capacity = 0;
+
+  static unsigned blockOf(unsigned j);
+  /// Address of the node with gid \a i (allocated or not)
+  VisualNode* slot(int i) const;
+  /// Make room for the next node, return its gid
+  int reserveNext();
 
   /// Labels currently displayed
   QHash<VisualNode*, QString> labels;
+
+  /// Shapes of the nodes (the layout changes them through a const reference)
+  mutable ShapeStore m_shapes;
+  /// How many times the tree has been laid out (see `layoutCount`)
+  mutable uint64_t m_layouts = 0;
 public:
   NodeAllocator();
   ~NodeAllocator();
-  NodeAllocator(const NodeAllocator&) = default;
-  NodeAllocator& operator=(const NodeAllocator&) = default;
+  NodeAllocator(const NodeAllocator&) = delete;
+  NodeAllocator& operator=(const NodeAllocator&) = delete;
   /// Allocate new node with parent \a p and database id
   int allocate(int p);
   /// Allocate new root node
@@ -316,6 +409,15 @@ public:
   /// returns the total number of nodes allocated
   int size() const;
 
+  ShapeStore& shapes() const { return m_shapes; }
+
+  /// Layouts of the tree so far: a layout makes the nodes it visits
+  /// clean, so whoever wants to know what changed since they last looked
+  /// at the tree needs to know that nobody else laid it out in between
+  uint64_t layoutCount() const { return m_layouts; }
+  /// Called by `VisualNode::layout` (the caller holds the layout mutex)
+  void countLayout() const { ++m_layouts; }
+
 };
 
 bool compareNodes(const VisualNode& n1, const VisualNode& n2);
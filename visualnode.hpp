@@ -39,43 +39,78 @@
 #define VISUALNODE_HPP
 
 #include <iostream>
+#include <new>
+#include <type_traits>
 #include <QString>
 
+#include "cpprofiler/utils/bits.hh"
+
 #ifdef MAXIM_DEBUG
 #include <QDebug>
 #endif
 
-inline NodeAllocator::NodeAllocator() {
-  nodes.reserve(1000);
-}
+inline NodeAllocator::NodeAllocator() {}
 
 inline NodeAllocator::~NodeAllocator() {
-  for (auto &node : nodes) {
-    delete node;
+  if (!std::is_trivially_destructible<VisualNode>::value) {
+    const int n = m_size.load(std::memory_order_relaxed);
+    for (int i = 0; i < n; ++i) {
+      slot(i)->~VisualNode();
+    }
+  }
+
+  for (auto block : blocks) {
+    ::operator delete(block);
+  }
+}
+
+inline unsigned NodeAllocator::blockOf(unsigned j) {
+  return utils::highestBit(j) - FIRST_BLOCK_BITS;
+}
+
+inline VisualNode* NodeAllocator::slot(int i) const {
+  const unsigned j = static_cast<unsigned>(i) + FIRST_BLOCK;
+  const unsigned block = blockOf(j);
+  return blocks[block] + (j - (FIRST_BLOCK << block));
+}
+
+inline int NodeAllocator::reserveNext() {
+  const int n = m_size.load(std::memory_order_relaxed);
+  if (static_cast<size_t>(n) == m_capacity) {
+    /// raw memory: nodes are constructed one by one as they are allocated
+    const unsigned block = blockOf(static_cast<unsigned>(m_capacity) + FIRST_BLOCK);
+    const size_t block_size = size_t{FIRST_BLOCK} << block;
+    blocks[block] = static_cast<VisualNode*>(::operator new(block_size * sizeof(VisualNode)));
+    m_capacity += block_size;
   }
+  return n;
 }
 
 inline int NodeAllocator::allocate(int p) {
-  nodes.push_back(new VisualNode{p});
-  return nodes.size() - 1;
+  const int gid = reserveNext();
+  new (slot(gid)) VisualNode{p};
+  m_size.store(gid + 1, std::memory_order_release);
+  return gid;
 }
 
 inline int NodeAllocator::allocateRoot() {
 #ifdef MAXIM_DEBUG
   qDebug() << "allocated root";
 #endif
-  nodes.push_back(new VisualNode{});
-  return nodes.size() - 1;
+  const int gid = reserveNext();
+  new (slot(gid)) VisualNode{};
+  m_size.store(gid + 1, std::memory_order_release);
+  return gid;
 }
 
 inline VisualNode* NodeAllocator::operator[](int i) const {
 #ifdef MAXIM_DEBUG
   // qDebug() << "nodes[" << i << "]";
 #endif
-  if (nodes.size() <= static_cast<uint>(i)) {
+  if (i < 0 || i >= m_size.load(std::memory_order_acquire)) {
     return nullptr;
   } else {
-    return nodes[i];
+    return slot(i);
   }
 }
 
@@ -94,7 +129,7 @@ inline QString NodeAllocator::getLabel(VisualNode* n) const {
 }
 
 inline int NodeAllocator::size() const {
-  return nodes.size();
+  return m_size.load(std::memory_order_acquire);
 }
 
 inline Extent::Extent(void) : l(-1), r(-1) {}
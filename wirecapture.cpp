@@ -0,0 +1,94 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "wirecapture.hh"
+
+#include <iostream>
+#include <cstring>
+
+static const char WIRE_MAGIC[8] = {'C', 'P', 'P', 'W', 'I', 'R', 'E', '1'};
+
+WireCapture::WireCapture(const QString& path) : file(path) {
+
+  /// NOTE(maxim): unbuffered, so that appended data goes to the file
+  /// straight from the socket's buffer instead of being copied into QFile's
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+    std::cerr << "can't open capture file: " << path.toStdString() << "\n";
+    return;
+  }
+
+  file.write(WIRE_MAGIC, sizeof(WIRE_MAGIC));
+  start = std::chrono::steady_clock::now();
+}
+
+void WireCapture::append(const char* data, size_t size) {
+  if (!file.isOpen() || size == 0) return;
+
+  const uint64_t time = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count());
+  const uint32_t length = static_cast<uint32_t>(size);
+
+  char record_header[sizeof(time) + sizeof(length)];
+  std::memcpy(record_header, &time, sizeof(time));
+  std::memcpy(record_header + sizeof(time), &length, sizeof(length));
+
+  file.write(record_header, sizeof(record_header));
+  file.write(data, static_cast<qint64>(size));
+
+  bytes_written += size;
+}
+
+WireCaptureReader::WireCaptureReader(const QString& path) : file(path) {
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    std::cerr << "can't open capture file: " << path.toStdString() << "\n";
+    return;
+  }
+
+  const QByteArray magic = file.read(sizeof(WIRE_MAGIC));
+  valid = magic == QByteArray(WIRE_MAGIC, sizeof(WIRE_MAGIC));
+
+  if (!valid) {
+    std::cerr << "not a capture file: " << path.toStdString() << "\n";
+  }
+}
+
+bool WireCaptureReader::next(QByteArray& data, std::chrono::microseconds& time) {
+  if (!valid) return false;
+
+  uint64_t time_us;
+  uint32_t length;
+
+  if (file.read(reinterpret_cast<char*>(&time_us), sizeof(time_us)) != sizeof(time_us) ||
+      file.read(reinterpret_cast<char*>(&length), sizeof(length)) != sizeof(length)) {
+    return false;
+  }
+
+  data = file.read(length);
+  if (data.size() != static_cast<int>(length)) {
+    std::cerr << "capture file is truncated\n";
+    return false;
+  }
+
+  time = std::chrono::microseconds(time_us);
+  return true;
+}
@@ -0,0 +1,71 @@
+/*  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef WIRE_CAPTURE_HH
+#define WIRE_CAPTURE_HH
+
+#include <QFile>
+#include <QByteArray>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// Raw byte stream received from a solver, as it came off the socket
+/// (i.e. with the solver's own length-prefixed framing), stored as
+///
+///   "CPPWIRE1" then records of  u64:microseconds_since_start u32:length bytes
+///
+/// so that it can be replayed through ReceiverWorker.
+class WireCapture {
+
+  QFile file;
+  std::chrono::steady_clock::time_point start;
+  uint64_t bytes_written = 0;
+
+ public:
+  explicit WireCapture(const QString& path);
+
+  bool isOpen() const { return file.isOpen(); }
+
+  /// Append what was just read from the socket; written straight from
+  /// `data` without copying it into a buffer of our own
+  void append(const char* data, size_t size);
+
+  uint64_t bytesWritten() const { return bytes_written; }
+};
+
+/// Reads back a file written by WireCapture
+class WireCaptureReader {
+
+  QFile file;
+  bool valid = false;
+
+ public:
+  explicit WireCaptureReader(const QString& path);
+
+  bool isValid() const { return valid; }
+
+  /// Next chunk of bytes and when it was received;
+  /// false at the end of the file
+  bool next(QByteArray& data, std::chrono::microseconds& time);
+};
+
+#endif